@@ -53,6 +53,8 @@ NX_GST_RET NX_GSTMP_Open(MP_HANDLE *handle,
  *
  * \brief This is used to set display mode.
  * If the application doesn’t call this API, DISPLAY_MODE_LCD_ONLY is set as default.
+ * With DISPLAY_MODE_NONE the video is not decoded any more, and playback
+ * resumes from the previous keyframe when a display is set again.
  *
  * \param [in]  handle    Movie player handle
  * \param [in]  in_mode   The display mode to set
@@ -98,6 +100,7 @@ NX_GST_RET NX_GSTMP_GetMediaInfo(MP_HANDLE handle, const char* filePath, GST_MED
  * int dspWidth, int dspHeight, struct DSP_RECT rect);
  *
  * \brief This is used to set the display area information according to the each display type.
+ * While the display is linked, the new area is applied from the next rendered frame.
  *
  * \param [in]  handle    Movie player handle
  * \param [in]  type      The display type (ex. DISPLAY_TYPE_PRIMARY, DISPLAY_TYPE_SECONDARY)
@@ -111,6 +114,26 @@ NX_GST_RET NX_GSTMP_GetMediaInfo(MP_HANDLE handle, const char* filePath, GST_MED
 NX_GST_RET NX_GSTMP_SetDisplayInfo(MP_HANDLE handle, enum DISPLAY_TYPE type,
                                     int dspWidth, int dspHeight, struct DSP_RECT rect);
 
+/*!
+ * \fn NX_GST_RET NX_GSTMP_AnimateDisplayRect(MP_HANDLE handle, enum DISPLAY_TYPE type,
+ * struct DSP_RECT rect, int32_t duration_ms);
+ *
+ * \brief This is used to move the display area to 'rect' smoothly (PiP, UI overlay).
+ * The transition is stepped from the player's loop thread and applied with the
+ * rendered frames, so nothing moves on screen while paused.
+ * A new transition or NX_GSTMP_SetDisplayInfo() replaces the running one.
+ *
+ * \param [in]  handle       Movie player handle
+ * \param [in]  type         The display type (ex. DISPLAY_TYPE_PRIMARY, DISPLAY_TYPE_SECONDARY)
+ * \param [in]  rect         Display area at the end of the transition
+ * \param [in]  duration_ms  Duration of the transition
+ *
+ * \retval NX_GST_RET_ERROR On failure.
+ * \retval NX_GST_RET_OK On succee.
+ */
+NX_GST_RET NX_GSTMP_AnimateDisplayRect(MP_HANDLE handle, enum DISPLAY_TYPE type,
+                                    struct DSP_RECT rect, int32_t duration_ms);
+
 /*!
  * \fn void NX_GSTMP_Prepare(MP_HANDLE handle);
  *
@@ -271,6 +294,164 @@ double NX_GSTMP_GetVideoSpeed(MP_HANDLE handle);
  */
 NX_GST_RET NX_GSTMP_SelectStream(MP_HANDLE handle, STREAM_TYPE type, int32_t idx);
 
+/*!
+ * \fn NX_GST_RET NX_GSTMP_SetSwDecoderConfig(MP_HANDLE handle, const struct SW_VDEC_CONFIG *config);
+ *
+ * \brief This is used to configure the software video decoder which SW_V_DECODER
+ * builds use for the streams nxvideodec does not support (FLV, H.265, VP9, Theora).
+ * The loop filter and then B-frames are skipped while the average QoS lateness
+ * of the video sink exceeds the configured thresholds.
+ * It must be called before NX_GSTMP_Prepare().
+ *
+ * \param [in]  handle    Movie player handle
+ * \param [in]  config    Software video decoder settings
+ *
+ * \retval NX_GST_RET_ERROR On failure.
+ * \retval NX_GST_RET_OK On succee.
+ */
+NX_GST_RET NX_GSTMP_SetSwDecoderConfig(MP_HANDLE handle, const struct SW_VDEC_CONFIG *config);
+
+/*!
+ * \fn NX_GST_RET NX_GSTMP_SetExternalSubtitle(MP_HANDLE handle, const char *subtitlePath);
+ *
+ * \brief This is used to load a SRT, SSA/ASS or WebVTT subtitle file.
+ * NX_GSTMP_SetUri() already loads '<media name>.srt/.ass/.ssa/.vtt' when it
+ * exists next to the media file. The external subtitle replaces the embedded
+ * one and is delivered with MP_EVENT_SUBTITLE_UPDATED.
+ *
+ * \param [in]  handle        Movie player handle
+ * \param [in]  subtitlePath  Subtitle file path, NULL to remove the external subtitle
+ *
+ * \retval NX_GST_RET_ERROR On failure.
+ * \retval NX_GST_RET_OK On succee.
+ */
+NX_GST_RET NX_GSTMP_SetExternalSubtitle(MP_HANDLE handle, const char *subtitlePath);
+
+/*!
+ * \fn NX_GST_RET NX_GSTMP_SetSecondaryStandby(MP_HANDLE handle, int32_t enable);
+ *
+ * \brief This is used to keep the secondary display branch (HDMI) built and
+ * in READY while the secondary display is not used, so that
+ * NX_GSTMP_SetDisplayMode() only has to link it when HDMI is plugged in.
+ * The primary display then always goes through the tee.
+ * It must be called before NX_GSTMP_Prepare().
+ *
+ * \param [in]  handle    Movie player handle
+ * \param [in]  enable    1 to keep the secondary branch on standby
+ *
+ * \retval NX_GST_RET_ERROR On failure.
+ * \retval NX_GST_RET_OK On succee.
+ */
+NX_GST_RET NX_GSTMP_SetSecondaryStandby(MP_HANDLE handle, int32_t enable);
+
+/*!
+ * \fn NX_GST_RET NX_GSTMP_GetSecondaryActivationTime(MP_HANDLE handle, int64_t *pUsec);
+ *
+ * \brief This is used to get how long the last link of the secondary display
+ * took, with or without the standby branch.
+ *
+ * \param [in]  handle    Movie player handle
+ * \param [out] pUsec     Activation time in microseconds, 0 if never linked
+ *
+ * \retval NX_GST_RET_ERROR On failure.
+ * \retval NX_GST_RET_OK On succee.
+ */
+NX_GST_RET NX_GSTMP_GetSecondaryActivationTime(MP_HANDLE handle, int64_t *pUsec);
+
+/*!
+ * \fn NX_GST_RET NX_GSTMP_SetSubtitleDelivery(MP_HANDLE handle, enum SUBTITLE_DELIVERY mode);
+ *
+ * \brief This is used to select who owns SUBTITLE_INFO of MP_EVENT_SUBTITLE_UPDATED.
+ * With SUBTITLE_DELIVERY_RING, subtitles are copied into preallocated slots
+ * and no memory is allocated per subtitle. Texts of any length are supported.
+ * SUBTITLE_DELIVERY_ALLOC is the default.
+ *
+ * \param [in]  handle    Movie player handle
+ * \param [in]  mode      SUBTITLE_DELIVERY_ALLOC or SUBTITLE_DELIVERY_RING
+ *
+ * \retval NX_GST_RET_ERROR On failure.
+ * \retval NX_GST_RET_OK On succee.
+ */
+NX_GST_RET NX_GSTMP_SetSubtitleDelivery(MP_HANDLE handle, enum SUBTITLE_DELIVERY mode);
+
+/*!
+ * \fn NX_GST_RET NX_GSTMP_ReleaseSubtitle(MP_HANDLE handle, struct SUBTITLE_INFO *pInfo);
+ *
+ * \brief This is used to return SUBTITLE_INFO received with MP_EVENT_SUBTITLE_UPDATED.
+ * A ring slot is recycled, an allocated SUBTITLE_INFO is freed.
+ * If all ring slots are held by the application, new subtitles are dropped.
+ *
+ * \param [in]  handle    Movie player handle
+ * \param [in]  pInfo     Subtitle information to release
+ *
+ * \retval NX_GST_RET_ERROR On failure.
+ * \retval NX_GST_RET_OK On succee.
+ */
+NX_GST_RET NX_GSTMP_ReleaseSubtitle(MP_HANDLE handle, struct SUBTITLE_INFO *pInfo);
+
+/*!
+ * \fn NX_GST_RET NX_GSTMP_GetEventStats(MP_HANDLE handle, struct MP_EVENT_STATS *pStats);
+ *
+ * \brief This is used to get the statistics of the callback dispatcher.
+ * All the callbacks are delivered from the player's loop thread, never from
+ * GStreamer streaming threads.
+ *
+ * \param [in]  handle    Movie player handle
+ * \param [out] pStats    Queue depth, dropped events and dispatch latency
+ *
+ * \retval NX_GST_RET_ERROR On failure.
+ * \retval NX_GST_RET_OK On succee.
+ */
+NX_GST_RET NX_GSTMP_GetEventStats(MP_HANDLE handle, struct MP_EVENT_STATS *pStats);
+
+/*!
+ * \fn NX_GST_RET NX_GSTMP_SetLoopThreads(int32_t threads);
+ *
+ * \brief This is used to set how many loop threads the player handles share.
+ * Each handle runs its callbacks and subtitle timer on one of them, so a slow
+ * callback delays the other handles on the same thread. Handles prepared
+ * earlier keep their thread. The default is 2.
+ *
+ * \param [in]  threads   Number of loop threads, 1 ~ 8
+ *
+ * \retval NX_GST_RET_ERROR On failure.
+ * \retval NX_GST_RET_OK On succee.
+ */
+NX_GST_RET NX_GSTMP_SetLoopThreads(int32_t threads);
+
+/*!
+ * \fn NX_GST_RET NX_GSTMP_CaptureFrame(MP_HANDLE handle, enum DISPLAY_TYPE type,
+ * int32_t width, const char *outPath);
+ *
+ * \brief This is used to capture the video frame shown on a display.
+ * The frame on screen is taken without reopening the file, then scaled and
+ * converted on a worker thread. MP_EVENT_FRAME_CAPTURED is sent when it is
+ * done, with NX_GST_RET as event data. Without 'outPath' the event param
+ * is a struct CAPTURE_FRAME which the application returns with
+ * NX_GSTMP_ReleaseCapturedFrame(), otherwise the param is NULL.
+ *
+ * \param [in]  handle    Movie player handle
+ * \param [in]  type      The display to capture
+ * \param [in]  width     Width of the image, 0 for the video width.
+ * The height follows the aspect ratio of the video.
+ * \param [in]  outPath   File path of the image (JPEG, or PNG for "*.png"),
+ * NULL to get the image in memory
+ *
+ * \retval NX_GST_RET_ERROR On failure.
+ * \retval NX_GST_RET_OK On succee.
+ */
+NX_GST_RET NX_GSTMP_CaptureFrame(MP_HANDLE handle, enum DISPLAY_TYPE type,
+                                int32_t width, const char *outPath);
+
+/*!
+ * \fn void NX_GSTMP_ReleaseCapturedFrame(struct CAPTURE_FRAME *pFrame);
+ *
+ * \brief This is used to free the image of MP_EVENT_FRAME_CAPTURED.
+ *
+ * \param [in]  pFrame    The event param of MP_EVENT_FRAME_CAPTURED
+ */
+void NX_GSTMP_ReleaseCapturedFrame(struct CAPTURE_FRAME *pFrame);
+
 /*!
  * \fn const char* NX_GSTMP_MakeThumbnail(const gchar *uri, int64_t pos_msec,
  * int32_t width, const char *outPath);
@@ -288,6 +469,342 @@ NX_GST_RET NX_GSTMP_SelectStream(MP_HANDLE handle, STREAM_TYPE type, int32_t idx
 NX_GST_RET NX_GSTMP_MakeThumbnail(const char *uri, int64_t pos_msec,
                         int32_t width, const char *outPath);
 
+/*!
+ * \fn NX_GST_RET NX_GSTMP_MakeThumbnailEx(const char *uri, int64_t pos_msec,
+ * int32_t width, const char *outPath, int32_t flags,
+ * struct THUMBNAIL_RESULT *pResult);
+ *
+ * \brief This is used to make thumbnail for a certain position, with options.
+ *
+ * \param [in]  uri         URI
+ * \param [in]  pos_msec    Video position to make thumbnail
+ * \param [in]  width       Width of thumbnail to create
+ * \param [in]  outPath     File path of thumbnail to create
+ * \param [in]  flags       Combination of THUMBNAIL_FLAG
+ * \param [out] pResult     Details of the thumbnail, can be NULL
+ *
+ * \retval NX_GST_RET_ERROR On failure.
+ * \retval NX_GST_RET_OK On succee.
+ */
+NX_GST_RET NX_GSTMP_MakeThumbnailEx(const char *uri, int64_t pos_msec, int32_t width,
+                        const char *outPath, int32_t flags, struct THUMBNAIL_RESULT *pResult);
+
+/*!
+ * \fn NX_GST_RET NX_GSTMP_MakeThumbnailToBuffer(const char *uri, int64_t pos_msec,
+ * int32_t width, int32_t flags, struct THUMBNAIL_BUFFER *pBuffer,
+ * struct THUMBNAIL_RESULT *pResult);
+ *
+ * \brief This is used to make thumbnail for a certain position in memory.
+ * Nothing is written to the filesystem. RGB565 and ARGB8888 are converted
+ * straight from the decoded picture, JPEG and PNG are encoded in memory.
+ * The thumbnail cache is not used.
+ *
+ * \param [in]  uri         URI
+ * \param [in]  pos_msec    Video position to make thumbnail
+ * \param [in]  width       Width of thumbnail to create
+ * \param [in]  flags       Combination of THUMBNAIL_FLAG
+ * \param [in,out] pBuffer  Format and buffer of the thumbnail. If 'data' is
+ *                          NULL it is allocated, release it with
+ *                          NX_GSTMP_ReleaseThumbnailBuffer().
+ * \param [out] pResult     Details of the thumbnail, can be NULL
+ *
+ * \retval NX_GST_RET_ERROR On failure, 'size' is the size needed if the buffer was too small.
+ * \retval NX_GST_RET_OK On succee.
+ */
+NX_GST_RET NX_GSTMP_MakeThumbnailToBuffer(const char *uri, int64_t pos_msec, int32_t width,
+                        int32_t flags, struct THUMBNAIL_BUFFER *pBuffer,
+                        struct THUMBNAIL_RESULT *pResult);
+
+/*!
+ * \fn void NX_GSTMP_ReleaseThumbnailBuffer(struct THUMBNAIL_BUFFER *pBuffer);
+ *
+ * \brief This is used to free the data allocated by NX_GSTMP_MakeThumbnailToBuffer().
+ *
+ * \param [in]  pBuffer     Thumbnail buffer
+ */
+void NX_GSTMP_ReleaseThumbnailBuffer(struct THUMBNAIL_BUFFER *pBuffer);
+
+/*!
+ * \fn void NX_GSTMP_SetThumbnailCache(const char *cacheDir, int64_t maxDiskBytes,
+ * int64_t maxMemoryBytes);
+ *
+ * \brief This is used to set up the thumbnail cache, disabled by default.
+ * NX_GSTMP_MakeThumbnail(), NX_GSTMP_MakeThumbnailEx() and the thumbnail
+ * services then copy a thumbnail made before for the same file, position,
+ * width, flags and image format to outPath, without decoding anything.
+ * A file modified since is made again.
+ * The least recently used thumbnails are dropped beyond the sizes.
+ *
+ * \param [in]  cacheDir        Directory of the disk cache, NULL for none
+ * \param [in]  maxDiskBytes    Size of the disk cache, 0 for none
+ * \param [in]  maxMemoryBytes  Size of the memory cache, 0 for none
+ */
+void NX_GSTMP_SetThumbnailCache(const char *cacheDir, int64_t maxDiskBytes,
+                        int64_t maxMemoryBytes);
+
+/*!
+ * \fn NX_GST_RET NX_GSTMP_OpenThumbnailService(TH_HANDLE *pHandle);
+ *
+ * \brief This is used to start a thumbnail service.
+ * Its worker thread makes the requested thumbnails one after another, and
+ * keeps the same pipeline for all of them instead of building one per
+ * thumbnail like NX_GSTMP_MakeThumbnail().
+ *
+ * \param [out] pHandle   Thumbnail service handle
+ *
+ * \retval NX_GST_RET_ERROR On failure.
+ * \retval NX_GST_RET_OK On succee.
+ */
+NX_GST_RET NX_GSTMP_OpenThumbnailService(TH_HANDLE *pHandle);
+
+/*!
+ * \fn NX_GST_RET NX_GSTMP_OpenThumbnailServiceEx(TH_HANDLE *pHandle,
+ * int32_t workers, int32_t hwDecoders);
+ *
+ * \brief This is used to start a thumbnail service making several thumbnails
+ * at once. Each of the 'workers' threads (up to 8) keeps its own pipeline.
+ * The hardware decoder has few instances, so only 'hwDecoders' jobs use it
+ * at a time and the other workers decode in software.
+ * NX_GSTMP_OpenThumbnailService() is the same with 1 worker and 1 hardware
+ * decoder.
+ *
+ * \param [out] pHandle     Thumbnail service handle
+ * \param [in]  workers     Number of jobs run in parallel
+ * \param [in]  hwDecoders  Number of jobs using the hardware decoder at once
+ *
+ * \retval NX_GST_RET_ERROR On failure.
+ * \retval NX_GST_RET_OK On succee.
+ */
+NX_GST_RET NX_GSTMP_OpenThumbnailServiceEx(TH_HANDLE *pHandle, int32_t workers,
+                        int32_t hwDecoders);
+
+/*!
+ * \fn int32_t NX_GSTMP_RequestThumbnail(TH_HANDLE handle, const char *uri,
+ * int64_t pos_msec, int32_t width, const char *outPath,
+ * NX_THUMBNAIL_CB cb, void *owner);
+ *
+ * \brief This is used to queue a thumbnail job and returns at once.
+ * 'cb' is called from the worker thread of the service when the thumbnail
+ * is made or failed, it must not block for long.
+ *
+ * \param [in]  handle      Thumbnail service handle
+ * \param [in]  uri         URI
+ * \param [in]  pos_msec    Video position to make thumbnail
+ * \param [in]  width       Width of thumbnail to create
+ * \param [in]  outPath     File path of thumbnail to create
+ * \param [in]  cb          Completion callback of the job, can be NULL
+ * \param [in]  owner       Passed to 'cb'
+ *
+ * \retval -1 On failure.
+ * \retval job id, THUMBNAIL_RESULT.job_id of the callback
+ */
+int32_t NX_GSTMP_RequestThumbnail(TH_HANDLE handle, const char *uri, int64_t pos_msec,
+                        int32_t width, const char *outPath,
+                        NX_THUMBNAIL_CB cb, void *owner);
+
+/*!
+ * \fn int32_t NX_GSTMP_RequestThumbnailEx(TH_HANDLE handle, const char *uri,
+ * int64_t pos_msec, int32_t width, const char *outPath, int32_t priority,
+ * int32_t timeoutMsec, NX_THUMBNAIL_CB cb, void *owner);
+ *
+ * \brief Same as NX_GSTMP_RequestThumbnail() with a priority and a timeout.
+ * The queued jobs run by priority, then in request order, e.g. the visible
+ * items of a list before the ones below. NX_GSTMP_RequestThumbnail() and
+ * NX_GSTMP_RequestThumbnailStrip() use priority 0.
+ * A job running longer than 'timeoutMsec' is completed with
+ * NX_GST_RET_ERROR, so that a broken file does not hold a worker.
+ *
+ * \param [in]  handle      Thumbnail service handle
+ * \param [in]  uri         URI
+ * \param [in]  pos_msec    Video position to make thumbnail
+ * \param [in]  width       Width of thumbnail to create
+ * \param [in]  outPath     File path of thumbnail to create
+ * \param [in]  priority    Higher runs first
+ * \param [in]  timeoutMsec Longest run of the job, 0 for no limit
+ * \param [in]  cb          Completion callback of the job, can be NULL
+ * \param [in]  owner       Passed to 'cb'
+ *
+ * \retval -1 On failure.
+ * \retval job id, THUMBNAIL_RESULT.job_id of the callback
+ */
+int32_t NX_GSTMP_RequestThumbnailEx(TH_HANDLE handle, const char *uri, int64_t pos_msec,
+                        int32_t width, const char *outPath, int32_t priority,
+                        int32_t timeoutMsec, NX_THUMBNAIL_CB cb, void *owner);
+
+/*!
+ * \fn int32_t NX_GSTMP_RequestThumbnailStrip(TH_HANDLE handle, const char *uri,
+ * const int64_t *pos_msec, int32_t count, int32_t width,
+ * const char *spritePath, NX_THUMBNAIL_CB cb, void *owner);
+ *
+ * \brief This is used to queue a job making thumbnails at several positions
+ * of a file (chapters, scrubber) in one decode pass.
+ * The file is opened once and the positions are visited in ascending order
+ * with keyframe seeks. 'cb' receives each frame as it is decoded, with
+ * THUMBNAIL_RESULT.index set to its index in 'pos_msec', then once more
+ * with index -1 when the job is done.
+ * With 'spritePath', the frames are also packed in rows of 10 tiles into
+ * one image, and "<spritePath>.vtt" gives the area of each tile as a
+ * WebVTT thumbnail track ("sprite.jpg#xywh=x,y,w,h").
+ *
+ * \param [in]  handle      Thumbnail service handle
+ * \param [in]  uri         URI
+ * \param [in]  pos_msec    Video positions, in any order
+ * \param [in]  count       Number of positions
+ * \param [in]  width       Width of each thumbnail
+ * \param [in]  spritePath  File path of the sprite sheet, NULL for none
+ * \param [in]  cb          Callback of the frames and the job completion
+ * \param [in]  owner       Passed to 'cb'
+ *
+ * \retval -1 On failure.
+ * \retval job id, THUMBNAIL_RESULT.job_id of the callback
+ */
+int32_t NX_GSTMP_RequestThumbnailStrip(TH_HANDLE handle, const char *uri,
+                        const int64_t *pos_msec, int32_t count, int32_t width,
+                        const char *spritePath, NX_THUMBNAIL_CB cb, void *owner);
+
+/*!
+ * \fn int32_t NX_GSTMP_RequestPreviewTrack(TH_HANDLE handle, const char *uri,
+ * int32_t intervalMsec, int32_t width, const char *trackPath,
+ * NX_THUMBNAIL_CB cb, void *owner);
+ *
+ * \brief This is used to queue a job making the preview track of a file,
+ * the small images shown over the seek bar while it is dragged.
+ * The keyframes at every 'intervalMsec' of the file are decoded at a reduced
+ * resolution and stored as JPEG in one file along with a table of their
+ * positions, see NX_GSTMP_OpenPreviewTrack(). The job is queued behind the
+ * thumbnails of priority 0, and does nothing if 'trackPath' is already the
+ * track of the file. 'cb' is called once with THUMBNAIL_RESULT.index -1.
+ *
+ * \param [in]  handle        Thumbnail service handle
+ * \param [in]  uri           URI
+ * \param [in]  intervalMsec  Time between two images, e.g. 10000
+ * \param [in]  width         Width of the images
+ * \param [in]  trackPath     File path of the preview track
+ * \param [in]  cb            Completion callback of the job, can be NULL
+ * \param [in]  owner         Passed to 'cb'
+ *
+ * \retval -1 On failure.
+ * \retval job id, THUMBNAIL_RESULT.job_id of the callback
+ */
+int32_t NX_GSTMP_RequestPreviewTrack(TH_HANDLE handle, const char *uri,
+                        int32_t intervalMsec, int32_t width, const char *trackPath,
+                        NX_THUMBNAIL_CB cb, void *owner);
+
+/*!
+ * \fn NX_GST_RET NX_GSTMP_OpenPreviewTrack(const char *trackPath, PV_HANDLE *pHandle);
+ *
+ * \brief This is used to map a preview track made by
+ * NX_GSTMP_RequestPreviewTrack(), to show its images while seeking.
+ *
+ * \param [in]  trackPath File path of the preview track
+ * \param [out] pHandle   Preview track handle
+ *
+ * \retval NX_GST_RET_ERROR On failure, or the file is not a preview track.
+ * \retval NX_GST_RET_OK On succee.
+ */
+NX_GST_RET NX_GSTMP_OpenPreviewTrack(const char *trackPath, PV_HANDLE *pHandle);
+
+/*!
+ * \fn NX_GST_RET NX_GSTMP_GetPreviewImage(PV_HANDLE handle, int64_t pos_msec,
+ * struct PREVIEW_IMAGE *pImage);
+ *
+ * \brief This is used to get the image of a preview track nearest to a
+ * position. It is a table lookup in the mapped file, nothing is decoded or
+ * copied, so it can be called on every move of the seek bar.
+ *
+ * \param [in]  handle    Preview track handle
+ * \param [in]  pos_msec  Video position
+ * \param [out] pImage    JPEG image, valid until NX_GSTMP_ClosePreviewTrack()
+ *
+ * \retval NX_GST_RET_ERROR On failure.
+ * \retval NX_GST_RET_OK On succee.
+ */
+NX_GST_RET NX_GSTMP_GetPreviewImage(PV_HANDLE handle, int64_t pos_msec,
+                        struct PREVIEW_IMAGE *pImage);
+
+/*!
+ * \fn void NX_GSTMP_ClosePreviewTrack(PV_HANDLE handle);
+ *
+ * \brief This is used to unmap a preview track.
+ *
+ * \param [in]  handle    Preview track handle
+ */
+void NX_GSTMP_ClosePreviewTrack(PV_HANDLE handle);
+
+/*!
+ * \fn NX_GST_RET NX_GSTMP_SetThumbnailFlags(TH_HANDLE handle, int32_t flags);
+ *
+ * \brief This is used to set the options of the thumbnails requested afterwards.
+ *
+ * \param [in]  handle    Thumbnail service handle
+ * \param [in]  flags     Combination of THUMBNAIL_FLAG, 0 by default
+ *
+ * \retval NX_GST_RET_ERROR On failure.
+ * \retval NX_GST_RET_OK On succee.
+ */
+NX_GST_RET NX_GSTMP_SetThumbnailFlags(TH_HANDLE handle, int32_t flags);
+
+/*!
+ * \fn NX_GST_RET NX_GSTMP_SetThumbnailPriority(TH_HANDLE handle,
+ * int32_t jobId, int32_t priority);
+ *
+ * \brief This is used to change the priority of a queued job, e.g. when
+ * its item scrolls into view.
+ *
+ * \param [in]  handle    Thumbnail service handle
+ * \param [in]  jobId     Job id returned by the request
+ * \param [in]  priority  Higher runs first
+ *
+ * \retval NX_GST_RET_ERROR On failure, or the job is not queued anymore.
+ * \retval NX_GST_RET_OK On succee.
+ */
+NX_GST_RET NX_GSTMP_SetThumbnailPriority(TH_HANDLE handle, int32_t jobId, int32_t priority);
+
+/*!
+ * \fn NX_GST_RET NX_GSTMP_CancelThumbnail(TH_HANDLE handle, int32_t jobId);
+ *
+ * \brief This is used to cancel a job. A queued job is completed with
+ * NX_GST_RET_ERROR at once, a running one stops at its next wait and is
+ * completed the same way by its worker.
+ *
+ * \param [in]  handle    Thumbnail service handle
+ * \param [in]  jobId     Job id returned by the request
+ *
+ * \retval NX_GST_RET_ERROR On failure, or the job is already completed.
+ * \retval NX_GST_RET_OK On succee.
+ */
+NX_GST_RET NX_GSTMP_CancelThumbnail(TH_HANDLE handle, int32_t jobId);
+
+/*!
+ * \fn void NX_GSTMP_CloseThumbnailService(TH_HANDLE handle);
+ *
+ * \brief This is used to stop a thumbnail service.
+ * The jobs in progress are finished, the queued ones are completed with
+ * NX_GST_RET_ERROR.
+ *
+ * \param [in]  handle    Thumbnail service handle
+ */
+void NX_GSTMP_CloseThumbnailService(TH_HANDLE handle);
+
+/*!
+ * \fn NX_GST_RET NX_GSTMP_SetLogLevel(const char *tag, int32_t level);
+ *
+ * \brief This is used to change the log level of a module at runtime, e.g.
+ * "NX_GstThumbnail" or "NxGstMediaInfo" (the brackets of the log lines are
+ * optional). Logs above the level cost a load and a branch.
+ * The levels at startup come from the NX_GST_LOG_LEVEL environment variable,
+ * a list of a default level and of "tag:level", e.g.
+ * "warn,NX_GstThumbnail:debug".
+ *
+ * \param [in]  tag       Module, NULL for the default of the modules without
+ *                        a level of their own
+ * \param [in]  level     NX_GST_LOG_LEVEL
+ *
+ * \retval NX_GST_RET_ERROR On failure.
+ * \retval NX_GST_RET_OK On succee.
+ */
+NX_GST_RET NX_GSTMP_SetLogLevel(const char *tag, int32_t level);
+
 #ifdef __cplusplus
 }
 #endif
@@ -25,6 +25,8 @@
 #define MAX_TRACK_NUM		10
 
 typedef struct MOVIE_TYPE	*MP_HANDLE;
+typedef struct THUMBNAIL_SERVICE	*TH_HANDLE;
+typedef struct PREVIEW_TRACK	*PV_HANDLE;
 
 /*! \enum NX_GST_EVENT
  * \brief Describes the event types */
@@ -44,9 +46,14 @@ enum NX_GST_EVENT {
     /*! \brief Subtitle is updated */
     MP_EVENT_SUBTITLE_UPDATED,
     /*! \brief Unknown error   */
-    MP_EVENT_UNKNOWN
+    MP_EVENT_UNKNOWN,
+    /*! \brief NX_GSTMP_CaptureFrame() is done */
+    MP_EVENT_FRAME_CAPTURED
 };
 
+/*! \brief Number of the event types */
+#define MP_EVENT_TYPE_NUM   (MP_EVENT_FRAME_CAPTURED + 1)
+
 /*! \enum NX_GST_RET
  * \brief Describes the return result */
 typedef enum {
@@ -56,6 +63,19 @@ typedef enum {
     NX_GST_RET_OK
 } NX_GST_RET;
 
+/*! \enum NX_GST_LOG_LEVEL
+ * \brief Log levels, each one includes the ones before it */
+enum NX_GST_LOG_LEVEL {
+    NX_GST_LOG_NONE = 0,
+    NX_GST_LOG_ERROR,
+    NX_GST_LOG_WARN,
+    NX_GST_LOG_INFO,
+    /*! \brief Only in the DEBUG builds */
+    NX_GST_LOG_DEBUG,
+    /*! \brief Only in the DEBUG builds with VBS_MSG */
+    NX_GST_LOG_VERBOSE,
+};
+
 enum NX_GST_ERROR
 {
     NX_GST_ERROR_NONE,
@@ -117,6 +137,160 @@ struct SUBTITLE_INFO {
     gchar*	subtitleText;
 };
 
+/*! \struct CAPTURE_FRAME
+ * \brief Describes a video frame captured by NX_GSTMP_CaptureFrame(), packed RGB 24 bits */
+struct CAPTURE_FRAME {
+    /*! \brief Position of the frame in nanoseconds, -1 if unknown */
+    int64_t     pts;
+    int32_t     width;
+    int32_t     height;
+    /*! \brief Bytes per line */
+    int32_t     stride;
+    /*! \brief stride x height bytes */
+    uint8_t     *data;
+};
+
+/*! \enum THUMBNAIL_FLAG
+ * \brief Options of the thumbnails, may be combined */
+enum THUMBNAIL_FLAG {
+    /*! \brief Decode keyframes only, at a reduced resolution if the decoder supports it */
+    THUMBNAIL_FLAG_FAST_DECODE = 1,
+    /*! \brief Skip black or flat frames, trying the next keyframes for a while */
+    THUMBNAIL_FLAG_SKIP_FLAT = 2,
+    /*! \brief Score a few keyframes around the position and keep the most detailed
+     *  one that is not a transition. Bounded to about a second. */
+    THUMBNAIL_FLAG_BEST_FRAME = 4,
+    /*! \brief Use the cover art or the preview image embedded in the file if it has
+     *  one, instead of a frame of the video */
+    THUMBNAIL_FLAG_EMBEDDED_IMAGE = 8,
+};
+
+/*! \struct THUMBNAIL_RESULT
+ * \brief Describes a finished job of the thumbnail service */
+struct THUMBNAIL_RESULT {
+    /*! \brief Returned by NX_GSTMP_RequestThumbnail() */
+    int32_t     job_id;
+    NX_GST_RET  ret;
+    /*! \brief File path of the thumbnail */
+    const char  *outPath;
+    /*! \brief Position of the frame in msec, the keyframe at or before the requested one,
+     *  or another one with THUMBNAIL_FLAG_SKIP_FLAT or THUMBNAIL_FLAG_BEST_FRAME.
+     *  -1 for an embedded image. */
+    int64_t     pos_msec;
+    /*! \brief Keyframes tried after the first one, with THUMBNAIL_FLAG_SKIP_FLAT
+     *  or THUMBNAIL_FLAG_BEST_FRAME */
+    int32_t     retries;
+    /*! \brief Strip jobs: index of the position for a frame, -1 for the completion of the job */
+    int32_t     index;
+    /*! \brief Strip jobs: the frame of 'index', only valid during the callback */
+    const struct CAPTURE_FRAME *frame;
+};
+
+/*! \enum THUMBNAIL_FORMAT
+ * \brief Formats of the thumbnails made in memory */
+enum THUMBNAIL_FORMAT {
+    /*! \brief 16 bits words, native endian */
+    THUMBNAIL_FORMAT_RGB565,
+    /*! \brief 32 bits words 0xAARRGGBB, native endian, opaque */
+    THUMBNAIL_FORMAT_ARGB8888,
+    THUMBNAIL_FORMAT_JPEG,
+    THUMBNAIL_FORMAT_PNG,
+};
+
+/*! \struct THUMBNAIL_BUFFER
+ * \brief Describes a thumbnail made by NX_GSTMP_MakeThumbnailToBuffer() */
+struct THUMBNAIL_BUFFER {
+    /*! \brief [in] Format of the thumbnail */
+    enum THUMBNAIL_FORMAT format;
+    /*! \brief [in] Buffer of the caller, or NULL to have one allocated,
+     *  released with NX_GSTMP_ReleaseThumbnailBuffer() */
+    uint8_t     *data;
+    /*! \brief [in] Size of the buffer of the caller.
+     *  [out] Bytes of the thumbnail, or the size needed if the buffer was too small */
+    int32_t     size;
+    int32_t     width;
+    int32_t     height;
+    /*! \brief Bytes per line of RGB565 and ARGB8888, width x bytes per pixel */
+    int32_t     stride;
+};
+
+/*! \struct PREVIEW_IMAGE
+ * \brief Describes an image of a preview track, returned by NX_GSTMP_GetPreviewImage() */
+struct PREVIEW_IMAGE {
+    /*! \brief THUMBNAIL_FORMAT_JPEG */
+    enum THUMBNAIL_FORMAT format;
+    /*! \brief In the mapped track file, valid until NX_GSTMP_ClosePreviewTrack() */
+    const uint8_t *data;
+    int32_t     size;
+    /*! \brief Position of the frame in msec, the keyframe at or before its interval */
+    int64_t     pos_msec;
+    int32_t     width;
+    int32_t     height;
+};
+
+/*! \brief Called from the thread of the thumbnail service once a job is done */
+typedef void (*NX_THUMBNAIL_CB)(void *owner, const struct THUMBNAIL_RESULT *result);
+
+/*! \enum SW_VDEC_THREAD
+ * \brief Threading modes of the software video decoder, may be combined */
+enum SW_VDEC_THREAD {
+    SW_VDEC_THREAD_AUTO = 0,
+    SW_VDEC_THREAD_FRAME = 1,
+    SW_VDEC_THREAD_SLICE = 2,
+};
+
+/*! \struct SW_VDEC_CONFIG
+ * \brief Software video decoder settings, used by SW_V_DECODER builds */
+struct SW_VDEC_CONFIG {
+    /*! \brief Number of decoding threads, 0 for one per CPU core */
+    int32_t threads;
+    /*! \brief Combination of SW_VDEC_THREAD */
+    int32_t thread_type;
+    /*! \brief Average lateness (ms) from which the loop filter is skipped, 0 to never skip */
+    int32_t skip_loop_filter_lateness;
+    /*! \brief Average lateness (ms) from which B-frames are skipped, 0 to never skip */
+    int32_t skip_frame_lateness;
+    /*! \brief Decode in software even if nxvideodec supports the stream */
+    int32_t force_sw;
+    /*! \brief Largest picture sent to nxvideosink, bigger pictures are downscaled */
+    int32_t max_width;
+    int32_t max_height;
+};
+
+/*! \enum SUBTITLE_DELIVERY
+ * \brief Describes how SUBTITLE_INFO of MP_EVENT_SUBTITLE_UPDATED is owned */
+enum SUBTITLE_DELIVERY {
+    /*! \brief Allocated per subtitle, the application frees subtitleText and SUBTITLE_INFO */
+    SUBTITLE_DELIVERY_ALLOC = 0,
+    /*! \brief Borrowed from a preallocated ring, the application returns it
+     * with NX_GSTMP_ReleaseSubtitle() */
+    SUBTITLE_DELIVERY_RING  = 1
+};
+
+/*! \struct MP_EVENT_STATS
+ * \brief Describes the statistics of the callback dispatcher */
+struct MP_EVENT_STATS {
+    /*! \brief Number of events waiting to be delivered */
+    int32_t     queue_depth;
+    /*! \brief The highest queue depth observed */
+    int32_t     max_queue_depth;
+    /*! \brief Total number of delivered events */
+    int64_t     dispatched;
+    /*! \brief Number of events dropped since the queue was full.
+     * Only MP_EVENT_SUBTITLE_UPDATED is ever dropped. */
+    int64_t     dropped;
+    /*! \brief 'dropped' of each event type, indexed by NX_GST_EVENT */
+    int64_t     dropped_by_type[MP_EVENT_TYPE_NUM];
+    /*! \brief Number of events kept aside until the full queue drained */
+    int64_t     overflowed;
+    /*! \brief Dispatch latency of the last event in microseconds */
+    int64_t     last_latency_us;
+    /*! \brief The highest dispatch latency in microseconds */
+    int64_t     max_latency_us;
+    /*! \brief Average dispatch latency in microseconds */
+    int64_t     avg_latency_us;
+};
+
 /*! \enum DISPLAY_MODE
  * \brief Describes the display mode */
 enum DISPLAY_MODE {
@@ -216,6 +390,8 @@ typedef enum {
     VIDEO_TYPE_WMV,
     /*! \brief Theora */
     VIDEO_TYPE_THEORA,
+    /*! \brief VP9 */
+    VIDEO_TYPE_VP9,
 } VIDEO_TYPE;
 
 typedef enum {
@@ -235,6 +411,8 @@ typedef enum {
 	AUDIO_TYPE_DTS,
 	AUDIO_TYPE_DTS_PRI,
 	AUDIO_TYPE_WAV,
+	AUDIO_TYPE_EAC3,
+	AUDIO_TYPE_OPUS,
 } AUDIO_TYPE;
 
 typedef enum {
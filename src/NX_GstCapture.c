@@ -0,0 +1,423 @@
+//------------------------------------------------------------------------------
+//
+//	Copyright (C) 2015 Nexell Co. All Rights Reserved
+//	Nexell Co. Proprietary & Confidential
+//
+//	NEXELL INFORMS THAT THIS CODE AND INFORMATION IS PROVIDED "AS IS" BASE
+//  AND	WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING
+//  BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS
+//  FOR A PARTICULAR PURPOSE.
+//
+//	Module		: libnxgstvplayer.so
+//	File		: NX_GstCapture.c
+//	Description	: Conversion of decoded video frames to RGB images
+//	Author		:
+//	Export		:
+//	History		:
+//
+//------------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#include "NX_GstCapture.h"
+#include "NX_GstColorConvert.h"
+#include "NX_GstLog.h"
+#define LOG_TAG "[NX_GstCapture]"
+
+/* 4:2:0 pictures, the formats of the video decoders, go through the SIMD
+ * kernels of NX_GstColorConvert.c, anything else through GstVideoConverter */
+static gboolean scale_yuv420(const GstVideoFrame *in_frame, NX_RGB_FORMAT format,
+                            guint8 *dst, gint dst_stride, gint width, gint height)
+{
+    NX_YUV_PLANES src;
+
+    switch (GST_VIDEO_FRAME_FORMAT(in_frame))
+    {
+        case GST_VIDEO_FORMAT_I420:
+        case GST_VIDEO_FORMAT_YV12:
+            src.v = (const guint8 *)GST_VIDEO_FRAME_COMP_DATA(in_frame, 2);
+            src.v_stride = GST_VIDEO_FRAME_COMP_STRIDE(in_frame, 2);
+            src.u = (const guint8 *)GST_VIDEO_FRAME_COMP_DATA(in_frame, 1);
+            src.swap_uv = FALSE;
+            break;
+        case GST_VIDEO_FORMAT_NV12:
+        case GST_VIDEO_FORMAT_NV21:
+            src.v = NULL;
+            src.v_stride = 0;
+            src.u = (const guint8 *)GST_VIDEO_FRAME_PLANE_DATA(in_frame, 1);
+            src.swap_uv = (GST_VIDEO_FORMAT_NV21 == GST_VIDEO_FRAME_FORMAT(in_frame));
+            break;
+        default:
+            return FALSE;
+    }
+    src.u_stride = GST_VIDEO_FRAME_COMP_STRIDE(in_frame, 1);
+    src.width = GST_VIDEO_FRAME_WIDTH(in_frame);
+    src.height = GST_VIDEO_FRAME_HEIGHT(in_frame);
+    src.y = (const guint8 *)GST_VIDEO_FRAME_COMP_DATA(in_frame, 0);
+    src.y_stride = GST_VIDEO_FRAME_COMP_STRIDE(in_frame, 0);
+
+    NX_ScaleYUVToRGB(&src, dst, dst_stride, width, height, format);
+
+    return TRUE;
+}
+
+// The GStreamer format of the same memory layout as 'format'
+static GstVideoFormat video_format(NX_RGB_FORMAT format)
+{
+    switch (format)
+    {
+        case NX_RGB_FORMAT_RGB565:
+            return GST_VIDEO_FORMAT_RGB16;
+        case NX_RGB_FORMAT_ARGB8888:
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+            return GST_VIDEO_FORMAT_BGRA;
+#else
+            return GST_VIDEO_FORMAT_ARGB;
+#endif
+        default:
+            return GST_VIDEO_FORMAT_RGB;
+    }
+}
+
+gboolean NX_SampleOutputSize(GstSample *sample, gint width, gint *out_width, gint *out_height)
+{
+    GstCaps *caps = gst_sample_get_caps(sample);
+    GstVideoInfo info;
+
+    if (!caps || !gst_video_info_from_caps(&info, caps))
+    {
+        NXGLOGE("Not a raw video sample");
+        return FALSE;
+    }
+
+    if (width <= 0) {
+        width = GST_VIDEO_INFO_WIDTH(&info);
+    }
+    // Square pixels with the display aspect ratio of the source
+    *out_width = width;
+    *out_height = (gint)gst_util_uint64_scale_int(width,
+                GST_VIDEO_INFO_HEIGHT(&info) * GST_VIDEO_INFO_PAR_D(&info),
+                GST_VIDEO_INFO_WIDTH(&info) * GST_VIDEO_INFO_PAR_N(&info));
+    *out_height = MAX(*out_height, 1);
+
+    return TRUE;
+}
+
+gboolean NX_ConvertSampleInto(GstSample *sample, NX_RGB_FORMAT format, guint8 *dst,
+                            gint dst_stride, gint width, gint height)
+{
+    GstCaps *caps = gst_sample_get_caps(sample);
+    GstBuffer *buffer = gst_sample_get_buffer(sample);
+    GstVideoInfo in_info, out_info;
+    GstVideoFrame in_frame, out_frame;
+    GstVideoConverter *convert;
+    GstBuffer *out_buffer;
+    gsize size = (gsize)dst_stride * height;
+
+    if (!caps || !buffer || !gst_video_info_from_caps(&in_info, caps))
+    {
+        NXGLOGE("Not a raw video sample");
+        return FALSE;
+    }
+
+    if (!gst_video_frame_map(&in_frame, &in_info, buffer, GST_MAP_READ))
+    {
+        NXGLOGE("Failed to map the video frame");
+        return FALSE;
+    }
+    if (!scale_yuv420(&in_frame, format, dst, dst_stride, width, height))
+    {
+        gst_video_info_set_format(&out_info, video_format(format), width, height);
+        GST_VIDEO_INFO_PLANE_STRIDE(&out_info, 0) = dst_stride;
+        GST_VIDEO_INFO_SIZE(&out_info) = size;
+
+        // Converted straight into 'dst', the buffer does not own it
+        out_buffer = gst_buffer_new_wrapped_full((GstMemoryFlags)0, dst, size, 0, size,
+                        NULL, NULL);
+        if (!gst_video_frame_map(&out_frame, &out_info, out_buffer, GST_MAP_WRITE))
+        {
+            NXGLOGE("Failed to map the output frame");
+            gst_buffer_unref(out_buffer);
+            gst_video_frame_unmap(&in_frame);
+            return FALSE;
+        }
+
+        convert = gst_video_converter_new(&in_info, &out_info, NULL);
+        if (NULL == convert)
+        {
+            NXGLOGE("Unsupported conversion from %s",
+                    gst_video_format_to_string(GST_VIDEO_INFO_FORMAT(&in_info)));
+            gst_video_frame_unmap(&out_frame);
+            gst_buffer_unref(out_buffer);
+            gst_video_frame_unmap(&in_frame);
+            return FALSE;
+        }
+        gst_video_converter_frame(convert, &in_frame, &out_frame);
+        gst_video_converter_free(convert);
+
+        gst_video_frame_unmap(&out_frame);
+        gst_buffer_unref(out_buffer);
+    }
+    gst_video_frame_unmap(&in_frame);
+
+    NXGLOGI("%dx%d %s -> %dx%d %s", GST_VIDEO_INFO_WIDTH(&in_info),
+            GST_VIDEO_INFO_HEIGHT(&in_info),
+            gst_video_format_to_string(GST_VIDEO_INFO_FORMAT(&in_info)),
+            width, height, gst_video_format_to_string(video_format(format)));
+
+    return TRUE;
+}
+
+struct CAPTURE_FRAME *NX_ConvertSample(GstSample *sample, gint width)
+{
+    GstBuffer *buffer = gst_sample_get_buffer(sample);
+    const GstSegment *segment = gst_sample_get_segment(sample);
+    struct CAPTURE_FRAME *frame;
+    gint height;
+
+    if (!buffer || !NX_SampleOutputSize(sample, width, &width, &height))
+        return NULL;
+
+    frame = g_new0(struct CAPTURE_FRAME, 1);
+    frame->width = width;
+    frame->height = height;
+    // Rows aligned to 4 bytes, like the GdkPixbuf ones
+    frame->stride = GST_ROUND_UP_4(width * 3);
+    frame->data = (uint8_t *)g_try_malloc((gsize)frame->stride * height);
+    frame->pts = -1;
+    if (GST_BUFFER_PTS_IS_VALID(buffer) && segment) {
+        frame->pts = (int64_t)gst_segment_to_stream_time(segment, GST_FORMAT_TIME,
+                                    GST_BUFFER_PTS(buffer));
+    }
+    if (NULL == frame->data)
+    {
+        NXGLOGE("Failed to alloc %d bytes", frame->stride * height);
+        g_free(frame);
+        return NULL;
+    }
+
+    if (!NX_ConvertSampleInto(sample, NX_RGB_FORMAT_RGB888, frame->data, frame->stride,
+                            width, height))
+    {
+        NX_FreeCapturedFrame(frame);
+        return NULL;
+    }
+
+    return frame;
+}
+
+static void on_size_prepared(GdkPixbufLoader *loader, gint width, gint height,
+                            gpointer data)
+{
+    gint target = GPOINTER_TO_INT(data);
+
+    // JPEG is scaled down while it is decoded
+    if (target > 0 && target != width) {
+        gdk_pixbuf_loader_set_size(loader, target,
+                    MAX((gint)gst_util_uint64_scale_int(height, target, width), 1));
+    }
+}
+
+struct CAPTURE_FRAME *NX_ConvertImageSample(GstSample *image, gint width)
+{
+    GstBuffer *buffer = gst_sample_get_buffer(image);
+    GdkPixbufLoader *loader;
+    GdkPixbuf *pixbuf;
+    GError *error = NULL;
+    GstMapInfo map;
+    struct CAPTURE_FRAME *frame;
+    const guint8 *pixels;
+    gint channels, rowstride;
+    gboolean res;
+
+    if (!buffer || !gst_buffer_map(buffer, &map, GST_MAP_READ))
+        return NULL;
+
+    loader = gdk_pixbuf_loader_new();
+    g_signal_connect(loader, "size-prepared", G_CALLBACK(on_size_prepared),
+                    GINT_TO_POINTER(width));
+    res = gdk_pixbuf_loader_write(loader, map.data, map.size, &error);
+    res = gdk_pixbuf_loader_close(loader, res ? &error : NULL) && res;
+    gst_buffer_unmap(buffer, &map);
+
+    pixbuf = res ? gdk_pixbuf_loader_get_pixbuf(loader) : NULL;
+    if (NULL == pixbuf || GDK_COLORSPACE_RGB != gdk_pixbuf_get_colorspace(pixbuf) ||
+        8 != gdk_pixbuf_get_bits_per_sample(pixbuf))
+    {
+        NXGLOGE("Failed to decode the image: %s", error ? error->message : "unsupported");
+        g_clear_error(&error);
+        g_object_unref(loader);
+        return NULL;
+    }
+
+    frame = g_new0(struct CAPTURE_FRAME, 1);
+    frame->pts = -1;
+    frame->width = gdk_pixbuf_get_width(pixbuf);
+    frame->height = gdk_pixbuf_get_height(pixbuf);
+    frame->stride = GST_ROUND_UP_4(frame->width * 3);
+    frame->data = (uint8_t *)g_try_malloc((gsize)frame->stride * frame->height);
+    if (NULL == frame->data)
+    {
+        NXGLOGE("Failed to alloc %d bytes", frame->stride * frame->height);
+        g_free(frame);
+        g_object_unref(loader);
+        return NULL;
+    }
+
+    // The alpha of a PNG is dropped
+    pixels = gdk_pixbuf_get_pixels(pixbuf);
+    channels = gdk_pixbuf_get_n_channels(pixbuf);
+    rowstride = gdk_pixbuf_get_rowstride(pixbuf);
+    for (gint j = 0; j < frame->height; j++)
+    {
+        const guint8 *in = pixels + (gsize)j * rowstride;
+        guint8 *out = frame->data + (gsize)j * frame->stride;
+
+        for (gint i = 0; i < frame->width; i++)
+        {
+            out[3 * i] = in[channels * i];
+            out[3 * i + 1] = in[channels * i + 1];
+            out[3 * i + 2] = in[channels * i + 2];
+        }
+    }
+    g_object_unref(loader);
+
+    NXGLOGI("image -> %dx%d RGB", frame->width, frame->height);
+
+    return frame;
+}
+
+gboolean NX_SaveCapturedFrame(const struct CAPTURE_FRAME *frame, const gchar *path)
+{
+    const gchar *type = g_str_has_suffix(path, ".png") ? "png" : "jpeg";
+    GError *error = NULL;
+    GdkPixbuf *pixbuf;
+    gboolean res;
+
+    pixbuf = gdk_pixbuf_new_from_data(frame->data, GDK_COLORSPACE_RGB, FALSE, 8,
+                frame->width, frame->height, frame->stride, NULL, NULL);
+    res = gdk_pixbuf_save(pixbuf, path, type, &error, NULL);
+    g_object_unref(pixbuf);
+
+    if (!res)
+    {
+        NXGLOGE("Failed to save %s: %s", path, error ? error->message : "");
+        g_clear_error(&error);
+    }
+
+    return res;
+}
+
+gboolean NX_EncodeCapturedFrame(const struct CAPTURE_FRAME *frame, const gchar *type,
+                            gchar **buffer, gsize *size)
+{
+    GError *error = NULL;
+    GdkPixbuf *pixbuf;
+    gboolean res;
+
+    pixbuf = gdk_pixbuf_new_from_data(frame->data, GDK_COLORSPACE_RGB, FALSE, 8,
+                frame->width, frame->height, frame->stride, NULL, NULL);
+    res = gdk_pixbuf_save_to_buffer(pixbuf, buffer, size, type, &error, NULL);
+    g_object_unref(pixbuf);
+
+    if (!res)
+    {
+        NXGLOGE("Failed to encode %s: %s", type, error ? error->message : "");
+        g_clear_error(&error);
+    }
+
+    return res;
+}
+
+void NX_FreeCapturedFrame(struct CAPTURE_FRAME *frame)
+{
+    if (NULL == frame)
+        return;
+
+    g_free(frame->data);
+    g_free(frame);
+}
+
+// Maps the frame of 'sample' if its luma is 8 bits, one byte per pixel
+static gboolean map_luma(GstSample *sample, GstVideoFrame *frame)
+{
+    GstCaps *caps = gst_sample_get_caps(sample);
+    GstBuffer *buffer = gst_sample_get_buffer(sample);
+    GstVideoInfo info;
+
+    if (!caps || !buffer || !gst_video_info_from_caps(&info, caps))
+        return FALSE;
+
+    if (!GST_VIDEO_INFO_IS_YUV(&info) ||
+        GST_VIDEO_INFO_COMP_DEPTH(&info, 0) != 8 ||
+        GST_VIDEO_INFO_COMP_PSTRIDE(&info, 0) != 1)
+    {
+        return FALSE;
+    }
+
+    if (!gst_video_frame_map(frame, &info, buffer, GST_MAP_READ))
+    {
+        NXGLOGE("Failed to map the video frame");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+// About 128 rows are plenty to tell a flat or a detailed picture
+#define LUMA_ROW_STEP(frame)    MAX(GST_VIDEO_FRAME_HEIGHT(frame) / 128, 1)
+
+gboolean NX_SampleLumaStats(GstSample *sample, guint *mean, guint *variance)
+{
+    GstVideoFrame frame;
+
+    if (!map_luma(sample, &frame))
+        return FALSE;
+
+    NX_LumaStats((const guint8 *)GST_VIDEO_FRAME_COMP_DATA(&frame, 0),
+                GST_VIDEO_FRAME_COMP_STRIDE(&frame, 0),
+                GST_VIDEO_FRAME_WIDTH(&frame), GST_VIDEO_FRAME_HEIGHT(&frame),
+                LUMA_ROW_STEP(&frame), mean, variance);
+    gst_video_frame_unmap(&frame);
+
+    return TRUE;
+}
+
+gboolean NX_SampleLumaFeatures(GstSample *sample, GstSample *previous,
+                            NX_LUMA_FEATURES *features)
+{
+    GstVideoFrame frame, prev_frame;
+    gboolean has_prev = FALSE;
+
+    if (!map_luma(sample, &frame))
+        return FALSE;
+
+    if (previous && map_luma(previous, &prev_frame))
+    {
+        has_prev = (GST_VIDEO_FRAME_WIDTH(&prev_frame) == GST_VIDEO_FRAME_WIDTH(&frame) &&
+                    GST_VIDEO_FRAME_HEIGHT(&prev_frame) == GST_VIDEO_FRAME_HEIGHT(&frame));
+        if (!has_prev) {
+            gst_video_frame_unmap(&prev_frame);
+        }
+    }
+
+    NX_LumaFeatures((const guint8 *)GST_VIDEO_FRAME_COMP_DATA(&frame, 0),
+                GST_VIDEO_FRAME_COMP_STRIDE(&frame, 0),
+                has_prev ? (const guint8 *)GST_VIDEO_FRAME_COMP_DATA(&prev_frame, 0) : NULL,
+                has_prev ? GST_VIDEO_FRAME_COMP_STRIDE(&prev_frame, 0) : 0,
+                GST_VIDEO_FRAME_WIDTH(&frame), GST_VIDEO_FRAME_HEIGHT(&frame),
+                LUMA_ROW_STEP(&frame), features);
+
+    if (has_prev) {
+        gst_video_frame_unmap(&prev_frame);
+    }
+    gst_video_frame_unmap(&frame);
+
+    return TRUE;
+}
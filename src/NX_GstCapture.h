@@ -0,0 +1,71 @@
+//------------------------------------------------------------------------------
+//
+//	Copyright (C) 2015 Nexell Co. All Rights Reserved
+//	Nexell Co. Proprietary & Confidential
+//
+//	NEXELL INFORMS THAT THIS CODE AND INFORMATION IS PROVIDED "AS IS" BASE
+//  AND	WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING
+//  BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS
+//  FOR A PARTICULAR PURPOSE.
+//
+//	Module		: libnxgstvplayer.so
+//	File		: NX_GstCapture.h
+//	Description	: Conversion of decoded video frames to RGB images
+//	Author		:
+//	Export		:
+//	History		:
+//
+//------------------------------------------------------------------------------
+
+#ifndef __NX_GSTCAPTURE_H
+#define __NX_GSTCAPTURE_H
+
+#include <gst/gst.h>
+#include "NX_GstTypes.h"
+#include "NX_GstColorConvert.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif	//	__cplusplus
+
+/* Scales and converts the frame of 'sample' to packed RGB, 'width' pixels
+ * wide (0 keeps the frame width). The height follows the display aspect
+ * ratio of the frame. Returns NULL if the format is not supported. */
+struct CAPTURE_FRAME *NX_ConvertSample(GstSample *sample, gint width);
+
+// Size of the frame of NX_ConvertSample() for 'width'
+gboolean NX_SampleOutputSize(GstSample *sample, gint width, gint *out_width, gint *out_height);
+
+/* Scales and converts the frame of 'sample' to 'width' x 'height' pixels of
+ * 'format', written to 'dst' */
+gboolean NX_ConvertSampleInto(GstSample *sample, NX_RGB_FORMAT format, guint8 *dst,
+                            gint dst_stride, gint width, gint height);
+
+/* Decodes an image of a tag (cover art, preview image) and scales it to
+ * 'width' pixels wide, 0 keeps its size */
+struct CAPTURE_FRAME *NX_ConvertImageSample(GstSample *image, gint width);
+
+// JPEG, or PNG if 'path' ends with ".png"
+gboolean NX_SaveCapturedFrame(const struct CAPTURE_FRAME *frame, const gchar *path);
+
+/* Encodes to 'type', "jpeg" or "png", in a buffer allocated with g_malloc().
+ * Nothing is written to the filesystem. */
+gboolean NX_EncodeCapturedFrame(const struct CAPTURE_FRAME *frame, const gchar *type,
+                            gchar **buffer, gsize *size);
+
+void NX_FreeCapturedFrame(struct CAPTURE_FRAME *frame);
+
+/* Mean and variance of the luma of the frame of 'sample', read straight from
+ * its Y plane. Returns FALSE if the frame is not YUV. */
+gboolean NX_SampleLumaStats(GstSample *sample, guint *mean, guint *variance);
+
+/* Same as NX_SampleLumaStats() with the measures of NX_LumaFeatures(), the
+ * difference against the frame of 'previous' if not NULL */
+gboolean NX_SampleLumaFeatures(GstSample *sample, GstSample *previous,
+                            NX_LUMA_FEATURES *features);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __NX_GSTCAPTURE_H
@@ -0,0 +1,828 @@
+//------------------------------------------------------------------------------
+//
+//	Copyright (C) 2015 Nexell Co. All Rights Reserved
+//	Nexell Co. Proprietary & Confidential
+//
+//	NEXELL INFORMS THAT THIS CODE AND INFORMATION IS PROVIDED "AS IS" BASE
+//  AND	WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING
+//  BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS
+//  FOR A PARTICULAR PURPOSE.
+//
+//	Module		: libnxgstvplayer.so
+//	File		: NX_GstColorConvert.c
+//	Description	: YUV 4:2:0 to RGB conversion with a box downscale, luma statistics
+//	Author		:
+//	Export		:
+//	History		:
+//
+//------------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+#include <glib.h>
+
+#include "NX_GstColorConvert.h"
+#include "NX_GstLog.h"
+#define LOG_TAG "[NX_GstColorConvert]"
+
+// The SIMD kernels write the RGB565/ARGB8888 words as little endian bytes
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define HAVE_NEON   1
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#define HAVE_SSE2   1
+#include <emmintrin.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+// Built for SSE2, AVX2 is picked at run time on the hosts which have it
+#define HAVE_AVX2   1
+#include <immintrin.h>
+#endif
+#endif
+#endif
+
+// Rows summed for one output row at most, the sums fit in 16 bits
+#define MAX_BOX_ROWS    256
+
+/* BT.601 limited range, 6 bits fixed point so that the products fit in
+ * 16 bits lanes. The luma factor is 74.5, white must stay white:
+ *   Y' = 74 * (Y - 16) + ((Y - 16) >> 1)
+ *   R = (Y' + 102 * (V - 128) + 32) >> 6
+ *   G = (Y' - 25 * (U - 128) - 52 * (V - 128) + 32) >> 6
+ *   B = (Y' + 129 * (U - 128) + 32) >> 6
+ * Only B can go past 16 bits, and only above 255, so the saturating adds
+ * of the SIMD kernels give the same result as the plain C. */
+#define YUV_CY      74
+#define YUV_CRV     102
+#define YUV_CGU     25
+#define YUV_CGV     52
+#define YUV_CBU     129
+
+struct Kernels {
+    const char *name;
+    // acc[i] += src[i]
+    void (*accumulate)(guint16 *acc, const guint8 *src, gint n);
+    void (*yuv_to_rgb)(const guint8 *y, const guint8 *u, const guint8 *v,
+                    guint8 *r, guint8 *g, guint8 *b, gint n);
+    void (*pack)(const guint8 *r, const guint8 *g, const guint8 *b,
+                guint8 *dst, gint n, NX_RGB_FORMAT format);
+    // Sum and sum of squares of 'n' bytes, n < 64K
+    void (*luma_sums)(const guint8 *src, gint n, guint32 *sum, guint32 *sum_sq);
+    // Sum of absolute differences of 'n' bytes, n < 64K
+    guint32 (*sad)(const guint8 *a, const guint8 *b, gint n);
+};
+
+//------------------------------------------------------------------------------
+// Plain C
+
+static void accumulate_c(guint16 *acc, const guint8 *src, gint n)
+{
+    for (gint i = 0; i < n; i++) {
+        acc[i] += src[i];
+    }
+}
+
+static inline guint8 clamp_u8(gint v)
+{
+    return (v < 0) ? 0 : ((v > 255) ? 255 : (guint8)v);
+}
+
+static void yuv_to_rgb_c(const guint8 *y, const guint8 *u, const guint8 *v,
+                        guint8 *r, guint8 *g, guint8 *b, gint n)
+{
+    for (gint i = 0; i < n; i++)
+    {
+        gint c = YUV_CY * (y[i] - 16) + ((y[i] - 16) >> 1);
+        gint d = u[i] - 128;
+        gint e = v[i] - 128;
+
+        r[i] = clamp_u8((c + YUV_CRV * e + 32) >> 6);
+        g[i] = clamp_u8((c - YUV_CGU * d - YUV_CGV * e + 32) >> 6);
+        b[i] = clamp_u8((c + YUV_CBU * d + 32) >> 6);
+    }
+}
+
+static void pack_c(const guint8 *r, const guint8 *g, const guint8 *b,
+                guint8 *dst, gint n, NX_RGB_FORMAT format)
+{
+    gint i;
+
+    switch (format)
+    {
+        case NX_RGB_FORMAT_RGB888:
+            for (i = 0; i < n; i++)
+            {
+                dst[3 * i] = r[i];
+                dst[3 * i + 1] = g[i];
+                dst[3 * i + 2] = b[i];
+            }
+            break;
+        case NX_RGB_FORMAT_RGB565:
+            for (i = 0; i < n; i++) {
+                ((guint16 *)dst)[i] = (guint16)(((r[i] >> 3) << 11) |
+                                    ((g[i] >> 2) << 5) | (b[i] >> 3));
+            }
+            break;
+        case NX_RGB_FORMAT_ARGB8888:
+            for (i = 0; i < n; i++) {
+                ((guint32 *)dst)[i] = 0xff000000u | ((guint32)r[i] << 16) |
+                                    ((guint32)g[i] << 8) | b[i];
+            }
+            break;
+    }
+}
+
+static void luma_sums_c(const guint8 *src, gint n, guint32 *sum, guint32 *sum_sq)
+{
+    guint32 s = 0, sq = 0;
+
+    for (gint i = 0; i < n; i++)
+    {
+        s += src[i];
+        sq += (guint32)src[i] * src[i];
+    }
+    *sum += s;
+    *sum_sq += sq;
+}
+
+static guint32 sad_c(const guint8 *a, const guint8 *b, gint n)
+{
+    guint32 sum = 0;
+
+    for (gint i = 0; i < n; i++)
+    {
+        sum += (a[i] > b[i]) ? a[i] - b[i] : b[i] - a[i];
+    }
+    return sum;
+}
+
+static const struct Kernels kernels_c = {
+    "C", accumulate_c, yuv_to_rgb_c, pack_c, luma_sums_c, sad_c
+};
+
+//------------------------------------------------------------------------------
+// NEON
+
+#ifdef HAVE_NEON
+static void accumulate_neon(guint16 *acc, const guint8 *src, gint n)
+{
+    gint i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        uint8x16_t s = vld1q_u8(src + i);
+        vst1q_u16(acc + i, vaddw_u8(vld1q_u16(acc + i), vget_low_u8(s)));
+        vst1q_u16(acc + i + 8, vaddw_u8(vld1q_u16(acc + i + 8), vget_high_u8(s)));
+    }
+    accumulate_c(acc + i, src + i, n - i);
+}
+
+static void yuv_to_rgb_neon(const guint8 *y, const guint8 *u, const guint8 *v,
+                        guint8 *r, guint8 *g, guint8 *b, gint n)
+{
+    const int16x8_t k16 = vdupq_n_s16(16);
+    const int16x8_t k128 = vdupq_n_s16(128);
+    const int16x8_t k32 = vdupq_n_s16(32);
+    gint i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        int16x8_t c = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(y + i))), k16);
+        int16x8_t d = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(u + i))), k128);
+        int16x8_t e = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(v + i))), k128);
+        int16x8_t yc = vsraq_n_s16(vmulq_n_s16(c, YUV_CY), c, 1);
+        int16x8_t rr, gg, bb;
+
+        rr = vqaddq_s16(vqaddq_s16(yc, vmulq_n_s16(e, YUV_CRV)), k32);
+        gg = vqsubq_s16(yc, vmulq_n_s16(d, YUV_CGU));
+        gg = vqaddq_s16(vqsubq_s16(gg, vmulq_n_s16(e, YUV_CGV)), k32);
+        bb = vqaddq_s16(vqaddq_s16(yc, vmulq_n_s16(d, YUV_CBU)), k32);
+
+        vst1_u8(r + i, vqmovun_s16(vshrq_n_s16(rr, 6)));
+        vst1_u8(g + i, vqmovun_s16(vshrq_n_s16(gg, 6)));
+        vst1_u8(b + i, vqmovun_s16(vshrq_n_s16(bb, 6)));
+    }
+    yuv_to_rgb_c(y + i, u + i, v + i, r + i, g + i, b + i, n - i);
+}
+
+static void pack_neon(const guint8 *r, const guint8 *g, const guint8 *b,
+                    guint8 *dst, gint n, NX_RGB_FORMAT format)
+{
+    gint i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        uint8x8_t vr = vld1_u8(r + i);
+        uint8x8_t vg = vld1_u8(g + i);
+        uint8x8_t vb = vld1_u8(b + i);
+
+        if (NX_RGB_FORMAT_RGB888 == format)
+        {
+            uint8x8x3_t px = { { vr, vg, vb } };
+            vst3_u8(dst + 3 * i, px);
+        }
+        else if (NX_RGB_FORMAT_RGB565 == format)
+        {
+            uint16x8_t px = vshll_n_u8(vr, 8);
+            px = vsriq_n_u16(px, vshll_n_u8(vg, 8), 5);
+            px = vsriq_n_u16(px, vshll_n_u8(vb, 8), 11);
+            vst1q_u16((guint16 *)dst + i, px);
+        }
+        else
+        {
+            uint8x8x4_t px = { { vb, vg, vr, vdup_n_u8(0xff) } };
+            vst4_u8(dst + 4 * i, px);
+        }
+    }
+    pack_c(r + i, g + i, b + i, dst + i * NX_RGBBytesPerPixel(format), n - i, format);
+}
+
+static void luma_sums_neon(const guint8 *src, gint n, guint32 *sum, guint32 *sum_sq)
+{
+    uint32x4_t vsum = vdupq_n_u32(0);
+    uint32x4_t vsq = vdupq_n_u32(0);
+    uint32x2_t t;
+    gint i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        uint8x16_t s = vld1q_u8(src + i);
+
+        vsum = vpadalq_u16(vsum, vpaddlq_u8(s));
+        vsq = vpadalq_u16(vsq, vmull_u8(vget_low_u8(s), vget_low_u8(s)));
+        vsq = vpadalq_u16(vsq, vmull_u8(vget_high_u8(s), vget_high_u8(s)));
+    }
+    t = vadd_u32(vget_low_u32(vsum), vget_high_u32(vsum));
+    *sum += vget_lane_u32(vpadd_u32(t, t), 0);
+    t = vadd_u32(vget_low_u32(vsq), vget_high_u32(vsq));
+    *sum_sq += vget_lane_u32(vpadd_u32(t, t), 0);
+
+    luma_sums_c(src + i, n - i, sum, sum_sq);
+}
+
+static guint32 sad_neon(const guint8 *a, const guint8 *b, gint n)
+{
+    uint32x4_t vsum = vdupq_n_u32(0);
+    uint32x2_t t;
+    gint i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        uint8x16_t d = vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+
+        vsum = vpadalq_u16(vsum, vpaddlq_u8(d));
+    }
+    t = vadd_u32(vget_low_u32(vsum), vget_high_u32(vsum));
+
+    return vget_lane_u32(vpadd_u32(t, t), 0) + sad_c(a + i, b + i, n - i);
+}
+
+static const struct Kernels kernels_neon = {
+    "NEON", accumulate_neon, yuv_to_rgb_neon, pack_neon, luma_sums_neon, sad_neon
+};
+#endif  // HAVE_NEON
+
+//------------------------------------------------------------------------------
+// SSE2
+
+#ifdef HAVE_SSE2
+static void accumulate_sse2(guint16 *acc, const guint8 *src, gint n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    gint i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i a0 = _mm_loadu_si128((const __m128i *)(acc + i));
+        __m128i a1 = _mm_loadu_si128((const __m128i *)(acc + i + 8));
+
+        _mm_storeu_si128((__m128i *)(acc + i), _mm_add_epi16(a0, _mm_unpacklo_epi8(s, zero)));
+        _mm_storeu_si128((__m128i *)(acc + i + 8), _mm_add_epi16(a1, _mm_unpackhi_epi8(s, zero)));
+    }
+    accumulate_c(acc + i, src + i, n - i);
+}
+
+static void yuv_to_rgb_sse2(const guint8 *y, const guint8 *u, const guint8 *v,
+                        guint8 *r, guint8 *g, guint8 *b, gint n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i k16 = _mm_set1_epi16(16);
+    const __m128i k128 = _mm_set1_epi16(128);
+    const __m128i k32 = _mm_set1_epi16(32);
+    gint i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i c = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(y + i)), zero), k16);
+        __m128i d = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(u + i)), zero), k128);
+        __m128i e = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(v + i)), zero), k128);
+        __m128i yc = _mm_add_epi16(_mm_mullo_epi16(c, _mm_set1_epi16(YUV_CY)), _mm_srai_epi16(c, 1));
+        __m128i rr, gg, bb;
+
+        rr = _mm_adds_epi16(_mm_adds_epi16(yc, _mm_mullo_epi16(e, _mm_set1_epi16(YUV_CRV))), k32);
+        gg = _mm_subs_epi16(yc, _mm_mullo_epi16(d, _mm_set1_epi16(YUV_CGU)));
+        gg = _mm_adds_epi16(_mm_subs_epi16(gg, _mm_mullo_epi16(e, _mm_set1_epi16(YUV_CGV))), k32);
+        bb = _mm_adds_epi16(_mm_adds_epi16(yc, _mm_mullo_epi16(d, _mm_set1_epi16(YUV_CBU))), k32);
+
+        _mm_storel_epi64((__m128i *)(r + i), _mm_packus_epi16(_mm_srai_epi16(rr, 6), zero));
+        _mm_storel_epi64((__m128i *)(g + i), _mm_packus_epi16(_mm_srai_epi16(gg, 6), zero));
+        _mm_storel_epi64((__m128i *)(b + i), _mm_packus_epi16(_mm_srai_epi16(bb, 6), zero));
+    }
+    yuv_to_rgb_c(y + i, u + i, v + i, r + i, g + i, b + i, n - i);
+}
+
+// RGB888 has no cheap SSE2 shuffle, it is left to the C loop
+static void pack_sse2(const guint8 *r, const guint8 *g, const guint8 *b,
+                    guint8 *dst, gint n, NX_RGB_FORMAT format)
+{
+    const __m128i zero = _mm_setzero_si128();
+    gint i = 0;
+
+    if (NX_RGB_FORMAT_ARGB8888 == format)
+    {
+        const __m128i alpha = _mm_set1_epi8((char)0xff);
+
+        for (; i + 16 <= n; i += 16)
+        {
+            __m128i vr = _mm_loadu_si128((const __m128i *)(r + i));
+            __m128i vg = _mm_loadu_si128((const __m128i *)(g + i));
+            __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+            __m128i bg_lo = _mm_unpacklo_epi8(vb, vg);
+            __m128i bg_hi = _mm_unpackhi_epi8(vb, vg);
+            __m128i ra_lo = _mm_unpacklo_epi8(vr, alpha);
+            __m128i ra_hi = _mm_unpackhi_epi8(vr, alpha);
+            __m128i *out = (__m128i *)(dst + 4 * i);
+
+            _mm_storeu_si128(out, _mm_unpacklo_epi16(bg_lo, ra_lo));
+            _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(bg_lo, ra_lo));
+            _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(bg_hi, ra_hi));
+            _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(bg_hi, ra_hi));
+        }
+    }
+    else if (NX_RGB_FORMAT_RGB565 == format)
+    {
+        for (; i + 8 <= n; i += 8)
+        {
+            __m128i vr = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(r + i)), zero);
+            __m128i vg = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(g + i)), zero);
+            __m128i vb = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(b + i)), zero);
+            __m128i px = _mm_slli_epi16(_mm_srli_epi16(vr, 3), 11);
+
+            px = _mm_or_si128(px, _mm_slli_epi16(_mm_srli_epi16(vg, 2), 5));
+            px = _mm_or_si128(px, _mm_srli_epi16(vb, 3));
+            _mm_storeu_si128((__m128i *)(dst + 2 * i), px);
+        }
+    }
+    pack_c(r + i, g + i, b + i, dst + i * NX_RGBBytesPerPixel(format), n - i, format);
+}
+
+static void luma_sums_sse2(const guint8 *src, gint n, guint32 *sum, guint32 *sum_sq)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i vsum = zero, vsq = zero;
+    guint32 lanes[4];
+    gint i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i lo = _mm_unpacklo_epi8(s, zero);
+        __m128i hi = _mm_unpackhi_epi8(s, zero);
+
+        vsum = _mm_add_epi32(vsum, _mm_sad_epu8(s, zero));
+        vsq = _mm_add_epi32(vsq, _mm_madd_epi16(lo, lo));
+        vsq = _mm_add_epi32(vsq, _mm_madd_epi16(hi, hi));
+    }
+    _mm_storeu_si128((__m128i *)lanes, vsum);
+    *sum += lanes[0] + lanes[2];
+    _mm_storeu_si128((__m128i *)lanes, vsq);
+    *sum_sq += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+
+    luma_sums_c(src + i, n - i, sum, sum_sq);
+}
+
+static guint32 sad_sse2(const guint8 *a, const guint8 *b, gint n)
+{
+    __m128i vsum = _mm_setzero_si128();
+    guint32 lanes[4];
+    gint i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        vsum = _mm_add_epi32(vsum, _mm_sad_epu8(_mm_loadu_si128((const __m128i *)(a + i)),
+                                                _mm_loadu_si128((const __m128i *)(b + i))));
+    }
+    _mm_storeu_si128((__m128i *)lanes, vsum);
+
+    return lanes[0] + lanes[2] + sad_c(a + i, b + i, n - i);
+}
+
+static const struct Kernels kernels_sse2 = {
+    "SSE2", accumulate_sse2, yuv_to_rgb_sse2, pack_sse2, luma_sums_sse2, sad_sse2
+};
+#endif  // HAVE_SSE2
+
+//------------------------------------------------------------------------------
+// AVX2, the packing and the luma statistics are left to SSE2
+
+#ifdef HAVE_AVX2
+__attribute__((target("avx2")))
+static void accumulate_avx2(guint16 *acc, const guint8 *src, gint n)
+{
+    gint i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m256i s = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(src + i)));
+        __m256i a = _mm256_loadu_si256((const __m256i *)(acc + i));
+        _mm256_storeu_si256((__m256i *)(acc + i), _mm256_add_epi16(a, s));
+    }
+    accumulate_c(acc + i, src + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static inline void store16_avx2(guint8 *dst, __m256i v)
+{
+    // packus works per 128 bits lane, gather the two low quadwords
+    v = _mm256_packus_epi16(_mm256_srai_epi16(v, 6), _mm256_setzero_si256());
+    v = _mm256_permute4x64_epi64(v, 0x08);
+    _mm_storeu_si128((__m128i *)dst, _mm256_castsi256_si128(v));
+}
+
+__attribute__((target("avx2")))
+static void yuv_to_rgb_avx2(const guint8 *y, const guint8 *u, const guint8 *v,
+                        guint8 *r, guint8 *g, guint8 *b, gint n)
+{
+    const __m256i k16 = _mm256_set1_epi16(16);
+    const __m256i k128 = _mm256_set1_epi16(128);
+    const __m256i k32 = _mm256_set1_epi16(32);
+    gint i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m256i c = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(y + i))), k16);
+        __m256i d = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(u + i))), k128);
+        __m256i e = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(v + i))), k128);
+        __m256i yc = _mm256_add_epi16(_mm256_mullo_epi16(c, _mm256_set1_epi16(YUV_CY)), _mm256_srai_epi16(c, 1));
+        __m256i rr, gg, bb;
+
+        rr = _mm256_adds_epi16(_mm256_adds_epi16(yc, _mm256_mullo_epi16(e, _mm256_set1_epi16(YUV_CRV))), k32);
+        gg = _mm256_subs_epi16(yc, _mm256_mullo_epi16(d, _mm256_set1_epi16(YUV_CGU)));
+        gg = _mm256_adds_epi16(_mm256_subs_epi16(gg, _mm256_mullo_epi16(e, _mm256_set1_epi16(YUV_CGV))), k32);
+        bb = _mm256_adds_epi16(_mm256_adds_epi16(yc, _mm256_mullo_epi16(d, _mm256_set1_epi16(YUV_CBU))), k32);
+
+        store16_avx2(r + i, rr);
+        store16_avx2(g + i, gg);
+        store16_avx2(b + i, bb);
+    }
+    yuv_to_rgb_sse2(y + i, u + i, v + i, r + i, g + i, b + i, n - i);
+}
+
+static const struct Kernels kernels_avx2 = {
+    "AVX2", accumulate_avx2, yuv_to_rgb_avx2, pack_sse2, luma_sums_sse2, sad_sse2
+};
+#endif  // HAVE_AVX2
+
+/* The best kernels the host runs, unless NX_GST_SIMD names another one
+ * of them ("C", "SSE2", ...), e.g. to compare them with the C ones. */
+static const struct Kernels *get_kernels(void)
+{
+    static const struct Kernels *kernels = NULL;
+
+    if (g_once_init_enter(&kernels))
+    {
+        const struct Kernels *usable[4];
+        gint n = 0;
+        const gchar *env = g_getenv("NX_GST_SIMD");
+        const struct Kernels *k;
+
+        usable[n++] = &kernels_c;
+#if defined(HAVE_NEON)
+        usable[n++] = &kernels_neon;
+#elif defined(HAVE_SSE2)
+        usable[n++] = &kernels_sse2;
+#ifdef HAVE_AVX2
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            usable[n++] = &kernels_avx2;
+        }
+#endif
+#endif
+        k = usable[n - 1];
+        if (env)
+        {
+            gint i;
+            for (i = 0; i < n; i++)
+            {
+                if (0 == g_ascii_strcasecmp(env, usable[i]->name)) {
+                    k = usable[i];
+                    break;
+                }
+            }
+            if (i == n) {
+                NXGLOGW("%s kernels are not available", env);
+            }
+        }
+        NXGLOGI("%s kernels", k->name);
+        g_once_init_leave(&kernels, k);
+    }
+
+    return kernels;
+}
+
+const char *NX_GetColorKernels(void)
+{
+    return get_kernels()->name;
+}
+
+//------------------------------------------------------------------------------
+
+gint NX_RGBBytesPerPixel(NX_RGB_FORMAT format)
+{
+    switch (format)
+    {
+        case NX_RGB_FORMAT_RGB565:      return 2;
+        case NX_RGB_FORMAT_ARGB8888:    return 4;
+        default:                        return 3;
+    }
+}
+
+/* The source rows of each output row are summed into 16 bits accumulators
+ * first (SIMD), then each output pixel takes the average of its columns.
+ * Every source row is read once, and no intermediate picture is made. */
+static void scale_yuv_to_rgb(const struct Kernels *k, const NX_YUV_PLANES *src,
+                            guint8 *dst, gint dst_stride, gint dst_width,
+                            gint dst_height, NX_RGB_FORMAT format)
+{
+    gint cw = (src->width + 1) / 2;
+    gint ch = (src->height + 1) / 2;
+    gboolean semi_planar = (NULL == src->v);
+    // The interleaved chroma row is summed as a whole
+    gint acc_c_width = semi_planar ? cw * 2 : cw;
+    guint16 *acc_y = g_new(guint16, src->width);
+    guint16 *acc_u = g_new(guint16, acc_c_width);
+    guint16 *acc_v = semi_planar ? NULL : g_new(guint16, cw);
+    gint *edge = g_new(gint, dst_width + 1);
+    guint8 *row = (guint8 *)g_malloc(dst_width * 6);
+    guint8 *y_row = row, *u_row = row + dst_width, *v_row = row + dst_width * 2;
+    guint8 *r = row + dst_width * 3, *g = row + dst_width * 4, *b = row + dst_width * 5;
+    gint u_off = src->swap_uv ? 1 : 0;
+
+    for (gint i = 0; i <= dst_width; i++) {
+        edge[i] = (gint)((gint64)i * src->width / dst_width);
+    }
+
+    for (gint j = 0; j < dst_height; j++)
+    {
+        gint sy0 = (gint)((gint64)j * src->height / dst_height);
+        gint sy1 = MAX((gint)((gint64)(j + 1) * src->height / dst_height), sy0 + 1);
+        gint cy0 = sy0 / 2;
+        gint cy1 = MIN(MAX((sy1 + 1) / 2, cy0 + 1), ch);
+        gint rows, crows;
+
+        sy1 = MIN(sy1, sy0 + MAX_BOX_ROWS);
+        cy1 = MIN(cy1, cy0 + MAX_BOX_ROWS);
+        rows = sy1 - sy0;
+        crows = cy1 - cy0;
+
+        memset(acc_y, 0, src->width * sizeof(guint16));
+        for (gint sy = sy0; sy < sy1; sy++) {
+            k->accumulate(acc_y, src->y + (gsize)sy * src->y_stride, src->width);
+        }
+        memset(acc_u, 0, acc_c_width * sizeof(guint16));
+        if (acc_v) {
+            memset(acc_v, 0, cw * sizeof(guint16));
+        }
+        for (gint sy = cy0; sy < cy1; sy++)
+        {
+            k->accumulate(acc_u, src->u + (gsize)sy * src->u_stride, acc_c_width);
+            if (acc_v) {
+                k->accumulate(acc_v, src->v + (gsize)sy * src->v_stride, cw);
+            }
+        }
+
+        for (gint i = 0; i < dst_width; i++)
+        {
+            gint sx0 = edge[i];
+            gint sx1 = MAX(edge[i + 1], sx0 + 1);
+            gint cx0 = sx0 / 2;
+            gint cx1 = MIN(MAX((sx1 + 1) / 2, cx0 + 1), cw);
+            guint32 sum_y = 0, sum_u = 0, sum_v = 0;
+            guint32 area, carea;
+
+            for (gint x = sx0; x < sx1; x++) {
+                sum_y += acc_y[x];
+            }
+            for (gint x = cx0; x < cx1; x++)
+            {
+                if (semi_planar)
+                {
+                    sum_u += acc_u[2 * x + u_off];
+                    sum_v += acc_u[2 * x + 1 - u_off];
+                }
+                else
+                {
+                    sum_u += acc_u[x];
+                    sum_v += acc_v[x];
+                }
+            }
+            area = (guint32)((sx1 - sx0) * rows);
+            carea = (guint32)((cx1 - cx0) * crows);
+            y_row[i] = (guint8)((sum_y + area / 2) / area);
+            u_row[i] = (guint8)((sum_u + carea / 2) / carea);
+            v_row[i] = (guint8)((sum_v + carea / 2) / carea);
+        }
+
+        k->yuv_to_rgb(y_row, u_row, v_row, r, g, b, dst_width);
+        k->pack(r, g, b, dst + (gsize)j * dst_stride, dst_width, format);
+    }
+
+    g_free(acc_y);
+    g_free(acc_u);
+    g_free(acc_v);
+    g_free(edge);
+    g_free(row);
+}
+
+void NX_ScaleYUVToRGB(const NX_YUV_PLANES *src, guint8 *dst, gint dst_stride,
+                    gint dst_width, gint dst_height, NX_RGB_FORMAT format)
+{
+    scale_yuv_to_rgb(get_kernels(), src, dst, dst_stride, dst_width, dst_height, format);
+}
+
+void NX_ScaleYUVToRGB_C(const NX_YUV_PLANES *src, guint8 *dst, gint dst_stride,
+                    gint dst_width, gint dst_height, NX_RGB_FORMAT format)
+{
+    scale_yuv_to_rgb(&kernels_c, src, dst, dst_stride, dst_width, dst_height, format);
+}
+
+void NX_PackRGB888(const guint8 *src, gint src_stride, guint8 *dst, gint dst_stride,
+                gint width, gint height, NX_RGB_FORMAT format)
+{
+    const struct Kernels *k = get_kernels();
+    gint bpp = NX_RGBBytesPerPixel(format);
+    guint8 r[256], g[256], b[256];
+
+    for (gint j = 0; j < height; j++)
+    {
+        const guint8 *in = src + (gsize)j * src_stride;
+        guint8 *out = dst + (gsize)j * dst_stride;
+
+        for (gint x = 0; x < width; x += 256)
+        {
+            gint n = MIN(width - x, 256);
+
+            for (gint i = 0; i < n; i++)
+            {
+                r[i] = in[3 * (x + i)];
+                g[i] = in[3 * (x + i) + 1];
+                b[i] = in[3 * (x + i) + 2];
+            }
+            k->pack(r, g, b, out + x * bpp, n, format);
+        }
+    }
+}
+
+static void luma_stats(const struct Kernels *k, const guint8 *y, gint stride,
+                    gint width, gint height, gint row_step,
+                    guint *mean, guint *variance)
+{
+    guint64 sum = 0, sum_sq = 0, count = 0;
+
+    row_step = MAX(row_step, 1);
+    for (gint j = 0; j < height; j += row_step)
+    {
+        const guint8 *row = y + (gsize)j * stride;
+
+        // Chunks keep the 32 bits sums of the kernels from overflowing
+        for (gint x = 0; x < width; x += 16384)
+        {
+            guint32 s = 0, sq = 0;
+
+            k->luma_sums(row + x, MIN(width - x, 16384), &s, &sq);
+            sum += s;
+            sum_sq += sq;
+        }
+        count += width;
+    }
+
+    if (0 == count)
+    {
+        *mean = *variance = 0;
+        return;
+    }
+    *mean = (guint)(sum / count);
+    *variance = (guint)(sum_sq / count - (sum / count) * (sum / count));
+}
+
+void NX_LumaStats(const guint8 *y, gint stride, gint width, gint height,
+                gint row_step, guint *mean, guint *variance)
+{
+    luma_stats(get_kernels(), y, stride, width, height, row_step, mean, variance);
+}
+
+void NX_LumaStats_C(const guint8 *y, gint stride, gint width, gint height,
+                gint row_step, guint *mean, guint *variance)
+{
+    luma_stats(&kernels_c, y, stride, width, height, row_step, mean, variance);
+}
+
+static guint64 row_sad(const struct Kernels *k, const guint8 *a, const guint8 *b, gint n)
+{
+    guint64 sum = 0;
+
+    for (gint x = 0; x < n; x += 16384)
+    {
+        sum += k->sad(a + x, b + x, MIN(n - x, 16384));
+    }
+    return sum;
+}
+
+static void luma_features(const struct Kernels *k, const guint8 *y, gint stride,
+                        const guint8 *prev, gint prev_stride, gint width, gint height,
+                        gint row_step, NX_LUMA_FEATURES *features)
+{
+    // Four histograms take turns, so that equal neighbours do not stall
+    guint32 hist[4][256];
+    guint64 edges = 0, edge_count = 0, diff = 0, count = 0;
+    guint64 cumul, low, high;
+    gint i, x;
+
+    memset(hist, 0, sizeof(hist));
+    luma_stats(k, y, stride, width, height, row_step, &features->mean, &features->variance);
+
+    row_step = MAX(row_step, 1);
+    for (gint j = 0; j < height; j += row_step)
+    {
+        const guint8 *row = y + (gsize)j * stride;
+
+        for (x = 0; x + 4 <= width; x += 4)
+        {
+            hist[0][row[x]]++;
+            hist[1][row[x + 1]]++;
+            hist[2][row[x + 2]]++;
+            hist[3][row[x + 3]]++;
+        }
+        for (; x < width; x++)
+        {
+            hist[0][row[x]]++;
+        }
+        count += width;
+
+        // Horizontal and vertical gradients
+        if (width > 1)
+        {
+            edges += row_sad(k, row, row + 1, width - 1);
+            edge_count += width - 1;
+        }
+        if (j + 1 < height)
+        {
+            edges += row_sad(k, row, row + stride, width);
+            edge_count += width;
+        }
+        if (prev) {
+            diff += row_sad(k, row, prev + (gsize)j * prev_stride, width);
+        }
+    }
+
+    features->edges = edge_count ? (guint)(edges * 16 / edge_count) : 0;
+    features->difference = (prev && count) ? (gint)(diff * 16 / count) : -1;
+
+    // Levels of the 5th and the 95th percentiles
+    features->spread = 0;
+    if (0 == count)
+        return;
+    low = high = 0;
+    cumul = 0;
+    for (i = 0; i < 256; i++)
+    {
+        guint64 n = (guint64)hist[0][i] + hist[1][i] + hist[2][i] + hist[3][i];
+
+        if (cumul * 20 < count && (cumul + n) * 20 >= count) {
+            low = i;
+        }
+        if (cumul * 20 < count * 19 && (cumul + n) * 20 >= count * 19) {
+            high = i;
+        }
+        cumul += n;
+    }
+    features->spread = (guint)(high - low);
+}
+
+void NX_LumaFeatures(const guint8 *y, gint stride, const guint8 *prev, gint prev_stride,
+                    gint width, gint height, gint row_step, NX_LUMA_FEATURES *features)
+{
+    luma_features(get_kernels(), y, stride, prev, prev_stride, width, height,
+                row_step, features);
+}
+
+void NX_LumaFeatures_C(const guint8 *y, gint stride, const guint8 *prev, gint prev_stride,
+                    gint width, gint height, gint row_step, NX_LUMA_FEATURES *features)
+{
+    luma_features(&kernels_c, y, stride, prev, prev_stride, width, height,
+                row_step, features);
+}
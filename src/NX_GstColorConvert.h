@@ -0,0 +1,106 @@
+//------------------------------------------------------------------------------
+//
+//	Copyright (C) 2015 Nexell Co. All Rights Reserved
+//	Nexell Co. Proprietary & Confidential
+//
+//	NEXELL INFORMS THAT THIS CODE AND INFORMATION IS PROVIDED "AS IS" BASE
+//  AND	WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING
+//  BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS
+//  FOR A PARTICULAR PURPOSE.
+//
+//	Module		: libnxgstvplayer.so
+//	File		: NX_GstColorConvert.h
+//	Description	: YUV 4:2:0 to RGB conversion with a box downscale, luma statistics
+//	Author		:
+//	Export		:
+//	History		:
+//
+//------------------------------------------------------------------------------
+
+#ifndef __NX_GSTCOLORCONVERT_H
+#define __NX_GSTCOLORCONVERT_H
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif	//	__cplusplus
+
+typedef enum {
+    // R, G, B bytes
+    NX_RGB_FORMAT_RGB888,
+    // 16 bits words, native endian
+    NX_RGB_FORMAT_RGB565,
+    // 32 bits words 0xAARRGGBB, native endian, opaque
+    NX_RGB_FORMAT_ARGB8888,
+} NX_RGB_FORMAT;
+
+typedef struct NX_YUV_PLANES {
+    gint            width;
+    gint            height;
+    const guint8    *y;
+    gint            y_stride;
+    // Planar (I420, YV12): 'u' and 'v'. Semi-planar (NV12): 'u' is the
+    // interleaved plane and 'v' is NULL, 'swap_uv' for NV21.
+    const guint8    *u;
+    gint            u_stride;
+    const guint8    *v;
+    gint            v_stride;
+    gboolean        swap_uv;
+} NX_YUV_PLANES;
+
+typedef struct NX_LUMA_FEATURES {
+    guint   mean;
+    guint   variance;
+    // Mean absolute difference of neighbour pixels, in 1/16 of a level
+    guint   edges;
+    // Levels between the 5th and the 95th percentiles of the histogram
+    guint   spread;
+    // Mean absolute difference with the previous frame, in 1/16 of a
+    // level. -1 without a previous frame.
+    gint    difference;
+} NX_LUMA_FEATURES;
+
+gint NX_RGBBytesPerPixel(NX_RGB_FORMAT format);
+
+// Name of the kernels in use: "NEON", "AVX2", "SSE2" or "C"
+const char *NX_GetColorKernels(void);
+
+/* Converts BT.601 limited range YUV to RGB, 'dst_width' x 'dst_height'.
+ * Each output pixel is the average of its box in the source, so it is
+ * meant for downscaling. Uses the NEON, AVX2 or SSE2 kernels available. */
+void NX_ScaleYUVToRGB(const NX_YUV_PLANES *src, guint8 *dst, gint dst_stride,
+                    gint dst_width, gint dst_height, NX_RGB_FORMAT format);
+
+// Plain C version of NX_ScaleYUVToRGB(), the reference of the SIMD kernels
+void NX_ScaleYUVToRGB_C(const NX_YUV_PLANES *src, guint8 *dst, gint dst_stride,
+                    gint dst_width, gint dst_height, NX_RGB_FORMAT format);
+
+// Repacks R, G, B bytes to 'format', for images that are already RGB
+void NX_PackRGB888(const guint8 *src, gint src_stride, guint8 *dst, gint dst_stride,
+                gint width, gint height, NX_RGB_FORMAT format);
+
+/* Mean and variance of a luma plane, from every 'row_step'th row.
+ * A low variance tells a flat picture such as a black frame of a fade. */
+void NX_LumaStats(const guint8 *y, gint stride, gint width, gint height,
+                gint row_step, guint *mean, guint *variance);
+
+// Plain C version of NX_LumaStats()
+void NX_LumaStats_C(const guint8 *y, gint stride, gint width, gint height,
+                gint row_step, guint *mean, guint *variance);
+
+/* NX_LumaStats() along with the measures of detail and of change telling
+ * a good picture. 'prev' is the luma plane of the previous frame, of the
+ * same size, or NULL. */
+void NX_LumaFeatures(const guint8 *y, gint stride, const guint8 *prev, gint prev_stride,
+                    gint width, gint height, gint row_step, NX_LUMA_FEATURES *features);
+
+// Plain C version of NX_LumaFeatures()
+void NX_LumaFeatures_C(const guint8 *y, gint stride, const guint8 *prev, gint prev_stride,
+                    gint width, gint height, gint row_step, NX_LUMA_FEATURES *features);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __NX_GSTCOLORCONVERT_H
@@ -158,6 +158,8 @@ static void  get_gst_stream_info(GstDiscovererStreamInfo *sinfo, gint depth,
                 pMediaInfo->ProgramInfo[cur_pro_idx].AudioInfo[a_idx].type = AUDIO_TYPE_MPEG_V1;
             } else if (audio_mpegversion == 2) {
                 pMediaInfo->ProgramInfo[cur_pro_idx].AudioInfo[a_idx].type = AUDIO_TYPE_MPEG_V2;
+            } else if (audio_mpegversion == 4) {
+                pMediaInfo->ProgramInfo[cur_pro_idx].AudioInfo[a_idx].type = AUDIO_TYPE_AAC;
             }
         }
 
@@ -540,11 +542,7 @@ gboolean isSupportedContents(struct GST_MEDIA_INFO *pMediaInfo)
 #endif
         )
     {
-#ifdef SW_V_DECODER
-        if (video_type > VIDEO_TYPE_FLV)
-#else
-        if (video_type >= VIDEO_TYPE_FLV)
-#endif
+        if (!IS_SUPPORTED_VIDEO_TYPE(video_type))
         {
             NXGLOGE("Not supported video type(%d)", video_type);
             return FALSE;
@@ -7,6 +7,19 @@
 extern "C" {
 #endif	//	__cplusplus
 
+// nxvideodec decodes the video types listed before VIDEO_TYPE_FLV
+#define IS_HW_VIDEO_TYPE(type)      ((type) < VIDEO_TYPE_FLV)
+#ifdef SW_V_DECODER
+// Other types decoded by the software decoder chain
+#define IS_SW_VIDEO_TYPE(type)      (((type) == VIDEO_TYPE_FLV) || \
+                                     ((type) == VIDEO_TYPE_H265) || \
+                                     ((type) == VIDEO_TYPE_THEORA) || \
+                                     ((type) == VIDEO_TYPE_VP9))
+#define IS_SUPPORTED_VIDEO_TYPE(type)   (IS_HW_VIDEO_TYPE(type) || IS_SW_VIDEO_TYPE(type))
+#else
+#define IS_SUPPORTED_VIDEO_TYPE(type)   IS_HW_VIDEO_TYPE(type)
+#endif
+
 static struct {
     const char *mimetype;
     CONTAINER_TYPE  type;
@@ -19,6 +32,7 @@ static struct {
     {"video/x-msvideo",         CONTAINER_TYPE_MSVIDEO,     DEMUX_TYPE_AVIDEMUX,        "avidemux"},
     {"video/x-ms-asf",          CONTAINER_TYPE_ASF,         DEMUX_TYPE_ASFDEMUX,        "asfdemux"},
     {"video/x-matroska",        CONTAINER_TYPE_MATROSKA,    DEMUX_TYPE_MATROSKADEMUX,   "matroskademux"},
+    {"video/webm",              CONTAINER_TYPE_MATROSKA,    DEMUX_TYPE_MATROSKADEMUX,   "matroskademux"},
     {"video/x-flv",             CONTAINER_TYPE_FLV,         DEMUX_TYPE_FLVDEMUX,        "flvdemux"},
     {"video/mpeg",              CONTAINER_TYPE_MPEG,        DEMUX_TYPE_MPEGDEMUX,       "mpegdemux"},
     {"video/mpegts",            CONTAINER_TYPE_MPEGTS,      DEMUX_TYPE_MPEGTSDEMUX,     "mpegtsdemux"},
@@ -50,6 +64,7 @@ static struct {
 	{"video/x-wmv",             VIDEO_TYPE_WMV},
 	{"video/x-theora",          VIDEO_TYPE_THEORA},
 	{"video/x-xvid",            VIDEO_TYPE_XVID},
+	{"video/x-vp9",             VIDEO_TYPE_VP9},
 	{NULL,                      VIDEO_TYPE_UNKNOWN},
 };
 
@@ -70,6 +85,8 @@ static struct {
 	{"audio/x-dts",             AUDIO_TYPE_DTS},
 	{"audio/x-private1-dts",    AUDIO_TYPE_DTS_PRI},
     {"audio/x-wav",             AUDIO_TYPE_WAV},
+	{"audio/x-eac3",            AUDIO_TYPE_EAC3},
+	{"audio/x-opus",            AUDIO_TYPE_OPUS},
 	{NULL,                      AUDIO_TYPE_UNKNOWN},
 };
 
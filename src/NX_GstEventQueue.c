@@ -0,0 +1,198 @@
+//------------------------------------------------------------------------------
+//
+//	Copyright (C) 2015 Nexell Co. All Rights Reserved
+//	Nexell Co. Proprietary & Confidential
+//
+//	NEXELL INFORMS THAT THIS CODE AND INFORMATION IS PROVIDED "AS IS" BASE
+//  AND	WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING
+//  BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS
+//  FOR A PARTICULAR PURPOSE.
+//
+//	Module		: libnxgstvplayer.so
+//	File		: NX_GstEventQueue.c
+//	Description	: Bounded lock-free MPSC queue for player events
+//	Author		:
+//	Export		:
+//	History		:
+//
+//------------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib.h>
+#include "NX_GstEventQueue.h"
+
+#define EVENT_QUEUE_CACHE_LINE      64
+
+// Each slot carries a sequence number which tells producers and the consumer
+// whose turn it is: seq == pos means free for the producer claiming 'pos',
+// seq == pos + 1 means filled and ready for the consumer.
+struct NX_EVENT_SLOT {
+    volatile gint   seq;
+    NX_EVENT        event;
+};
+
+struct NX_EVENT_QUEUE {
+    struct NX_EVENT_SLOT *slots;
+    guint           mask;
+    gchar           pad0[EVENT_QUEUE_CACHE_LINE];
+    volatile gint   tail;       // Next position to be claimed by a producer
+    gchar           pad1[EVENT_QUEUE_CACHE_LINE];
+    volatile gint   head;       // Next position to be read by the consumer
+    // Ring positions which only the events that must not be lost may use
+    guint           reserved;
+    // Events that must not be lost, posted while the ring was full.
+    // They always follow the events in the ring, so while 'overflow' is not
+    // empty every new event goes there too to keep the posting order.
+    GMutex          overflow_lock;
+    GQueue          overflow;
+    volatile gint   overflow_len;
+    volatile gint   overflowed; // Total number of events which overflowed
+};
+
+NX_EVENT_QUEUE *NX_CreateEventQueue(guint size, guint reserved)
+{
+    NX_EVENT_QUEUE *queue;
+    guint capacity = 2;
+    guint i;
+
+    while (capacity < size)
+        capacity <<= 1;
+
+    queue = g_new0(NX_EVENT_QUEUE, 1);
+    queue->slots = g_new0(struct NX_EVENT_SLOT, capacity);
+    queue->mask = capacity - 1;
+    queue->reserved = MIN(reserved, capacity - 1);
+    g_mutex_init(&queue->overflow_lock);
+    g_queue_init(&queue->overflow);
+    for (i = 0; i < capacity; i++)
+        queue->slots[i].seq = (gint)i;
+
+    return queue;
+}
+
+void NX_DestroyEventQueue(NX_EVENT_QUEUE *queue)
+{
+    if (queue)
+    {
+        g_queue_foreach(&queue->overflow, (GFunc)g_free, NULL);
+        g_queue_clear(&queue->overflow);
+        g_mutex_clear(&queue->overflow_lock);
+        g_free(queue->slots);
+        g_free(queue);
+    }
+}
+
+static void push_overflow(NX_EVENT_QUEUE *queue, const NX_EVENT *event)
+{
+    NX_EVENT *copy = g_new(NX_EVENT, 1);
+
+    *copy = *event;
+    g_mutex_lock(&queue->overflow_lock);
+    g_queue_push_tail(&queue->overflow, copy);
+    g_atomic_int_inc(&queue->overflow_len);
+    g_atomic_int_inc(&queue->overflowed);
+    g_mutex_unlock(&queue->overflow_lock);
+}
+
+gboolean NX_PushEvent(NX_EVENT_QUEUE *queue, const NX_EVENT *event,
+                        gboolean droppable)
+{
+    struct NX_EVENT_SLOT *slot;
+    guint limit = droppable ? (queue->mask + 1 - queue->reserved) : (queue->mask + 1);
+    guint pos;
+
+    if (g_atomic_int_get(&queue->overflow_len) > 0)
+    {
+        if (droppable)
+            return FALSE;
+        push_overflow(queue, event);
+        return TRUE;
+    }
+
+    pos = (guint)g_atomic_int_get(&queue->tail);
+    for (;;)
+    {
+        slot = &queue->slots[pos & queue->mask];
+        gint diff = (gint)((guint)g_atomic_int_get(&slot->seq) - pos);
+        // 'head' only moves forward, so this never underestimates the depth
+        if (pos - (guint)g_atomic_int_get(&queue->head) >= limit)
+            diff = -1;
+        if (diff == 0)
+        {
+            // The slot is free, try to claim it
+            if (g_atomic_int_compare_and_exchange(&queue->tail, (gint)pos, (gint)(pos + 1)))
+                break;
+            pos = (guint)g_atomic_int_get(&queue->tail);
+        }
+        else if (diff < 0)
+        {
+            // The queue is full, or only the reserved positions are left
+            if (droppable)
+                return FALSE;
+            push_overflow(queue, event);
+            return TRUE;
+        }
+        else
+        {
+            // Another producer claimed it first
+            pos = (guint)g_atomic_int_get(&queue->tail);
+        }
+    }
+
+    slot->event = *event;
+    // Publish the slot to the consumer
+    g_atomic_int_set(&slot->seq, (gint)(pos + 1));
+
+    return TRUE;
+}
+
+gboolean NX_PopEvent(NX_EVENT_QUEUE *queue, NX_EVENT *event)
+{
+    guint pos = (guint)g_atomic_int_get(&queue->head);
+    struct NX_EVENT_SLOT *slot = &queue->slots[pos & queue->mask];
+
+    if ((gint)((guint)g_atomic_int_get(&slot->seq) - (pos + 1)) < 0)
+    {
+        NX_EVENT *overflowed = NULL;
+
+        // The ring is empty (or the producer of this slot has not finished
+        // writing yet), the overflowed events come after it
+        if (g_atomic_int_get(&queue->overflow_len) == 0 ||
+            pos != (guint)g_atomic_int_get(&queue->tail))
+            return FALSE;
+
+        g_mutex_lock(&queue->overflow_lock);
+        overflowed = (NX_EVENT *)g_queue_pop_head(&queue->overflow);
+        if (overflowed)
+            g_atomic_int_dec_and_test(&queue->overflow_len);
+        g_mutex_unlock(&queue->overflow_lock);
+
+        if (!overflowed)
+            return FALSE;
+        *event = *overflowed;
+        g_free(overflowed);
+        return TRUE;
+    }
+
+    *event = slot->event;
+    // Hand the slot back to producers for the next lap
+    g_atomic_int_set(&slot->seq, (gint)(pos + queue->mask + 1));
+    g_atomic_int_set(&queue->head, (gint)(pos + 1));
+
+    return TRUE;
+}
+
+gint NX_GetEventQueueDepth(NX_EVENT_QUEUE *queue)
+{
+    gint depth = (gint)((guint)g_atomic_int_get(&queue->tail) -
+                        (guint)g_atomic_int_get(&queue->head));
+    return ((depth < 0) ? 0 : depth) + g_atomic_int_get(&queue->overflow_len);
+}
+
+gint NX_GetEventQueueOverflowed(NX_EVENT_QUEUE *queue)
+{
+    return g_atomic_int_get(&queue->overflowed);
+}
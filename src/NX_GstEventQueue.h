@@ -0,0 +1,61 @@
+//------------------------------------------------------------------------------
+//
+//	Copyright (C) 2015 Nexell Co. All Rights Reserved
+//	Nexell Co. Proprietary & Confidential
+//
+//	NEXELL INFORMS THAT THIS CODE AND INFORMATION IS PROVIDED "AS IS" BASE
+//  AND	WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING
+//  BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS
+//  FOR A PARTICULAR PURPOSE.
+//
+//	Module		: libnxgstvplayer.so
+//	File		: NX_GstEventQueue.h
+//	Description	: Bounded lock-free MPSC queue for player events
+//	Author		:
+//	Export		:
+//	History		:
+//
+//------------------------------------------------------------------------------
+
+#ifndef __NX_GSTEVENTQUEUE_H
+#define __NX_GSTEVENTQUEUE_H
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif	//	__cplusplus
+
+typedef struct NX_EVENT {
+    guint       type;
+    guint       data;
+    gpointer    param;
+    // g_get_monotonic_time() when the event was posted
+    gint64      post_time;
+} NX_EVENT;
+
+typedef struct NX_EVENT_QUEUE NX_EVENT_QUEUE;
+
+/*
+ * Any number of threads may call NX_PushEvent() concurrently without locking.
+ * Only one thread (the loop thread) may call NX_PopEvent().
+ * Events are popped in the order their slots were claimed, so events of the
+ * same type are always delivered in the order they were posted.
+ *
+ * A droppable event is refused once only 'reserved' slots are left.
+ * Any other event is never refused: if the ring is full it is kept in a
+ * locked overflow list and popped after the events in the ring.
+ */
+NX_EVENT_QUEUE *NX_CreateEventQueue(guint size, guint reserved);
+void NX_DestroyEventQueue(NX_EVENT_QUEUE *queue);
+gboolean NX_PushEvent(NX_EVENT_QUEUE *queue, const NX_EVENT *event,
+                        gboolean droppable);
+gboolean NX_PopEvent(NX_EVENT_QUEUE *queue, NX_EVENT *event);
+gint NX_GetEventQueueDepth(NX_EVENT_QUEUE *queue);
+gint NX_GetEventQueueOverflowed(NX_EVENT_QUEUE *queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __NX_GSTEVENTQUEUE_H
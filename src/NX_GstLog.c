@@ -1,3 +1,4 @@
+//------------------------------------------------------------------------------
 //
 //	Copyright (C) 2015 Nexell Co. All Rights Reserved
 //	Nexell Co. Proprietary & Confidential
@@ -8,8 +9,8 @@
 //  FOR A PARTICULAR PURPOSE.
 //
 //	Module		: libnxgstvplayer.so
-//	File		:
-//	Description	:
+//	File		: NX_GstLog.c
+//	Description	: Asynchronous logger, drained to syslog, stderr or a file
 //	Author		:
 //	Export		:
 //	History		:
@@ -24,7 +25,863 @@
 #include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <stddef.h>
 #include <syslog.h>
+#include <glib.h>
+
+#include "NX_GstLog.h"
+
+/*
+ * A log call does not format nor write anything. It copies the format
+ * pointer (a literal of the macros) and the arguments into a record of a
+ * ring owned by its thread, strings included since they may be gone later.
+ * Each ring has a single producer, its thread, and a single consumer, the
+ * drain thread, so the head and the tail are enough to share it without a
+ * lock. The drain thread merges the records of all the rings by time,
+ * formats them and writes them to the outputs.
+ * A full ring drops the record and counts it, the log call never waits.
+ */
+
+// Records per thread, and bytes per record with its arguments
+#define LOG_RING_SLOTS		128
+#define LOG_SLOT_SIZE		384
+// Formatted line at most
+#define LOG_LINE_MAX		1024
+// Drain period, doubled while the rings are empty up to LOG_DRAIN_IDLE
+#define LOG_DRAIN_PERIOD	(10 * 1000)
+#define LOG_DRAIN_IDLE		(160 * 1000)
+#define LOG_SPEC_MAX		32
+
+enum {
+	// Arguments copied by copy_args(), formatted by the drain thread
+	LOG_RECORD_ARGS,
+	// A format copy_args() does not know, formatted by the caller
+	LOG_RECORD_TEXT,
+};
+
+typedef enum {
+	ARG_NONE,
+	ARG_INT,
+	ARG_LONG,
+	ARG_LLONG,
+	ARG_SIZE,
+	ARG_DOUBLE,
+	ARG_LDOUBLE,
+	ARG_PTR,
+	ARG_STR,
+	// %m, strerror() of the errno of the call
+	ARG_ERRNO,
+	ARG_UNKNOWN,
+} ArgType;
+
+// One conversion of a format, "%-*.*lu"
+typedef struct {
+	const char	*start;
+	gsize		len;
+	// Number of '*' of the width and the precision
+	gint		stars;
+	ArgType		type;
+} LogSpec;
+
+typedef struct {
+	const char	*format;
+	gint64		time_usec;
+	gint		priority;
+	gint		kind;
+	gint		saved_errno;
+	guint16		size;
+} LogRecordHeader;
+
+typedef struct {
+	LogRecordHeader	header;
+	guint8			data[LOG_SLOT_SIZE - sizeof(LogRecordHeader)];
+} LogRecord;
+
+typedef struct LogRing {
+	// Written by the producer, the next record
+	volatile gint	head;
+	// Written by the drain thread, the next record to write out
+	volatile gint	tail;
+	volatile gint	dropped;
+	// Its thread is gone, freed by the drain thread once empty
+	volatile gint	closed;
+	struct LogRing	*next;
+	LogRecord		records[LOG_RING_SLOTS];
+} LogRing;
+
+static void ring_thread_exit(gpointer data);
+
+static GPrivate log_ring_key = G_PRIVATE_INIT(ring_thread_exit);
+// Rings are added at the head by their thread, removed by the drain thread
+static GMutex log_rings_lock;
+static LogRing *log_rings;
+// Once 1 the rings are used, synchronous vsyslog() until then or if the
+// drain thread cannot start
+static volatile gint log_async;
+static volatile gint log_dropped_total;
+// The drain thread, woken up early by shutdown_log()
+static GThread *log_drain_thread;
+static GMutex log_drain_lock;
+static GCond log_drain_cond;
+static gboolean log_drain_stop;
+
+// Serializes the outputs between the drain thread and nx_gst_log_flush()
+static GMutex log_output_lock;
+static gint log_outputs = NX_GST_LOG_SYSLOG;
+static FILE *log_file;
+
+#ifdef DEBUG
+#define LOG_LEVEL_DEFAULT	(VBS_MSG ? NX_GST_LOG_VERBOSE : NX_GST_LOG_DEBUG)
+#else
+#define LOG_LEVEL_DEFAULT	NX_GST_LOG_INFO
+#endif
+
+// The call sites of one LOG_TAG
+typedef struct {
+	// Without its brackets
+	gchar			*name;
+	gint			level;
+	// Set by nx_gst_log_set_level(), the default does not apply
+	gboolean		own_level;
+	NX_GST_LOG_SITE	*sites;
+} LogCategory;
+
+// Guards the categories and the lists of their sites
+static GMutex log_levels_lock;
+// name -> LogCategory
+static GHashTable *log_categories;
+static gint log_default_level = LOG_LEVEL_DEFAULT;
+
+static void ring_thread_exit(gpointer data)
+{
+	LogRing *ring = (LogRing *)data;
+
+	g_atomic_int_set(&ring->closed, 1);
+}
+
+static LogRing *thread_ring(void)
+{
+	LogRing *ring = (LogRing *)g_private_get(&log_ring_key);
+
+	if (NULL == ring)
+	{
+		ring = (LogRing *)g_try_malloc0(sizeof(LogRing));
+		if (NULL == ring)
+			return NULL;
+
+		g_mutex_lock(&log_rings_lock);
+		ring->next = log_rings;
+		log_rings = ring;
+		g_mutex_unlock(&log_rings_lock);
+
+		g_private_set(&log_ring_key, ring);
+	}
+	return ring;
+}
+
+/* Parses the conversion at 'p', just after its '%'. Returns the character
+ * after it. */
+static const char *parse_spec(const char *p, LogSpec *spec)
+{
+	gint length = 0;
+
+	spec->start = p - 1;
+	spec->stars = 0;
+	spec->type = ARG_UNKNOWN;
+
+	while (*p && strchr("-+ #0'", *p))
+		p++;
+	if ('*' == *p) {
+		spec->stars++;
+		p++;
+	}
+	while (*p >= '0' && *p <= '9')
+		p++;
+	if ('.' == *p)
+	{
+		p++;
+		if ('*' == *p) {
+			spec->stars++;
+			p++;
+		}
+		while (*p >= '0' && *p <= '9')
+			p++;
+	}
+
+	// 'l' 1, 'll' 2, 'z' 3, 'L' 4, the others promoted to int
+	for (; *p && strchr("hlLqjzt", *p); p++)
+	{
+		if ('l' == *p)
+			length++;
+		else if ('q' == *p || 'j' == *p)
+			length = 2;
+		else if ('z' == *p || 't' == *p)
+			length = 3;
+		else if ('L' == *p)
+			length = 4;
+	}
+
+	switch (*p)
+	{
+		case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+			spec->type = (1 == length) ? ARG_LONG : (2 == length) ? ARG_LLONG :
+						(3 == length) ? ARG_SIZE : ARG_INT;
+			break;
+		case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+			spec->type = (4 == length) ? ARG_LDOUBLE : ARG_DOUBLE;
+			break;
+		case 'p':
+			spec->type = ARG_PTR;
+			break;
+		case 's':
+			// Wide strings are not copied
+			spec->type = (0 == length) ? ARG_STR : ARG_UNKNOWN;
+			break;
+		case 'm':
+			spec->type = ARG_ERRNO;
+			break;
+		case '%':
+			spec->type = ARG_NONE;
+			break;
+		default:
+			break;
+	}
+	if (*p)
+		p++;
+	spec->len = p - spec->start;
+
+	return p;
+}
+
+static gboolean put_bytes(LogRecord *rec, gsize *pos, const void *data, gsize size)
+{
+	if (*pos + size > sizeof(rec->data))
+		return FALSE;
+	memcpy(rec->data + *pos, data, size);
+	*pos += size;
+	return TRUE;
+}
+
+/* Copies the arguments of 'format' into 'rec'. FALSE if one is not known or
+ * they do not fit, 'ap' is then left in any state. */
+static gboolean copy_args(LogRecord *rec, const char *format, va_list ap)
+{
+	gsize pos = 0;
+	const char *p = format;
+
+	while (NULL != (p = strchr(p, '%')))
+	{
+		LogSpec spec;
+
+		p = parse_spec(p + 1, &spec);
+
+		for (gint i = 0; i < spec.stars; i++)
+		{
+			gint star = va_arg(ap, int);
+			if (!put_bytes(rec, &pos, &star, sizeof(star)))
+				return FALSE;
+		}
+
+		switch (spec.type)
+		{
+			case ARG_NONE:
+			case ARG_ERRNO:
+				break;
+			case ARG_INT:
+			case ARG_LONG:
+			case ARG_LLONG:
+			case ARG_SIZE:
+			{
+				gint64 value = (ARG_INT == spec.type) ? va_arg(ap, int) :
+							(ARG_LONG == spec.type) ? va_arg(ap, long) :
+							(ARG_LLONG == spec.type) ? (gint64)va_arg(ap, long long) :
+							(gint64)va_arg(ap, size_t);
+				if (!put_bytes(rec, &pos, &value, sizeof(value)))
+					return FALSE;
+				break;
+			}
+			case ARG_DOUBLE:
+			case ARG_LDOUBLE:
+			{
+				long double value = (ARG_DOUBLE == spec.type) ? va_arg(ap, double) :
+									va_arg(ap, long double);
+				if (!put_bytes(rec, &pos, &value, sizeof(value)))
+					return FALSE;
+				break;
+			}
+			case ARG_PTR:
+			{
+				void *value = va_arg(ap, void *);
+				if (!put_bytes(rec, &pos, &value, sizeof(value)))
+					return FALSE;
+				break;
+			}
+			case ARG_STR:
+			{
+				const char *str = va_arg(ap, const char *);
+				gsize left = sizeof(rec->data) - pos;
+				gsize len;
+
+				if (NULL == str)
+					str = "(null)";
+				// Cut to the room left rather than dropping the record
+				len = strnlen(str, left);
+				if (0 == left)
+					return FALSE;
+				if (len == left)
+					len--;
+				memcpy(rec->data + pos, str, len);
+				rec->data[pos + len] = '\0';
+				pos += len + 1;
+				break;
+			}
+			default:
+				return FALSE;
+		}
+	}
+	rec->header.size = (guint16)pos;
+
+	return TRUE;
+}
+
+static void write_record(gint priority, const char *format, va_list ap)
+{
+	LogRing *ring;
+	LogRecord *rec;
+	gint head;
+	va_list args;
+
+	if (!g_atomic_int_get(&log_async) || NULL == (ring = thread_ring()))
+	{
+		vsyslog(priority, format, ap);
+		return;
+	}
+
+	head = ring->head;
+	if ((guint)(head - g_atomic_int_get(&ring->tail)) >= LOG_RING_SLOTS)
+	{
+		g_atomic_int_inc(&ring->dropped);
+		return;
+	}
+
+	rec = &ring->records[(guint)head % LOG_RING_SLOTS];
+	rec->header.format = format;
+	rec->header.time_usec = g_get_real_time();
+	rec->header.priority = priority;
+	rec->header.saved_errno = errno;
+	rec->header.kind = LOG_RECORD_ARGS;
+
+	va_copy(args, ap);
+	if (!copy_args(rec, format, args))
+	{
+		gint len = vsnprintf((char *)rec->data, sizeof(rec->data), format, ap);
+
+		rec->header.kind = LOG_RECORD_TEXT;
+		rec->header.size = (guint16)MIN(MAX(len, 0), (gint)sizeof(rec->data) - 1);
+	}
+	va_end(args);
+
+	// Publishes the record to the drain thread
+	g_atomic_int_set(&ring->head, head + 1);
+}
+
+static const guint8 *get_bytes(const guint8 *data, void *value, gsize size)
+{
+	memcpy(value, data, size);
+	return data + size;
+}
+
+// snprintf() of one conversion and the '*' width and precision before it
+#define FORMAT_SPEC(buf, size, spec, stars, star, value)						\
+	((2 == (stars)) ? snprintf(buf, size, spec, star[0], star[1], value) :	\
+	(1 == (stars)) ? snprintf(buf, size, spec, star[0], value) :			\
+	snprintf(buf, size, spec, value))
+
+static gsize format_record(const LogRecord *rec, char *line, gsize size)
+{
+	const char *p = rec->header.format;
+	const guint8 *data = rec->data;
+	gsize len = 0;
+
+	if (LOG_RECORD_TEXT == rec->header.kind)
+		return (gsize)g_strlcpy(line, (const char *)rec->data, size);
+
+	while (*p && len < size - 1)
+	{
+		const char *next = strchr(p, '%');
+		gchar spec_str[LOG_SPEC_MAX];
+		gint star[2] = { 0, 0 };
+		LogSpec spec;
+		gint n = 0;
+
+		if (NULL == next)
+			next = p + strlen(p);
+		n = MIN((gsize)(next - p), size - 1 - len);
+		memcpy(line + len, p, n);
+		len += n;
+		if ('\0' == *next)
+			break;
+
+		p = parse_spec(next + 1, &spec);
+		g_strlcpy(spec_str, spec.start, MIN(spec.len + 1, sizeof(spec_str)));
+		for (gint i = 0; i < spec.stars; i++)
+			data = get_bytes(data, &star[i], sizeof(gint));
+
+		n = 0;
+		switch (spec.type)
+		{
+			case ARG_NONE:
+				n = snprintf(line + len, size - len, "%%");
+				break;
+			case ARG_ERRNO:
+				n = snprintf(line + len, size - len, "%s", g_strerror(rec->header.saved_errno));
+				break;
+			case ARG_INT:
+			{
+				gint64 value;
+				data = get_bytes(data, &value, sizeof(value));
+				n = FORMAT_SPEC(line + len, size - len, spec_str, spec.stars, star, (int)value);
+				break;
+			}
+			case ARG_LONG:
+			{
+				gint64 value;
+				data = get_bytes(data, &value, sizeof(value));
+				n = FORMAT_SPEC(line + len, size - len, spec_str, spec.stars, star, (long)value);
+				break;
+			}
+			case ARG_LLONG:
+			{
+				gint64 value;
+				data = get_bytes(data, &value, sizeof(value));
+				n = FORMAT_SPEC(line + len, size - len, spec_str, spec.stars, star,
+								(long long)value);
+				break;
+			}
+			case ARG_SIZE:
+			{
+				gint64 value;
+				data = get_bytes(data, &value, sizeof(value));
+				n = FORMAT_SPEC(line + len, size - len, spec_str, spec.stars, star,
+								(size_t)value);
+				break;
+			}
+			case ARG_DOUBLE:
+			{
+				long double value;
+				data = get_bytes(data, &value, sizeof(value));
+				n = FORMAT_SPEC(line + len, size - len, spec_str, spec.stars, star,
+								(double)value);
+				break;
+			}
+			case ARG_LDOUBLE:
+			{
+				long double value;
+				data = get_bytes(data, &value, sizeof(value));
+				n = FORMAT_SPEC(line + len, size - len, spec_str, spec.stars, star, value);
+				break;
+			}
+			case ARG_PTR:
+			{
+				void *value;
+				data = get_bytes(data, &value, sizeof(value));
+				n = FORMAT_SPEC(line + len, size - len, spec_str, spec.stars, star, value);
+				break;
+			}
+			case ARG_STR:
+			{
+				const char *value = (const char *)data;
+				data += strlen(value) + 1;
+				n = FORMAT_SPEC(line + len, size - len, spec_str, spec.stars, star, value);
+				break;
+			}
+			default:
+				break;
+		}
+		len += MIN((gsize)MAX(n, 0), size - 1 - len);
+	}
+	line[len] = '\0';
+
+	return len;
+}
+
+// Under log_output_lock
+static void output_line(gint priority, gint64 time_usec, const char *line)
+{
+	if (log_outputs & NX_GST_LOG_SYSLOG)
+		syslog(priority, "%s", line);
+
+	if (log_outputs & (NX_GST_LOG_STDERR | NX_GST_LOG_FILE))
+	{
+		GDateTime *dt = g_date_time_new_from_unix_local(time_usec / G_USEC_PER_SEC);
+		gchar *stamp = dt ? g_date_time_format(dt, "%m-%d %H:%M:%S") : NULL;
+
+		// The line tells its level, "[Tag]/I"
+		if (log_outputs & NX_GST_LOG_STDERR)
+			fprintf(stderr, "%s.%06d %s\n", stamp ? stamp : "",
+					(gint)(time_usec % G_USEC_PER_SEC), line);
+		if ((log_outputs & NX_GST_LOG_FILE) && log_file)
+			fprintf(log_file, "%s.%06d %s\n", stamp ? stamp : "",
+					(gint)(time_usec % G_USEC_PER_SEC), line);
+		g_free(stamp);
+		if (dt)
+			g_date_time_unref(dt);
+	}
+}
+
+/* Writes out what the rings hold, oldest record first across the rings, and
+ * frees the rings of the threads that are gone. Returns the records written. */
+static gint drain_rings(void)
+{
+	char line[LOG_LINE_MAX];
+	LogRing *rings;
+	gint dropped = 0;
+	gint count = 0;
+
+	g_mutex_lock(&log_output_lock);
+
+	// The rings after the head are only unlinked by this thread
+	g_mutex_lock(&log_rings_lock);
+	rings = log_rings;
+	g_mutex_unlock(&log_rings_lock);
+
+	while (TRUE)
+	{
+		LogRing *oldest = NULL;
+		const LogRecord *rec;
+		gint64 oldest_time = G_MAXINT64;
+
+		for (LogRing *ring = rings; ring; ring = ring->next)
+		{
+			gint tail = ring->tail;
+
+			if (tail != g_atomic_int_get(&ring->head))
+			{
+				rec = &ring->records[(guint)tail % LOG_RING_SLOTS];
+				if (rec->header.time_usec < oldest_time)
+				{
+					oldest_time = rec->header.time_usec;
+					oldest = ring;
+				}
+			}
+		}
+		if (NULL == oldest)
+			break;
+
+		rec = &oldest->records[(guint)oldest->tail % LOG_RING_SLOTS];
+		format_record(rec, line, sizeof(line));
+		output_line(rec->header.priority, rec->header.time_usec, line);
+		// Gives the slot back to the producer
+		g_atomic_int_set(&oldest->tail, oldest->tail + 1);
+		count++;
+	}
+
+	for (LogRing *ring = rings, *prev = NULL, *next; ring; ring = next)
+	{
+		next = ring->next;
+		if (g_atomic_int_get(&ring->dropped))
+			dropped += g_atomic_int_and(&ring->dropped, 0);
+
+		if (g_atomic_int_get(&ring->closed) && ring->tail == g_atomic_int_get(&ring->head))
+		{
+			g_mutex_lock(&log_rings_lock);
+			if (prev)
+			{
+				prev->next = next;
+			}
+			else
+			{
+				// New rings may have been pushed in front of it
+				LogRing **link = &log_rings;
+				while (*link != ring)
+					link = &(*link)->next;
+				*link = next;
+			}
+			g_mutex_unlock(&log_rings_lock);
+			g_free(ring);
+			continue;
+		}
+		prev = ring;
+	}
+
+	if (dropped > 0)
+	{
+		g_atomic_int_add(&log_dropped_total, dropped);
+		g_snprintf(line, sizeof(line), "[NX_GstLog] %d log records dropped, %d in total",
+					dropped, g_atomic_int_get(&log_dropped_total));
+		output_line(LOG_WARNING, g_get_real_time(), line);
+	}
+	if (log_file && count > 0)
+		fflush(log_file);
+
+	g_mutex_unlock(&log_output_lock);
+
+	return count;
+}
+
+static gpointer drain_main(gpointer data)
+{
+	gint64 period = LOG_DRAIN_PERIOD;
+	gboolean stop = FALSE;
+
+	(void)data;
+
+	while (!stop)
+	{
+		gint64 end_time;
+
+		if (drain_rings() > 0)
+			period = LOG_DRAIN_PERIOD;
+		else
+			period = MIN(period * 2, LOG_DRAIN_IDLE);
+
+		end_time = g_get_monotonic_time() + period;
+		g_mutex_lock(&log_drain_lock);
+		while (!log_drain_stop && g_cond_wait_until(&log_drain_cond, &log_drain_lock, end_time))
+			;
+		stop = log_drain_stop;
+		g_mutex_unlock(&log_drain_lock);
+	}
+
+	return NULL;
+}
+
+/* At exit and when the library is unloaded: stops the drain thread and
+ * writes out what is left. An atexit() handler would be called after a
+ * dlclose(), with the library unmapped. The records logged from now on
+ * are synchronous. */
+static void __attribute__((destructor)) shutdown_log(void)
+{
+	if (NULL == log_drain_thread)
+		return;
+
+	g_atomic_int_set(&log_async, 0);
+
+	g_mutex_lock(&log_drain_lock);
+	log_drain_stop = TRUE;
+	g_cond_signal(&log_drain_cond);
+	g_mutex_unlock(&log_drain_lock);
+	g_thread_join(log_drain_thread);
+	log_drain_thread = NULL;
+
+	drain_rings();
+
+	g_mutex_lock(&log_output_lock);
+	if (log_file)
+	{
+		fclose(log_file);
+		log_file = NULL;
+	}
+	g_mutex_unlock(&log_output_lock);
+}
+
+/* NX_GST_LOG_OUTPUT lists the outputs, separated by ',': "syslog",
+ * "stderr", or a file path. "sync" keeps the logs synchronous. */
+static gpointer init_log(gpointer data)
+{
+	const gchar *env = g_getenv("NX_GST_LOG_OUTPUT");
+	gboolean sync = FALSE;
+
+	(void)data;
+
+	if (env)
+	{
+		gchar **names = g_strsplit(env, ",", -1);
+		gint outputs = 0;
+
+		for (gint i = 0; names[i]; i++)
+		{
+			gchar *name = g_strstrip(names[i]);
+
+			if (!strcmp(name, "syslog"))
+				outputs |= NX_GST_LOG_SYSLOG;
+			else if (!strcmp(name, "stderr"))
+				outputs |= NX_GST_LOG_STDERR;
+			else if (!strcmp(name, "sync"))
+				sync = TRUE;
+			else if (*name && NULL == log_file && NULL != (log_file = fopen(name, "a")))
+				outputs |= NX_GST_LOG_FILE;
+		}
+		g_strfreev(names);
+		if (outputs)
+			log_outputs = outputs;
+	}
+
+	if (!sync && NULL != (log_drain_thread = g_thread_try_new("NxGstLog", drain_main, NULL, NULL)))
+		g_atomic_int_set(&log_async, 1);
+
+	return NULL;
+}
+
+static gint parse_level(const gchar *str)
+{
+	static const char *const names[] = { "none", "error", "warn", "info", "debug", "verbose" };
+
+	for (gint i = 0; i < (gint)G_N_ELEMENTS(names); i++)
+	{
+		if (!g_ascii_strcasecmp(str, names[i]))
+			return i;
+	}
+	if (g_ascii_isdigit(*str))
+		return CLAMP(atoi(str), NX_GST_LOG_NONE, NX_GST_LOG_VERBOSE);
+
+	return -1;
+}
+
+// "[NX_GstThumbnail]" and "NX_GstThumbnail" are the same tag
+static gchar *category_name(const gchar *tag)
+{
+	gsize len;
+
+	if ('[' == *tag)
+		tag++;
+	len = strlen(tag);
+	if (len > 0 && ']' == tag[len - 1])
+		len--;
+
+	return g_strndup(tag, len);
+}
+
+static void free_category(gpointer data)
+{
+	LogCategory *category = (LogCategory *)data;
+
+	g_free(category->name);
+	g_free(category);
+}
+
+// Under log_levels_lock
+static LogCategory *get_category(const gchar *tag)
+{
+	gchar *name = category_name(tag);
+	LogCategory *category = (LogCategory *)g_hash_table_lookup(log_categories, name);
+
+	if (NULL == category)
+	{
+		category = g_new0(LogCategory, 1);
+		category->name = name;
+		category->level = log_default_level;
+		g_hash_table_insert(log_categories, category->name, category);
+	}
+	else
+	{
+		g_free(name);
+	}
+	return category;
+}
+
+// Under log_levels_lock
+static void set_category_level(LogCategory *category, gint level)
+{
+	category->level = level;
+	for (NX_GST_LOG_SITE *site = category->sites; site; site = site->next)
+		__atomic_store_n(&site->level, level, __ATOMIC_RELAXED);
+}
+
+/* NX_GST_LOG_LEVEL is a list separated by ',' of "level" for the default
+ * and of "tag:level", the levels by name or number. */
+static gpointer init_levels(gpointer data)
+{
+	const gchar *env = g_getenv("NX_GST_LOG_LEVEL");
+	gchar **items;
+
+	(void)data;
+
+	log_categories = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, free_category);
+	if (NULL == env)
+		return NULL;
+
+	items = g_strsplit(env, ",", -1);
+	for (gint i = 0; items[i]; i++)
+	{
+		gchar *item = g_strstrip(items[i]);
+		gchar *sep = strrchr(item, ':');
+		gint level = parse_level(sep ? sep + 1 : item);
+
+		if (level < 0)
+			continue;
+		if (NULL == sep)
+		{
+			log_default_level = level;
+		}
+		else
+		{
+			LogCategory *category;
+
+			*sep = '\0';
+			category = get_category(g_strstrip(item));
+			category->level = level;
+			category->own_level = TRUE;
+		}
+	}
+	g_strfreev(items);
+
+	return NULL;
+}
+
+static void ensure_levels(void)
+{
+	static GOnce once = G_ONCE_INIT;
+
+	g_once(&once, init_levels, NULL);
+}
+
+int nx_gst_log_resolve(NX_GST_LOG_SITE *site, int level)
+{
+	ensure_levels();
+
+	g_mutex_lock(&log_levels_lock);
+	if (!site->registered)
+	{
+		LogCategory *category = get_category(site->tag);
+
+		site->next = category->sites;
+		category->sites = site;
+		site->registered = 1;
+		__atomic_store_n(&site->level, category->level, __ATOMIC_RELAXED);
+	}
+	g_mutex_unlock(&log_levels_lock);
+
+	return level <= site->level;
+}
+
+void nx_gst_log_set_level(const char *tag, int level)
+{
+	GHashTableIter iter;
+	gpointer value;
+
+	ensure_levels();
+	level = CLAMP(level, NX_GST_LOG_NONE, NX_GST_LOG_VERBOSE);
+
+	g_mutex_lock(&log_levels_lock);
+	if (tag)
+	{
+		LogCategory *category = get_category(tag);
+
+		category->own_level = TRUE;
+		set_category_level(category, level);
+	}
+	else
+	{
+		log_default_level = level;
+		g_hash_table_iter_init(&iter, log_categories);
+		while (g_hash_table_iter_next(&iter, NULL, &value))
+		{
+			if (!((LogCategory *)value)->own_level)
+				set_category_level((LogCategory *)value, level);
+		}
+	}
+	g_mutex_unlock(&log_levels_lock);
+}
+
+static void log_record(gint priority, const char *format, va_list ap)
+{
+	static GOnce once = G_ONCE_INIT;
+
+	g_once(&once, init_log, NULL);
+	write_record(priority, format, ap);
+}
 
 void nx_gst_info(const char *format, ...)
 {
@@ -32,7 +889,7 @@ void nx_gst_info(const char *format, ...)
 
 	va_start(ap, format);
 
-	vsyslog(LOG_INFO, format, ap);
+	log_record(LOG_INFO, format, ap);
 
 	va_end(ap);
 }
@@ -43,7 +900,7 @@ void nx_gst_warn(const char *format, ...)
 
 	va_start(ap, format);
 
-	vsyslog(LOG_WARNING, format, ap);
+	log_record(LOG_WARNING, format, ap);
 
 	va_end(ap);
 }
@@ -54,7 +911,7 @@ void nx_gst_error(const char *format, ...)
 
 	va_start(ap, format);
 
-	vsyslog(LOG_ERR, format, ap);
+	log_record(LOG_ERR, format, ap);
 
 	va_end(ap);
 }
@@ -65,7 +922,18 @@ void nx_gst_debug(const char *format, ...)
 
 	va_start(ap, format);
 
-	vsyslog(LOG_DEBUG, format, ap);
+	log_record(LOG_DEBUG, format, ap);
 
 	va_end(ap);
-}
\ No newline at end of file
+}
+
+void nx_gst_log_flush(void)
+{
+	if (g_atomic_int_get(&log_async))
+		drain_rings();
+}
+
+int nx_gst_log_dropped(void)
+{
+	return g_atomic_int_get(&log_dropped_total);
+}
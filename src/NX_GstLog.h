@@ -4,6 +4,7 @@
 
 #include <stdarg.h>
 #include <stdio.h>
+#include "NX_GstTypes.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -21,17 +22,62 @@ void nx_gst_warn(const char *format, ...);
 void nx_gst_error(const char *format, ...);
 void nx_gst_debug(const char *format, ...);
 
-#define NXGLOGI(fmt, arg...) do { \
-        nx_gst_info(LOG_TAG"/I %s() " fmt, __FUNCTION__, ## arg);   \
+/* The logs are written out by a thread of their own, see NX_GstLog.c.
+ * NX_GST_LOG_OUTPUT sets the outputs, e.g. "stderr,/tmp/player.log",
+ * syslog by default. */
+enum {
+	NX_GST_LOG_SYSLOG	= 1,
+	NX_GST_LOG_STDERR	= 2,
+	NX_GST_LOG_FILE		= 4,
+};
+
+// Writes out the logs not written yet, before an abort for instance
+void nx_gst_log_flush(void);
+// Logs dropped because the thread logged faster than they were written out
+int nx_gst_log_dropped(void);
+
+/*
+ * Each log call has a static NX_GST_LOG_SITE holding the level of its
+ * LOG_TAG, so a disabled log costs one load and one branch, its arguments
+ * are not evaluated. The level is resolved at the first call of the site,
+ * and updated by nx_gst_log_set_level() afterwards.
+ * NX_GST_LOG_LEVEL sets the levels at startup, a default then levels per
+ * tag, e.g. "warn,NX_GstThumbnail:debug,NxGstMediaInfo:0". The default is
+ * the most verbose level built in.
+ */
+#define NX_GST_LOG_UNRESOLVED	0x7fffffff
+
+typedef struct NX_GST_LOG_SITE {
+	volatile int			level;
+	const char				*tag;
+	struct NX_GST_LOG_SITE	*next;
+	int						registered;
+} NX_GST_LOG_SITE;
+
+// Registers 'site' with its tag, TRUE if 'level' is enabled
+int nx_gst_log_resolve(NX_GST_LOG_SITE *site, int level);
+/* Level of 'tag', with or without its brackets. A NULL tag sets the default
+ * of the tags without a level of their own. */
+void nx_gst_log_set_level(const char *tag, int level);
+
+#define NXGLOG_ENABLED(site, lvl)	\
+	((lvl) <= __atomic_load_n(&(site).level, __ATOMIC_RELAXED) &&	\
+	(NX_GST_LOG_UNRESOLVED != (site).level || nx_gst_log_resolve(&(site), (lvl))))
+
+#define NXGLOG_PRINT(lvl, func, fmt, arg...) do { \
+        static NX_GST_LOG_SITE _nx_log_site = { NX_GST_LOG_UNRESOLVED, LOG_TAG, NULL, 0 }; \
+        if (NXGLOG_ENABLED(_nx_log_site, lvl))	\
+            func(fmt, ## arg);	\
 } while (0)
 
-#define NXGLOGW(fmt, arg...) do { \
-        nx_gst_warn(LOG_TAG"/W %s() " fmt, __FUNCTION__, ## arg);   \
-} while (0)
+#define NXGLOGI(fmt, arg...) \
+        NXGLOG_PRINT(NX_GST_LOG_INFO, nx_gst_info, LOG_TAG"/I %s() " fmt, __FUNCTION__, ## arg)
 
-#define NXGLOGE(fmt, arg...) do { \
-        nx_gst_error(LOG_TAG"/E %s() " fmt, __FUNCTION__, ## arg);   \
-} while (0)
+#define NXGLOGW(fmt, arg...) \
+        NXGLOG_PRINT(NX_GST_LOG_WARN, nx_gst_warn, LOG_TAG"/W %s() " fmt, __FUNCTION__, ## arg)
+
+#define NXGLOGE(fmt, arg...) \
+        NXGLOG_PRINT(NX_GST_LOG_ERROR, nx_gst_error, LOG_TAG"/E %s() " fmt, __FUNCTION__, ## arg)
 
 #ifdef DEBUG
 
@@ -43,14 +89,12 @@ void nx_gst_debug(const char *format, ...);
 #define	FUNC_OUT()			do{}while(0)
 #endif	//	DBG_FUNCTION
 
-#define NXGLOGD(fmt, arg...) do { \
-        nx_gst_debug(LOG_TAG"/D %s() " fmt, __FUNCTION__, ## arg);   \
-} while (0)
+#define NXGLOGD(fmt, arg...) \
+        NXGLOG_PRINT(NX_GST_LOG_DEBUG, nx_gst_debug, LOG_TAG"/D %s() " fmt, __FUNCTION__, ## arg)
 
 #if VBS_MSG
-#define NXGLOGV(fmt, arg...) do { \
-        nx_gst_debug(LOG_TAG"/V %s() " fmt, __FUNCTION__, ## arg);   \
-} while (0)
+#define NXGLOGV(fmt, arg...) \
+        NXGLOG_PRINT(NX_GST_LOG_VERBOSE, nx_gst_debug, LOG_TAG"/V %s() " fmt, __FUNCTION__, ## arg)
 #else
 #define NXGLOGV(fmt, arg...)    do{}while(0)
 #endif
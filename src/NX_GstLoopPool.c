@@ -0,0 +1,181 @@
+//------------------------------------------------------------------------------
+//
+//	Copyright (C) 2015 Nexell Co. All Rights Reserved
+//	Nexell Co. Proprietary & Confidential
+//
+//	NEXELL INFORMS THAT THIS CODE AND INFORMATION IS PROVIDED "AS IS" BASE
+//  AND	WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING
+//  BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS
+//  FOR A PARTICULAR PURPOSE.
+//
+//	Module		: libnxgstvplayer.so
+//	File		: NX_GstLoopPool.c
+//	Description	: Shared GMainLoop threads for player handles and probe jobs
+//	Author		:
+//	Export		:
+//	History		:
+//
+//------------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <pthread.h>
+#include <glib.h>
+
+#include "NX_OMXSemaphore.h"
+#include "NX_GstLoopPool.h"
+#include "NX_GstLog.h"
+#define LOG_TAG "[NX_GstLoopPool]"
+
+#define NX_GST_VTHREAD   "NxGstVThread"
+
+struct LoopThread {
+    GMainContext    *context;
+    GMainLoop       *loop;
+    GThread         *thread;
+    // Number of handles attached to this thread
+    guint           users;
+};
+
+static GMutex pool_lock;
+static struct LoopThread pool[LOOP_POOL_MAX_THREADS];
+static guint pool_size = LOOP_POOL_DEFAULT_THREADS;
+
+static GPrivate probe_context = G_PRIVATE_INIT((GDestroyNotify)g_main_context_unref);
+
+static gpointer loop_thread_main(gpointer data)
+{
+    struct LoopThread *lt = (struct LoopThread *)data;
+
+    NXGLOGI("START");
+
+    g_main_context_push_thread_default(lt->context);
+    g_main_loop_run(lt->loop);
+    g_main_context_pop_thread_default(lt->context);
+
+    NXGLOGI("END");
+
+    return NULL;
+}
+
+/* Only newly acquired contexts follow the new size, the threads which are
+ * already running keep serving their handles. */
+void NX_SetLoopPoolSize(guint threads)
+{
+    g_mutex_lock(&pool_lock);
+    pool_size = CLAMP(threads, 1, LOOP_POOL_MAX_THREADS);
+    g_mutex_unlock(&pool_lock);
+}
+
+GMainContext *NX_AcquireLoopContext(void)
+{
+    struct LoopThread *lt = NULL;
+    GMainContext *context;
+    guint i;
+
+    g_mutex_lock(&pool_lock);
+    // The least loaded thread, an idle running thread before a new one
+    for (i = 0; i < pool_size; i++)
+    {
+        if (NULL == lt || pool[i].users < lt->users ||
+            (pool[i].users == lt->users && pool[i].thread && !lt->thread))
+        {
+            lt = &pool[i];
+        }
+    }
+
+    if (NULL == lt->thread)
+    {
+        lt->context = g_main_context_new();
+        lt->loop = g_main_loop_new(lt->context, FALSE);
+        lt->thread = g_thread_new(NX_GST_VTHREAD, loop_thread_main, lt);
+        NXGLOGI("Started loop thread %d", (int)(lt - pool));
+    }
+    lt->users++;
+    context = g_main_context_ref(lt->context);
+    g_mutex_unlock(&pool_lock);
+
+    return context;
+}
+
+void NX_ReleaseLoopContext(GMainContext *context)
+{
+    guint i;
+
+    if (NULL == context)
+        return;
+
+    g_mutex_lock(&pool_lock);
+    for (i = 0; i < LOOP_POOL_MAX_THREADS; i++)
+    {
+        if (pool[i].context == context && pool[i].users > 0)
+        {
+            pool[i].users--;
+            break;
+        }
+    }
+    g_mutex_unlock(&pool_lock);
+
+    g_main_context_unref(context);
+}
+
+static gboolean sync_loop_cb(gpointer data)
+{
+    NX_PostSem((NX_SEMAPHORE *)data);
+
+    return G_SOURCE_REMOVE;
+}
+
+/* A context dispatches on its thread one source at a time, so once this idle
+ * runs nothing attached before it can still be running. */
+void NX_SyncLoopContext(GMainContext *context)
+{
+    NX_SEMAPHORE *sem;
+    GSource *source;
+
+    if (NULL == context || g_main_context_is_owner(context))
+        return;
+
+    sem = NX_CreateSem(0, 1);
+    source = g_idle_source_new();
+    g_source_set_priority(source, G_PRIORITY_HIGH);
+    g_source_set_callback(source, sync_loop_cb, sem, NULL);
+    g_source_attach(source, context);
+    g_source_unref(source);
+
+    NX_PendSem(sem);
+    NX_DestroySem(sem);
+}
+
+GMainContext *NX_AcquireProbeContext(void)
+{
+    GMainContext *context = (GMainContext *)g_private_get(&probe_context);
+
+    if (NULL == context)
+    {
+        context = g_main_context_new();
+        g_private_set(&probe_context, context);
+    }
+    g_main_context_push_thread_default(context);
+
+    return context;
+}
+
+void NX_ReleaseProbeContext(GMainContext *context, guint watch_id)
+{
+    if (watch_id > 0)
+    {
+        GSource *source = g_main_context_find_source_by_id(context, watch_id);
+        if (source)
+            g_source_destroy(source);
+    }
+
+    // Leftovers such as a second quit request must not reach the next job
+    while (g_main_context_pending(context))
+    {
+        g_main_context_iteration(context, FALSE);
+    }
+    g_main_context_pop_thread_default(context);
+}
@@ -0,0 +1,57 @@
+//------------------------------------------------------------------------------
+//
+//	Copyright (C) 2015 Nexell Co. All Rights Reserved
+//	Nexell Co. Proprietary & Confidential
+//
+//	NEXELL INFORMS THAT THIS CODE AND INFORMATION IS PROVIDED "AS IS" BASE
+//  AND	WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING
+//  BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS
+//  FOR A PARTICULAR PURPOSE.
+//
+//	Module		: libnxgstvplayer.so
+//	File		: NX_GstLoopPool.h
+//	Description	: Shared GMainLoop threads for player handles and probe jobs
+//	Author		:
+//	Export		:
+//	History		:
+//
+//------------------------------------------------------------------------------
+
+#ifndef __NX_GSTLOOPPOOL_H
+#define __NX_GSTLOOPPOOL_H
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif	//	__cplusplus
+
+#define LOOP_POOL_DEFAULT_THREADS   2
+#define LOOP_POOL_MAX_THREADS       8
+
+/*
+ * Player handles share a few loop threads instead of running one each.
+ * A handle attaches its own sources to the context it acquired and must
+ * destroy them, then call NX_SyncLoopContext(), before releasing it.
+ * The threads are started on demand and live until the process exits.
+ */
+void NX_SetLoopPoolSize(guint threads);
+GMainContext *NX_AcquireLoopContext(void);
+void NX_ReleaseLoopContext(GMainContext *context);
+// Returns once the loop thread has finished the dispatch in progress, if any
+void NX_SyncLoopContext(GMainContext *context);
+
+/*
+ * Probe jobs run their own GMainLoop on the calling thread. The context is
+ * created once per thread and pushed as the thread default until released.
+ * The release removes the bus watch 'watch_id' (0 if none) and dispatches
+ * whatever is still pending, so nothing of the job reaches the next one.
+ */
+GMainContext *NX_AcquireProbeContext(void);
+void NX_ReleaseProbeContext(GMainContext *context, guint watch_id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __NX_GSTLOOPPOOL_H
@@ -142,11 +142,7 @@ int32_t isSupportedContents(struct GST_MEDIA_INFO *media_handle,
 #endif
         )
     {
-#ifdef SW_V_DECODER
-        if (video_type > VIDEO_TYPE_FLV)
-#else
-        if (video_type >= VIDEO_TYPE_FLV)
-#endif
+        if (!IS_SUPPORTED_VIDEO_TYPE(video_type))
         {
             NXGLOGE("Not supported video type(%d)", video_type);
             return -1;
@@ -23,14 +23,41 @@
 #include "NX_GstIface.h"
 #include "NX_GstDiscover.h"
 #include "NX_GstThumbnail.h"
+#include "NX_GstThumbnailCache.h"
+#include "NX_GstPreviewTrack.h"
 #include "NX_GstMediaInfo.h"
+#include "NX_GstEventQueue.h"
+#include "NX_GstSubtitle.h"
+#include "NX_GstLoopPool.h"
+#include "NX_GstCapture.h"
 #include "NX_GstLog.h"
 #define LOG_TAG "[NxGstVPLAYER]"
 
-#define NX_GST_VTHREAD   "NxGstVThread"
-
 //------------------------------------------------------------------------------
 #define DEFAULT_STREAM_IDX       0
+// Maximum number of events waiting for the loop thread
+#define EVENT_QUEUE_SIZE        64
+// Queue slots which MP_EVENT_SUBTITLE_UPDATED can not take from the others
+#define EVENT_QUEUE_RESERVED    16
+// Maximum number of events dispatched in one loop iteration
+#define EVENT_DISPATCH_BATCH    16
+// Number of preallocated subtitle slots for SUBTITLE_DELIVERY_RING
+#define SUBTITLE_RING_SIZE      8
+// Initial text size of each subtitle slot, grown when a longer text arrives
+#define SUBTITLE_TEXT_SIZE      512
+// Longest wait between two position checks of an external subtitle, it
+// bounds the delay to catch up with seeks and rate changes
+#define SUBTITLE_POLL_US        (200 * 1000)
+// Default software video decoder settings, sized for 4-core Cortex-A53 parts
+#define SW_VDEC_SKIP_LOOP_FILTER_LATENESS   20
+#define SW_VDEC_SKIP_FRAME_LATENESS         60
+#define SW_VDEC_MAX_WIDTH                   1920
+#define SW_VDEC_MAX_HEIGHT                  1080
+// Step of the display rect transitions, about one frame at 60Hz
+#define DSP_ANIM_INTERVAL_MS    16
+// Longest wait for the decoder output to be idle before relinking it.
+// A prerolled sink holds the push in progress until PLAYING.
+#define VIDEO_RELINK_WAIT_US    (500 * 1000)
 
 // Function Prototype
 int32_t get_program_idx(MP_HANDLE handle, unsigned int program_number);
@@ -50,11 +77,16 @@ NX_GST_RET link_subtitle_elements(MP_HANDLE handle);
 NX_GST_RET link_elements(MP_HANDLE handle);
 
 NX_GST_RET link_display(MP_HANDLE handle, enum DISPLAY_TYPE type);
-void unlink_display(enum DISPLAY_TYPE type);
+void unlink_display(MP_HANDLE handle, enum DISPLAY_TYPE type);
 
 enum NX_MEDIA_STATE GstState2NxState(GstState state);
 static void start_loop_thread(MP_HANDLE handle);
 static void stop_my_thread(MP_HANDLE handle);
+static void start_ext_subtitle(MP_HANDLE handle);
+static void stop_ext_subtitle(MP_HANDLE handle);
+static void kick_ext_subtitle(MP_HANDLE handle);
+static void post_event(MP_HANDLE handle, enum NX_GST_EVENT type,
+                        unsigned int data, void *param);
 static gboolean gst_bus_callback(GstBus *bus, GstMessage *msg, MP_HANDLE handle);
 static NX_GST_RET seek_to_time (MP_HANDLE handle, gint64 time_nanoseconds);
 static gboolean switch_streams (MP_HANDLE handle);
@@ -63,19 +95,41 @@ static void stream_notify_cb (GstStreamCollection * collection, GstStream * stre
 static const char* get_nx_gst_error(NX_GST_ERROR error);
 //------------------------------------------------------------------------------
 
-// For video sinks
-static GList *primary_sinks;
-static GList *secondary_sinks;
-
 // tee_pad <--> queue <--> nxvideosink_hdmi
+// or, while it is the only display, video_src_pad <--> nxvideosink
 struct Sink
 {
     GstPad              *tee_pad;
     GstElement          *queue;
     GstElement          *nxvideosink;
+    // Linked to the decoder output, without tee_pad and queue
+    gboolean            direct;
     gboolean            removing;
     GstElement          *pipeline;
     GstElement          *tee;
+    MP_HANDLE           handle;
+    enum DISPLAY_TYPE   type;
+};
+
+// Display rect transition of NX_GSTMP_AnimateDisplayRect()
+struct DspAnimation
+{
+    gboolean            active;
+    struct DSP_RECT     from;
+    struct DSP_RECT     to;
+    // Last rect handed to the display
+    struct DSP_RECT     current;
+    gint64              start_time;
+    gint64              duration_us;
+};
+
+// A subtitle slot is owned by the application from MP_EVENT_SUBTITLE_UPDATED
+// until NX_GSTMP_ReleaseSubtitle() is called
+struct SubtitleSlot
+{
+    struct SUBTITLE_INFO info;
+    gsize               capacity;
+    volatile gint       in_use;
 };
 
 struct MOVIE_TYPE {
@@ -89,10 +143,22 @@ struct MOVIE_TYPE {
     GstElement  *video_parser;
     GstElement  *video_decoder;
     GstElement  *nxvideosink;
+    // Software decoder only: decoder <--> video_convert <--> video_scale <--> video_capsfilter
+    GstElement  *video_convert;
+    GstElement  *video_scale;
+    GstElement  *video_capsfilter;
 
     GstElement  *tee;
     GstElement  *tee_queue_primary;
     GstPad      *tee_primary_pad;
+    // Output of the video decode chain, linked to the nxvideosink of a single
+    // display, or to the tee for two displays or none
+    GstPad      *video_src_pad;
+
+    // Video src pad of the demuxer, and the probe dropping its buffers
+    // while no display is attached (DISPLAY_MODE_NONE)
+    GstPad      *demux_video_pad;
+    gulong      video_suspend_probe;
 
     // For Audio
     GstElement  *audio_queue;
@@ -117,8 +183,6 @@ struct MOVIE_TYPE {
     // Current playback rate
     gdouble     rate;
 
-    GMainLoop *loop;
-    GThread *thread;
     GstBus *bus;
     guint bus_watch_id;
 
@@ -145,6 +209,10 @@ struct MOVIE_TYPE {
     // For Video Mode (LCD/HDMI)
     enum DISPLAY_MODE display_mode;
 
+    // Video sinks (struct Sink) of each display
+    GList       *primary_sinks;
+    GList       *secondary_sinks;
+
     // For aspect ratio
     struct DSP_RECT	primary_dsp_rect;
     struct DSP_RECT	secondary_dsp_rect;
@@ -154,8 +222,62 @@ struct MOVIE_TYPE {
     //	Callback
     void (*callback)(void *, unsigned int EventType, unsigned int EventData, void* param);
     void *owner;
+
+    // Events waiting to be delivered to 'callback' from the loop thread
+    NX_EVENT_QUEUE *event_queue;
+    GSource     *event_source;
+    struct MP_EVENT_STATS event_stats;
+    gint64      total_latency_us;
+    volatile gint dropped_events[MP_EVENT_TYPE_NUM];
+
+    // Subtitle delivery
+    enum SUBTITLE_DELIVERY subtitle_delivery;
+    struct SubtitleSlot subtitle_ring[SUBTITLE_RING_SIZE];
+    guint       subtitle_ring_pos;
+
+    // External subtitle file, delivered from the loop thread instead of the
+    // subtitle branch. 'ext_subtitle' and 'ext_subtitle_cue' are protected
+    // by stateLock.
+    NX_SUBTITLE_TRACK *ext_subtitle;
+    GSource     *ext_subtitle_source;
+    gint        ext_subtitle_cue;
+
+    // Software video decoder
+    struct SW_VDEC_CONFIG sw_vdec_config;
+    // Moving average of the QoS lateness (ms) and current skip level,
+    // updated from the QoS events only
+    gint64      sw_vdec_lateness;
+    gint        sw_vdec_skip_level;
+
+    // Secondary display branch kept in READY on an idle tee pad, see
+    // NX_GSTMP_SetSecondaryStandby(). standby_sink is handed over under
+    // stateLock since it is parked again from a pad probe.
+    gboolean    secondary_standby;
+    struct Sink *standby_sink;
+    // How long the last link of the secondary display took
+    gint64      secondary_activation_us;
+
+    // Rect changes of the running nxvideosink, indexed by DISPLAY_TYPE.
+    // The first frame rendered after a change applies all of dst-x/y/w/h,
+    // so a frame never sees a half updated rect. Protected by stateLock,
+    // dsp_rect_dirty is also read alone from the frame probe.
+    struct DSP_RECT pending_dsp_rect[2];
+    volatile gint dsp_rect_dirty[2];
+    // Transitions stepped from the loop thread, protected by stateLock
+    struct DspAnimation dsp_anim[2];
+    GSource     *dsp_anim_source;
+
+    // Runs the conversions of NX_GSTMP_CaptureFrame(), created on first use
+    GThreadPool *capture_pool;
 } ;
 
+// GSource which runs on the loop thread on behalf of a player handle
+struct EventSource
+{
+    GSource     source;
+    MP_HANDLE   handle;
+};
+
 class _CAutoLock
 {
     public:
@@ -187,38 +309,154 @@ int32_t get_program_idx(MP_HANDLE handle, unsigned int program_number)
     return cur_pro_idx;
 }
 
-/* Main function for the background thread */
-static gpointer
-thread_loop (gpointer user_data)
+static struct SubtitleSlot* get_subtitle_slot(MP_HANDLE handle, struct SUBTITLE_INFO *info)
 {
-    NXGLOGI("START");
-    MP_HANDLE handle = (MP_HANDLE)user_data;
+    struct SubtitleSlot *slot = (struct SubtitleSlot *)info;
+
+    if ((slot >= &handle->subtitle_ring[0]) &&
+        (slot < &handle->subtitle_ring[SUBTITLE_RING_SIZE])) {
+        return slot;
+    }
+    return NULL;
+}
+
+static void release_subtitle_info(MP_HANDLE handle, struct SUBTITLE_INFO *info)
+{
+    struct SubtitleSlot *slot = get_subtitle_slot(handle, info);
+
+    if (slot)
+    {
+        g_atomic_int_set(&slot->in_use, 0);
+    }
+    else
+    {
+        g_free(info->subtitleText);
+        g_free(info);
+    }
+}
+
+static void free_event_param(MP_HANDLE handle, NX_EVENT *event)
+{
+    // The application never sees this event, so release what it would have freed
+    if (MP_EVENT_SUBTITLE_UPDATED == event->type && event->param)
+    {
+        release_subtitle_info(handle, (struct SUBTITLE_INFO *)event->param);
+    }
+    else if (MP_EVENT_FRAME_CAPTURED == event->type)
+    {
+        NX_FreeCapturedFrame((struct CAPTURE_FRAME *)event->param);
+    }
+}
 
-    //GMainContext *thread_main_context = g_main_context_ref(handle->context);
-    GMainContext *thread_main_context = handle->context;
+/* Queue an event for the application callback.
+ * It can be called from any thread including GStreamer streaming threads,
+ * the callback itself is always invoked from the loop thread. */
+static void post_event(MP_HANDLE handle, enum NX_GST_EVENT type,
+                        unsigned int data, void *param)
+{
+    NX_EVENT event;
+
+    event.type = (guint)type;
+    event.data = data;
+    event.param = param;
+    event.post_time = g_get_monotonic_time();
 
-    /* Set up the thread’s context and run it forever. */
-    g_main_context_push_thread_default (thread_main_context);
+    // Only the subtitle updates can be dropped, a newer one replaces them
+    // anyway. Terminal, state and capture events are never lost.
+    if (!NX_PushEvent(handle->event_queue, &event, (MP_EVENT_SUBTITLE_UPDATED == type)))
+    {
+        NXGLOGW("Event queue is full, drop the event(%d)", type);
+        g_atomic_int_inc(&handle->dropped_events[type]);
+        free_event_param(handle, &event);
+        return;
+    }
 
-    handle->loop = g_main_loop_new (thread_main_context, FALSE);
-    g_main_loop_run (handle->loop);
+    if (NULL != handle->context) {
+        g_main_context_wakeup(handle->context);
+    }
+}
 
-    /* Release */
-    g_main_loop_unref (handle->loop);
-    g_main_context_pop_thread_default (thread_main_context);
-    g_main_context_unref (thread_main_context);
+static void dispatch_events(MP_HANDLE handle)
+{
+    NX_EVENT event;
+    gint count = 0;
 
-    NXGLOGI("END");
+    while ((count < EVENT_DISPATCH_BATCH) && NX_PopEvent(handle->event_queue, &event))
+    {
+        gint64 latency = g_get_monotonic_time() - event.post_time;
 
-    return NULL;
+        pthread_mutex_lock(&handle->stateLock);
+        handle->event_stats.dispatched++;
+        handle->event_stats.last_latency_us = latency;
+        if (latency > handle->event_stats.max_latency_us) {
+            handle->event_stats.max_latency_us = latency;
+        }
+        handle->total_latency_us += latency;
+        pthread_mutex_unlock(&handle->stateLock);
+
+        if (handle->callback) {
+            handle->callback(NULL, event.type, event.data, event.param);
+        } else {
+            free_event_param(handle, &event);
+        }
+        count++;
+    }
+}
+
+static gboolean event_source_prepare(GSource *source, gint *timeout)
+{
+    MP_HANDLE handle = ((struct EventSource *)source)->handle;
+    gint depth = NX_GetEventQueueDepth(handle->event_queue);
+
+    *timeout = -1;
+
+    pthread_mutex_lock(&handle->stateLock);
+    if (depth > handle->event_stats.max_queue_depth) {
+        handle->event_stats.max_queue_depth = depth;
+    }
+    pthread_mutex_unlock(&handle->stateLock);
+
+    return (depth > 0);
+}
+
+static gboolean event_source_check(GSource *source)
+{
+    MP_HANDLE handle = ((struct EventSource *)source)->handle;
+
+    return (NX_GetEventQueueDepth(handle->event_queue) > 0);
+}
+
+static gboolean event_source_dispatch(GSource *source,
+                        GSourceFunc callback, gpointer user_data)
+{
+    dispatch_events(((struct EventSource *)source)->handle);
+
+    return G_SOURCE_CONTINUE;
 }
 
+static GSourceFuncs event_source_funcs = {
+    event_source_prepare,
+    event_source_check,
+    event_source_dispatch,
+    NULL,
+    NULL,
+    NULL
+};
+
+/* The handle runs on one of the shared loop threads, its sources are
+ * attached to the context of that thread. */
 static void start_loop_thread(MP_HANDLE handle)
 {
     NXGLOGI("START");
 
-    handle->context = g_main_context_new();
-    handle->thread = g_thread_new(NX_GST_VTHREAD, thread_loop, handle);
+    handle->context = NX_AcquireLoopContext();
+
+    // Application callbacks are delivered from this thread
+    handle->event_source = g_source_new(&event_source_funcs, sizeof(struct EventSource));
+    ((struct EventSource *)handle->event_source)->handle = handle;
+    g_source_attach(handle->event_source, handle->context);
+
+    start_ext_subtitle(handle);
 
     NXGLOGI("END");
 }
@@ -227,13 +465,27 @@ static void stop_my_thread(MP_HANDLE handle)
 {
     NXGLOGI("START");
 
-    // Stops the GMainLoop
-    if (NULL != handle->loop) {
-        g_main_loop_quit(handle->loop);
+    if (NULL != handle->event_source) {
+        g_source_destroy(handle->event_source);
+        g_source_unref(handle->event_source);
+        handle->event_source = NULL;
     }
+    stop_ext_subtitle(handle);
 
-    if (NULL != handle->thread) {
-        g_thread_join(handle->thread);
+    pthread_mutex_lock(&handle->stateLock);
+    if (NULL != handle->dsp_anim_source) {
+        g_source_destroy(handle->dsp_anim_source);
+        g_source_unref(handle->dsp_anim_source);
+        handle->dsp_anim_source = NULL;
+    }
+    pthread_mutex_unlock(&handle->stateLock);
+
+    if (NULL != handle->context) {
+        // The other handles keep the thread running, wait for a callback of
+        // this handle which may still be in progress instead of joining it
+        NX_SyncLoopContext(handle->context);
+        NX_ReleaseLoopContext(handle->context);
+        handle->context = NULL;
     }
 
     NXGLOGI("END");
@@ -290,39 +542,91 @@ static void on_decodebin_pad_added(GstElement *element,
 }
 
 struct SUBTITLE_INFO* setSubtitleInfo(GstClockTime startTime, GstClockTime endTime,
-                                GstClockTime duration, const char* subtitle)
+                                GstClockTime duration, const char* subtitle, gsize size)
 {
     struct SUBTITLE_INFO* m_pSubtitleInfo = (struct SUBTITLE_INFO*) g_malloc0(sizeof(struct SUBTITLE_INFO));
 
     m_pSubtitleInfo->startTime = (gint64) startTime;
     m_pSubtitleInfo->endTime = (gint64) endTime;
     m_pSubtitleInfo->duration = (gint64) duration;
-    m_pSubtitleInfo->subtitleText = g_strdup(subtitle);
+    m_pSubtitleInfo->subtitleText = g_strndup(subtitle, size);
 
     NXGLOGI("subtitle:%s startTime:%" GST_TIME_FORMAT
             ", duration: %" GST_TIME_FORMAT ", endTime: %" GST_TIME_FORMAT,
-            subtitle, GST_TIME_ARGS(startTime),
+            m_pSubtitleInfo->subtitleText, GST_TIME_ARGS(startTime),
             GST_TIME_ARGS(duration), GST_TIME_ARGS(endTime));
 
     return m_pSubtitleInfo;
 }
 
+/* Fill a free slot of the subtitle ring without allocating memory.
+ * The text buffer of a slot only grows when a longer subtitle arrives. */
+static struct SUBTITLE_INFO* setSubtitleSlot(MP_HANDLE handle, GstClockTime startTime,
+                                GstClockTime endTime, GstClockTime duration,
+                                const char* subtitle, gsize size)
+{
+    struct SubtitleSlot *slot = NULL;
+
+    for (int i = 0; i < SUBTITLE_RING_SIZE; i++)
+    {
+        guint idx = (handle->subtitle_ring_pos + i) % SUBTITLE_RING_SIZE;
+        if (g_atomic_int_compare_and_exchange(&handle->subtitle_ring[idx].in_use, 0, 1))
+        {
+            slot = &handle->subtitle_ring[idx];
+            handle->subtitle_ring_pos = idx + 1;
+            break;
+        }
+    }
+    if (NULL == slot)
+    {
+        NXGLOGE("All subtitle slots are in use, drop the subtitle");
+        return NULL;
+    }
+
+    if (slot->capacity < size + 1)
+    {
+        gsize capacity = MAX(slot->capacity, SUBTITLE_TEXT_SIZE);
+        while (capacity < size + 1)
+            capacity <<= 1;
+        slot->info.subtitleText = (gchar *)g_realloc(slot->info.subtitleText, capacity);
+        slot->capacity = capacity;
+    }
+    memcpy(slot->info.subtitleText, subtitle, size);
+    slot->info.subtitleText[size] = '\0';
+
+    slot->info.startTime = (gint64) startTime;
+    slot->info.endTime = (gint64) endTime;
+    slot->info.duration = (gint64) duration;
+
+    NXGLOGV("subtitle:%s startTime:%" GST_TIME_FORMAT
+            ", duration: %" GST_TIME_FORMAT ", endTime: %" GST_TIME_FORMAT,
+            slot->info.subtitleText, GST_TIME_ARGS(startTime),
+            GST_TIME_ARGS(duration), GST_TIME_ARGS(endTime));
+
+    return &slot->info;
+}
+
 void on_handoff(GstElement* object, GstBuffer* buffer,
                 GstPad* pad, gpointer user_data)
 {
-    char text_msg[128];
     MP_HANDLE handle = (MP_HANDLE) user_data;
+    GstClockTime startTime, duration, endTime;
+    struct SUBTITLE_INFO* subtitleInfo;
+    GstMapInfo map;
 
-    gsize buffer_size, extracted_size;
-    memset(text_msg, 0, sizeof(text_msg));
-
-    buffer_size = gst_buffer_get_size(buffer);
+    // An external subtitle file replaces the embedded one
+    if (!handle || handle->ext_subtitle) {
+        return;
+    }
 
-    extracted_size = gst_buffer_extract(buffer, 0, text_msg, buffer_size);
-    NXGLOGV("Buffer Size is %zu, read %zu, data: %s",
-            buffer_size, extracted_size, text_msg);
+    // Read the text in place instead of copying it to a fixed size array
+    if (!gst_buffer_map(buffer, &map, GST_MAP_READ))
+    {
+        NXGLOGE("Failed to map the subtitle buffer");
+        return;
+    }
+    NXGLOGV("Buffer Size is %zu", map.size);
 
-    static GstClockTime startTime, duration, endTime;
     startTime = GST_BUFFER_PTS(buffer);
     duration = GST_BUFFER_DURATION(buffer);
     endTime = startTime + duration;
@@ -330,12 +634,142 @@ void on_handoff(GstElement* object, GstBuffer* buffer,
              ", endTime: %" GST_TIME_FORMAT, GST_TIME_ARGS(startTime),
              GST_TIME_ARGS(duration), GST_TIME_ARGS(endTime));
 
-    struct SUBTITLE_INFO* subtitleInfo = setSubtitleInfo(startTime, endTime, duration, text_msg);
+    if (SUBTITLE_DELIVERY_RING == handle->subtitle_delivery) {
+        subtitleInfo = setSubtitleSlot(handle, startTime, endTime, duration,
+                                    (const char*)map.data, map.size);
+    } else {
+        subtitleInfo = setSubtitleInfo(startTime, endTime, duration,
+                                    (const char*)map.data, map.size);
+    }
+    gst_buffer_unmap(buffer, &map);
+
+    if (subtitleInfo) {
+        post_event(handle, MP_EVENT_SUBTITLE_UPDATED, 0, subtitleInfo);
+    }
+}
 
-    handle = (MP_HANDLE)user_data;
-    if (handle) {
-        handle->callback(NULL, (int)MP_EVENT_SUBTITLE_UPDATED, 0, subtitleInfo);
+static void deliver_ext_subtitle(MP_HANDLE handle, const NX_SUBTITLE_CUE *cue)
+{
+    const gchar *text = handle->ext_subtitle->text + cue->text_offset;
+    struct SUBTITLE_INFO* subtitleInfo;
+
+    if (SUBTITLE_DELIVERY_RING == handle->subtitle_delivery) {
+        subtitleInfo = setSubtitleSlot(handle, cue->start, cue->end,
+                            cue->end - cue->start, text, cue->text_length);
+    } else {
+        subtitleInfo = setSubtitleInfo(cue->start, cue->end,
+                            cue->end - cue->start, text, cue->text_length);
+    }
+    if (subtitleInfo) {
+        post_event(handle, MP_EVENT_SUBTITLE_UPDATED, 0, subtitleInfo);
+    }
+}
+
+/* Looks up the cue at the current position of the pipeline clock and sleeps
+ * until the next cue boundary. Nothing is kept across calls but the last
+ * delivered cue, so seeks need no special handling. */
+static gboolean ext_subtitle_dispatch(GSource *source,
+                GSourceFunc callback, gpointer user_data)
+{
+    MP_HANDLE handle = ((struct EventSource *)source)->handle;
+    gint64 wait_us = SUBTITLE_POLL_US;
+    gint64 pos = -1, next = -1;
+    gboolean playing;
+
+    (void)callback;
+    (void)user_data;
+
+    playing = handle->pipeline && (GST_STATE(handle->pipeline) == GST_STATE_PLAYING);
+    if (handle->pipeline && GST_STATE(handle->pipeline) >= GST_STATE_PAUSED &&
+        gst_element_query_position(handle->pipeline, GST_FORMAT_TIME, &pos))
+    {
+        pthread_mutex_lock(&handle->stateLock);
+        if (handle->ext_subtitle) {
+            gint cue = NX_FindSubtitleCue(handle->ext_subtitle, pos, &next);
+            if (cue >= 0 && cue != handle->ext_subtitle_cue) {
+                deliver_ext_subtitle(handle, &handle->ext_subtitle->cues[cue]);
+            }
+            handle->ext_subtitle_cue = cue;
+        }
+        pthread_mutex_unlock(&handle->stateLock);
+
+        if (playing && next >= 0 && handle->rate > 0) {
+            // Wake up just after the boundary
+            wait_us = (gint64)((next - pos) / GST_USECOND / handle->rate) + 1000;
+            wait_us = CLAMP(wait_us, 1000, SUBTITLE_POLL_US);
+        }
+    }
+
+    g_source_set_ready_time(source, g_get_monotonic_time() + wait_us);
+
+    return G_SOURCE_CONTINUE;
+}
+
+static GSourceFuncs ext_subtitle_funcs = {
+    NULL,
+    NULL,
+    ext_subtitle_dispatch,
+    NULL,
+};
+
+static void start_ext_subtitle(MP_HANDLE handle)
+{
+    if (!handle->ext_subtitle || !handle->context || handle->ext_subtitle_source)
+        return;
+
+    handle->ext_subtitle_source = g_source_new(&ext_subtitle_funcs, sizeof(struct EventSource));
+    ((struct EventSource *)handle->ext_subtitle_source)->handle = handle;
+    g_source_set_ready_time(handle->ext_subtitle_source, 0);
+    g_source_attach(handle->ext_subtitle_source, handle->context);
+}
+
+static void stop_ext_subtitle(MP_HANDLE handle)
+{
+    if (NULL != handle->ext_subtitle_source) {
+        g_source_destroy(handle->ext_subtitle_source);
+        g_source_unref(handle->ext_subtitle_source);
+        handle->ext_subtitle_source = NULL;
+    }
+}
+
+// Re-evaluate the cue right away and deliver it again, e.g. after a seek
+static void kick_ext_subtitle(MP_HANDLE handle)
+{
+    if (NULL != handle->ext_subtitle_source) {
+        pthread_mutex_lock(&handle->stateLock);
+        handle->ext_subtitle_cue = -1;
+        pthread_mutex_unlock(&handle->stateLock);
+        g_source_set_ready_time(handle->ext_subtitle_source, 0);
+    }
+}
+
+// Replaces the external subtitle, NULL path removes it
+static NX_GST_RET set_ext_subtitle(MP_HANDLE handle, const char *subtitlePath)
+{
+    NX_SUBTITLE_TRACK *track = NULL, *old;
+
+    if (subtitlePath) {
+        track = NX_LoadSubtitleFile(subtitlePath);
+        if (NULL == track) {
+            return NX_GST_RET_ERROR;
+        }
+    }
+
+    pthread_mutex_lock(&handle->stateLock);
+    old = handle->ext_subtitle;
+    handle->ext_subtitle = track;
+    handle->ext_subtitle_cue = -1;
+    pthread_mutex_unlock(&handle->stateLock);
+    NX_FreeSubtitleTrack(old);
+
+    if (track) {
+        start_ext_subtitle(handle);
+        kick_ext_subtitle(handle);
+    } else {
+        stop_ext_subtitle(handle);
     }
+
+    return NX_GST_RET_OK;
 }
 
 NX_GST_RET set_subtitle_elements(MP_HANDLE handle)
@@ -391,13 +825,84 @@ static GstPadProbeReturn cb_have_data (GstPad          *pad,
 
     handle = (MP_HANDLE)user_data;
     if (handle) {
-        handle->callback(NULL, (int)MP_EVENT_SUBTITLE_UPDATED, 0, 0);
+        post_event(handle, MP_EVENT_SUBTITLE_UPDATED, 0, NULL);
     }
 
     return GST_PAD_PROBE_OK;
 }
 #endif
 
+static GstPadProbeReturn drop_video_probe(GstPad *pad, GstPadProbeInfo *info,
+                gpointer user_data)
+{
+    (void)pad;
+    (void)info;
+    (void)user_data;
+
+    return GST_PAD_PROBE_DROP;
+}
+
+/* Stops feeding the video branch while no display is attached.
+ * Buffers are dropped at the demuxer so that the parser and the decoder go
+ * idle once video_queue is drained and the decoder frames are released by
+ * the tee. The branch is not flushed: a FLUSHING return would reach the
+ * demuxer and stop audio as well. */
+static void suspend_video(MP_HANDLE handle)
+{
+    if (NULL == handle->demux_video_pad || 0 != handle->video_suspend_probe) {
+        return;
+    }
+
+    handle->video_suspend_probe = gst_pad_add_probe(handle->demux_video_pad,
+            (GstPadProbeType)(GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST),
+            drop_video_probe, handle, NULL);
+    NXGLOGI("Video decoding is suspended");
+}
+
+// Feeds the video branch again, from the keyframe before the current position
+static void resume_video(MP_HANDLE handle)
+{
+    gint64 position;
+
+    if (0 == handle->video_suspend_probe) {
+        return;
+    }
+
+    gst_pad_remove_probe(handle->demux_video_pad, handle->video_suspend_probe);
+    handle->video_suspend_probe = 0;
+
+    int pIdx = handle->select_program_idx;
+    if (handle->gst_media_info.ProgramInfo[pIdx].seekable &&
+        gst_element_query_position(handle->pipeline, GST_FORMAT_TIME, &position))
+    {
+        gboolean res;
+
+        // In reverse playback the segment ends at the position, see send_seek_event()
+        if (handle->rate > 0)
+        {
+            res = gst_element_seek(handle->pipeline, handle->rate, GST_FORMAT_TIME,
+                        (GstSeekFlags)(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT),
+                        GST_SEEK_TYPE_SET, position,
+                        GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE);
+        }
+        else
+        {
+            res = gst_element_seek(handle->pipeline, handle->rate, GST_FORMAT_TIME,
+                        (GstSeekFlags)(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT),
+                        GST_SEEK_TYPE_SET, 0,
+                        GST_SEEK_TYPE_SET, position);
+        }
+        if (!res)
+        {
+            NXGLOGE("Failed to seek to the keyframe before %" GST_TIME_FORMAT,
+                    GST_TIME_ARGS(position));
+        }
+        kick_ext_subtitle(handle);
+    }
+    // Otherwise the decoder resynchronizes on the next keyframe
+    NXGLOGI("Video decoding is resumed");
+}
+
 static void on_pad_added_demux(GstElement *element, 
                         GstPad *pad, gpointer data)
 {
@@ -460,7 +965,8 @@ static void on_pad_added_demux(GstElement *element,
     else if ((handle->gst_media_info.ProgramInfo[pIdx].n_subtitle >= 1) &&
             g_str_has_prefix(padName, "subtitle"))
     {
-        if ((handle->select_subtitle_idx == handle->current_subtitle_idx) &&
+        if ((NULL != handle->subtitle_queue) &&
+            (handle->select_subtitle_idx == handle->current_subtitle_idx) &&
             (handle->gst_media_info.ProgramInfo[pIdx].SubtitleInfo[handle->select_subtitle_idx].type == SUBTITLE_TYPE_RAW)) {
             target_sink_element = handle->subtitle_queue;
         } else {
@@ -494,6 +1000,8 @@ static void on_pad_added_demux(GstElement *element,
             if (ret != GST_PAD_LINK_OK) {
                 gst_object_unref (sinkpad);
                 isLinkFailed = TRUE;
+            } else if (target_sink_element == handle->video_queue) {
+                handle->demux_video_pad = (GstPad *)gst_object_ref(pad);
             }
         }
         else
@@ -521,7 +1029,7 @@ static void on_pad_added_demux(GstElement *element,
     /* Need to check subtitle_1, 2, etc */
     if (TRUE == isLinkFailed)
     {
-        handle->callback(NULL, (int)MP_EVENT_DEMUX_LINK_FAILED, 0, NULL);
+        post_event(handle, MP_EVENT_DEMUX_LINK_FAILED, 0, NULL);
         return;
     }
 
@@ -541,6 +1049,10 @@ static void on_pad_added_demux(GstElement *element,
             link_display(handle, DISPLAY_TYPE_PRIMARY);
             link_display(handle, DISPLAY_TYPE_SECONDARY);
         }
+        else if (handle->display_mode == DISPLAY_MODE_NONE)
+        {
+            suspend_video(handle);
+        }
         else
         {
             NXGLOGE("Failed to link display");
@@ -637,7 +1149,7 @@ static gboolean gst_bus_callback(GstBus *bus, GstMessage *msg, MP_HANDLE handle)
     {
         case GST_MESSAGE_EOS:
             NXGLOGI("End-of-stream");
-            handle->callback(NULL, (int)MP_EVENT_EOS, 0, NULL);
+            post_event(handle, MP_EVENT_EOS, 0, NULL);
             break;
         case GST_MESSAGE_ERROR:
         case GST_MESSAGE_WARNING:
@@ -659,7 +1171,7 @@ static gboolean gst_bus_callback(GstBus *bus, GstMessage *msg, MP_HANDLE handle)
             g_free (debug);
 
             if (GST_MESSAGE_ERROR == GST_MESSAGE_TYPE (msg)) {
-                handle->callback(NULL, (int)MP_EVENT_GST_ERROR, 0, 0);
+                post_event(handle, MP_EVENT_GST_ERROR, 0, NULL);
             }
             break;
         }
@@ -678,7 +1190,7 @@ static gboolean gst_bus_callback(GstBus *bus, GstMessage *msg, MP_HANDLE handle)
                 if(g_strcmp0("NxGstMoviePlay", GST_OBJECT_NAME (msg->src)) == 0)
                 {
                     handle->state = new_state;
-                    handle->callback(NULL, (int)MP_EVENT_STATE_CHANGED, (int)GstState2NxState(new_state), NULL);
+                    post_event(handle, MP_EVENT_STATE_CHANGED, (int)GstState2NxState(new_state), NULL);
                 }
                 if (new_state == GST_STATE_PLAYING || new_state == GST_STATE_PAUSED)
                 {
@@ -802,6 +1314,68 @@ NX_GST_RET set_demux_element(MP_HANDLE handle)
     return NX_GST_RET_OK;
 }
 
+// Parser and decoders of the audio types which are linked statically.
+// Decoders are tried in order and the first available one is used.
+static const struct {
+    AUDIO_TYPE type;
+    const char *parser;
+    const char *decoders[3];
+} AUDIO_CHAIN[] = {
+    {AUDIO_TYPE_MPEG_V1,    "mpegaudioparse",   {"mpg123audiodec", "avdec_mp3", NULL}},
+    // audio/mpeg with mpegversion 2 or 4 is AAC, MP1/MP2/MP3 are all mpegversion 1
+    {AUDIO_TYPE_MPEG_V2,    "aacparse",         {"avdec_aac", "faad", NULL}},
+    {AUDIO_TYPE_AAC,        "aacparse",         {"avdec_aac", "faad", NULL}},
+    {AUDIO_TYPE_AC3,        "ac3parse",         {"a52dec", "avdec_ac3", NULL}},
+    {AUDIO_TYPE_AC3_PRI,    "ac3parse",         {"a52dec", "avdec_ac3", NULL}},
+    {AUDIO_TYPE_EAC3,       "ac3parse",         {"avdec_eac3", NULL, NULL}},
+    {AUDIO_TYPE_DTS,        "dcaparse",         {"dtsdec", "avdec_dca", NULL}},
+    {AUDIO_TYPE_DTS_PRI,    "dcaparse",         {"dtsdec", "avdec_dca", NULL}},
+    {AUDIO_TYPE_FLAC,       "flacparse",        {"flacdec", "avdec_flac", NULL}},
+    {AUDIO_TYPE_OGG,        "vorbisparse",      {"vorbisdec", "ivorbisdec", NULL}},
+    {AUDIO_TYPE_OPUS,       "opusparse",        {"opusdec", "avdec_opus", NULL}},
+    {AUDIO_TYPE_UNKNOWN,    NULL,               {NULL, NULL, NULL}},
+};
+
+// Creates handle->audio_parser and handle->audio_decoder from AUDIO_CHAIN.
+// Returns FALSE when decodebin has to be used instead.
+static gboolean make_audio_chain(MP_HANDLE handle, AUDIO_TYPE type)
+{
+    int idx, i;
+
+    for (idx = 0; AUDIO_CHAIN[idx].parser; idx++) {
+        if (AUDIO_CHAIN[idx].type == type)
+            break;
+    }
+    if (NULL == AUDIO_CHAIN[idx].parser) {
+        NXGLOGI("No static decode chain for audio type(%d)", type);
+        return FALSE;
+    }
+
+    for (i = 0; i < 3 && AUDIO_CHAIN[idx].decoders[i]; i++) {
+        handle->audio_decoder = gst_element_factory_make(AUDIO_CHAIN[idx].decoders[i],
+                                    AUDIO_CHAIN[idx].decoders[i]);
+        if (handle->audio_decoder)
+            break;
+    }
+    if (!handle->audio_decoder) {
+        NXGLOGE("Failed to create a decoder for audio type(%d)", type);
+        return FALSE;
+    }
+
+    handle->audio_parser = gst_element_factory_make(AUDIO_CHAIN[idx].parser,
+                                AUDIO_CHAIN[idx].parser);
+    if (!handle->audio_parser) {
+        NXGLOGE("Failed to create %s element", AUDIO_CHAIN[idx].parser);
+        gst_object_unref(handle->audio_decoder);
+        handle->audio_decoder = NULL;
+        return FALSE;
+    }
+
+    NXGLOGI("audio type(%d): %s ! %s", type,
+            AUDIO_CHAIN[idx].parser, GST_OBJECT_NAME(handle->audio_decoder));
+    return TRUE;
+}
+
 NX_GST_RET set_audio_elements(MP_HANDLE handle)
 {
     FUNC_IN();
@@ -817,23 +1391,11 @@ NX_GST_RET set_audio_elements(MP_HANDLE handle)
     int pIdx = handle->select_program_idx;
     int aIdx = handle->select_audio_idx;
     // Audio parser & Audio decoder
-    if ((handle->gst_media_info.ProgramInfo[pIdx].AudioInfo[aIdx].type == AUDIO_TYPE_MPEG_V1) ||
-        (handle->gst_media_info.ProgramInfo[pIdx].AudioInfo[aIdx].type == AUDIO_TYPE_MPEG_V2))
-    {
-        handle->audio_parser = gst_element_factory_make("mpegaudioparse", "mpegaudioparse");
-        if (!handle->audio_parser) {
-            NXGLOGE("Failed to create mpegaudioparse element");
-            return NX_GST_RET_ERROR;
-        }
-        // mpg123audiodec or avdec_mp3
-        handle->audio_decoder = gst_element_factory_make("mpg123audiodec", "mpg123audiodec");
-        if (!handle->audio_decoder) {
-            NXGLOGE("Failed to create mpg123audiodec element");
-            return NX_GST_RET_ERROR;
-        }
-    }
-    else
+    handle->audio_parser = NULL;
+    handle->audio_decoder = NULL;
+    if (!make_audio_chain(handle, handle->gst_media_info.ProgramInfo[pIdx].AudioInfo[aIdx].type))
     {
+        // Unknown type or missing plugin, let decodebin find a decoder
         handle->audio_decoder = gst_element_factory_make("decodebin", "decodebin");
         if (!handle->audio_decoder) {
             NXGLOGE("Failed to create decodebin element");
@@ -857,62 +1419,239 @@ NX_GST_RET set_audio_elements(MP_HANDLE handle)
     return NX_GST_RET_OK;
 }
 
-NX_GST_RET set_video_elements(MP_HANDLE handle)
+static gboolean has_property(GstElement *element, const char *name)
 {
-    FUNC_IN();
+    return (NULL != g_object_class_find_property(G_OBJECT_GET_CLASS(element), name));
+}
 
-    if (!handle) {
-        NXGLOGE("handle is NULL");
-        return NX_GST_RET_ERROR;
+#ifdef SW_V_DECODER
+// Parser and decoders of the software video decode chain.
+// Decoders are tried in order and the first available one is used.
+static const struct {
+    VIDEO_TYPE type;
+    const char *parser;
+    const char *decoders[2];
+} SW_VIDEO_CHAIN[] = {
+    {VIDEO_TYPE_H264,       "h264parse",        {"avdec_h264", NULL}},
+    {VIDEO_TYPE_H265,       "h265parse",        {"avdec_h265", NULL}},
+    {VIDEO_TYPE_H263,       "h263parse",        {"avdec_h263", NULL}},
+    {VIDEO_TYPE_MPEG_V1,    "mpegvideoparse",   {"avdec_mpeg2video", NULL}},
+    {VIDEO_TYPE_MPEG_V2,    "mpegvideoparse",   {"avdec_mpeg2video", NULL}},
+    {VIDEO_TYPE_MPEG_V4,    "mpeg4videoparse",  {"avdec_mpeg4", NULL}},
+    // mpeg4videoparse does not accept video/x-divx and video/x-xvid
+    {VIDEO_TYPE_DIVX,       NULL,               {"avdec_mpeg4", NULL}},
+    {VIDEO_TYPE_XVID,       NULL,               {"avdec_mpeg4", NULL}},
+    {VIDEO_TYPE_FLV,        NULL,               {"avdec_flv", NULL}},
+    {VIDEO_TYPE_THEORA,     "theoraparse",      {"theoradec", "avdec_theora"}},
+    {VIDEO_TYPE_VP9,        NULL,               {"avdec_vp9", "vp9dec"}},
+    {VIDEO_TYPE_UNKNOWN,    NULL,               {NULL, NULL}},
+};
+
+/* Skip levels of the software decoder:
+ * 0 decodes everything, 1 skips the loop filter, 2 also skips B-frames.
+ * A level is left when the lateness falls below half of its threshold. */
+static void set_sw_vdec_skip_level(MP_HANDLE handle, gint level)
+{
+    GstElement *decoder = handle->video_decoder;
+
+    if (has_property(decoder, "skip-loop-filter")) {
+        g_object_set(decoder, "skip-loop-filter", (level >= 1) ? 1 : 0, NULL);
+    }
+    if (has_property(decoder, "skip-frame")) {
+        // 0: Skip nothing, 1: Skip B-frames
+        g_object_set(decoder, "skip-frame", (level >= 2) ? 1 : 0, NULL);
     }
 
-    int pIdx = handle->select_program_idx;
-    int vIdx = handle->select_video_idx;
+    NXGLOGI("skip level %d -> %d (lateness %" G_GINT64_FORMAT "ms)",
+            handle->sw_vdec_skip_level, level, handle->sw_vdec_lateness);
+    handle->sw_vdec_skip_level = level;
+}
 
-    // Queue for video
-    handle->video_queue = gst_element_factory_make("queue2", "video_queue");
+static GstPadProbeReturn sw_vdec_qos_probe(GstPad *pad, GstPadProbeInfo *info,
+                gpointer user_data)
+{
+    MP_HANDLE handle = (MP_HANDLE)user_data;
+    GstEvent *event = GST_PAD_PROBE_INFO_EVENT(info);
+    struct SW_VDEC_CONFIG *config = &handle->sw_vdec_config;
+    GstQOSType type;
+    gdouble proportion;
+    GstClockTimeDiff diff;
+    GstClockTime timestamp;
+    gint level;
 
-    // Video Parser
-    if (handle->gst_media_info.ProgramInfo[pIdx].VideoInfo[vIdx].type == VIDEO_TYPE_H264)
-    {
-        handle->video_parser = gst_element_factory_make("h264parse", "parser");
-        if (!handle->video_parser) {
-            NXGLOGE("Failed to create h264parse element");
-            return NX_GST_RET_ERROR;
-        }
-    }
-    else if ((handle->gst_media_info.ProgramInfo[pIdx].VideoInfo[vIdx].type == VIDEO_TYPE_MPEG_V1) ||
-            (handle->gst_media_info.ProgramInfo[pIdx].VideoInfo[vIdx].type == VIDEO_TYPE_MPEG_V2))
-    {
-        handle->video_parser = gst_element_factory_make("mpegvideoparse", "parser");
-        if (!handle->video_parser) {
-            NXGLOGE("Failed to create mpegvideoparse element");
-            return NX_GST_RET_ERROR;
-        }
+    (void)pad;
+
+    if (GST_EVENT_TYPE(event) != GST_EVENT_QOS) {
+        return GST_PAD_PROBE_OK;
     }
 
-    // Video Decoder
-#ifdef SW_V_DECODER
-    if (handle->gst_media_info.ProgramInfo[pIdx].VideoInfo[vIdx].type == VIDEO_TYPE_FLV)
-    {
-        handle->video_decoder = gst_element_factory_make("avdec_flv", "avdec_flv");
-        //handle->video_convert = gst_element_factory_make("videoconvert", "videoconvert");
-        //handle->video_scale = gst_element_factory_make("video_scale", "video_scale");
+    gst_event_parse_qos(event, &type, &proportion, &diff, &timestamp);
+    // Positive diff is the lateness of the sink, negative means early
+    handle->sw_vdec_lateness = (handle->sw_vdec_lateness * 7 + diff / GST_MSECOND) / 8;
+
+    level = handle->sw_vdec_skip_level;
+    if (level < 2 && config->skip_frame_lateness > 0 &&
+        handle->sw_vdec_lateness > config->skip_frame_lateness) {
+        level = 2;
+    } else if (level < 1 && config->skip_loop_filter_lateness > 0 &&
+        handle->sw_vdec_lateness > config->skip_loop_filter_lateness) {
+        level = 1;
+    } else if (level == 2 && handle->sw_vdec_lateness < config->skip_frame_lateness / 2) {
+        level = 1;
+    } else if (level == 1 && handle->sw_vdec_lateness < config->skip_loop_filter_lateness / 2) {
+        level = 0;
     }
-    else
-    {
-        handle->video_decoder = gst_element_factory_make("nxvideodec", "nxvideodec");
+
+    if (level != handle->sw_vdec_skip_level) {
+        set_sw_vdec_skip_level(handle, level);
     }
-#else
-    handle->video_decoder = gst_element_factory_make("nxvideodec", "nxvideodec");
-#endif
 
-    // Tee for video
-    handle->tee = gst_element_factory_make("tee", "tee");
-    if(!handle->video_queue || !handle->video_decoder) {
+    return GST_PAD_PROBE_OK;
+}
+
+// parser <--> avdec <--> videoconvert <--> videoscale <--> capsfilter
+static NX_GST_RET set_sw_video_elements(MP_HANDLE handle, VIDEO_TYPE type)
+{
+    struct SW_VDEC_CONFIG *config = &handle->sw_vdec_config;
+    int idx, i;
+
+    for (idx = 0; SW_VIDEO_CHAIN[idx].decoders[0]; idx++) {
+        if (SW_VIDEO_CHAIN[idx].type == type)
+            break;
+    }
+    if (NULL == SW_VIDEO_CHAIN[idx].decoders[0]) {
+        NXGLOGE("No software decoder for video type(%d)", type);
+        return NX_GST_RET_ERROR;
+    }
+
+    if (SW_VIDEO_CHAIN[idx].parser) {
+        handle->video_parser = gst_element_factory_make(SW_VIDEO_CHAIN[idx].parser, "parser");
+        if (!handle->video_parser) {
+            NXGLOGE("Failed to create %s element", SW_VIDEO_CHAIN[idx].parser);
+            return NX_GST_RET_ERROR;
+        }
+    }
+
+    for (i = 0; i < 2 && SW_VIDEO_CHAIN[idx].decoders[i]; i++) {
+        handle->video_decoder = gst_element_factory_make(SW_VIDEO_CHAIN[idx].decoders[i],
+                                    SW_VIDEO_CHAIN[idx].decoders[i]);
+        if (handle->video_decoder)
+            break;
+    }
+    if (!handle->video_decoder) {
+        NXGLOGE("Failed to create a software decoder for video type(%d)", type);
+        return NX_GST_RET_ERROR;
+    }
+
+    // Threading
+    if (has_property(handle->video_decoder, "max-threads")) {
+        gint threads = (config->threads > 0) ? config->threads : (gint)g_get_num_processors();
+        g_object_set(handle->video_decoder, "max-threads", threads, NULL);
+    }
+    if (config->thread_type != SW_VDEC_THREAD_AUTO &&
+        has_property(handle->video_decoder, "thread-type")) {
+        g_object_set(handle->video_decoder, "thread-type", (guint)config->thread_type, NULL);
+    }
+    handle->sw_vdec_lateness = 0;
+    handle->sw_vdec_skip_level = 0;
+
+    // QoS events travel upstream through the decoder src pad
+    GstPad *srcpad = gst_element_get_static_pad(handle->video_decoder, "src");
+    if (srcpad) {
+        gst_pad_add_probe(srcpad, GST_PAD_PROBE_TYPE_EVENT_UPSTREAM,
+                sw_vdec_qos_probe, handle, NULL);
+        gst_object_unref(srcpad);
+    }
+
+    handle->video_convert = gst_element_factory_make("videoconvert", "video_convert");
+    handle->video_scale = gst_element_factory_make("videoscale", "video_scale");
+    handle->video_capsfilter = gst_element_factory_make("capsfilter", "video_capsfilter");
+    if (!handle->video_convert || !handle->video_scale || !handle->video_capsfilter) {
+        NXGLOGE("Failed to create videoconvert/videoscale/capsfilter");
+        return NX_GST_RET_ERROR;
+    }
+
+    GstCaps *caps = gst_caps_new_simple("video/x-raw",
+            "format", G_TYPE_STRING, "I420",
+            "width", GST_TYPE_INT_RANGE, 16,
+            (config->max_width > 0) ? config->max_width : SW_VDEC_MAX_WIDTH,
+            "height", GST_TYPE_INT_RANGE, 16,
+            (config->max_height > 0) ? config->max_height : SW_VDEC_MAX_HEIGHT,
+            NULL);
+    g_object_set(G_OBJECT(handle->video_capsfilter), "caps", caps, NULL);
+    gst_caps_unref(caps);
+
+    NXGLOGI("video type(%d): %s%s%s ! videoconvert ! videoscale", type,
+            SW_VIDEO_CHAIN[idx].parser ? SW_VIDEO_CHAIN[idx].parser : "",
+            SW_VIDEO_CHAIN[idx].parser ? " ! " : "",
+            GST_OBJECT_NAME(handle->video_decoder));
+
+    return NX_GST_RET_OK;
+}
+#endif
+
+NX_GST_RET set_video_elements(MP_HANDLE handle)
+{
+    FUNC_IN();
+
+    if (!handle) {
+        NXGLOGE("handle is NULL");
+        return NX_GST_RET_ERROR;
+    }
+
+    int pIdx = handle->select_program_idx;
+    int vIdx = handle->select_video_idx;
+
+    // Queue for video
+    handle->video_queue = gst_element_factory_make("queue2", "video_queue");
+
+    handle->video_parser = NULL;
+    handle->video_convert = NULL;
+
+#ifdef SW_V_DECODER
+    VIDEO_TYPE type = handle->gst_media_info.ProgramInfo[pIdx].VideoInfo[vIdx].type;
+    if (handle->sw_vdec_config.force_sw || !IS_HW_VIDEO_TYPE(type))
+    {
+        if (NX_GST_RET_ERROR == set_sw_video_elements(handle, type)) {
+            return NX_GST_RET_ERROR;
+        }
+    }
+    else
+#endif
+    {
+        // Video Parser
+        if (handle->gst_media_info.ProgramInfo[pIdx].VideoInfo[vIdx].type == VIDEO_TYPE_H264)
+        {
+            handle->video_parser = gst_element_factory_make("h264parse", "parser");
+            if (!handle->video_parser) {
+                NXGLOGE("Failed to create h264parse element");
+                return NX_GST_RET_ERROR;
+            }
+        }
+        else if ((handle->gst_media_info.ProgramInfo[pIdx].VideoInfo[vIdx].type == VIDEO_TYPE_MPEG_V1) ||
+                (handle->gst_media_info.ProgramInfo[pIdx].VideoInfo[vIdx].type == VIDEO_TYPE_MPEG_V2))
+        {
+            handle->video_parser = gst_element_factory_make("mpegvideoparse", "parser");
+            if (!handle->video_parser) {
+                NXGLOGE("Failed to create mpegvideoparse element");
+                return NX_GST_RET_ERROR;
+            }
+        }
+
+        // Video Decoder
+        handle->video_decoder = gst_element_factory_make("nxvideodec", "nxvideodec");
+    }
+
+    // Tee for video
+    handle->tee = gst_element_factory_make("tee", "tee");
+    if(!handle->video_queue || !handle->video_decoder || !handle->tee) {
         NXGLOGE("Failed to create video elements");
         return NX_GST_RET_ERROR;
     }
+    // Keep streaming while all the displays are unlinked
+    if (has_property(handle->tee, "allow-not-linked")) {
+        g_object_set(handle->tee, "allow-not-linked", TRUE, NULL);
+    }
 
     FUNC_OUT();
 
@@ -947,23 +1686,22 @@ void add_video_elements_to_bin(MP_HANDLE handle)
     gst_bin_add_many(GST_BIN(handle->pipeline), handle->video_queue,
                     handle->video_decoder, handle->tee, NULL);
 
-    int pIdx = handle->select_program_idx;
-    int vIdx = handle->select_video_idx;
     // video_parser
-    if ((handle->gst_media_info.ProgramInfo[pIdx].VideoInfo[vIdx].type == VIDEO_TYPE_H264) ||
-        (handle->gst_media_info.ProgramInfo[pIdx].VideoInfo[vIdx].type == VIDEO_TYPE_MPEG_V1) ||
-        (handle->gst_media_info.ProgramInfo[pIdx].VideoInfo[vIdx].type == VIDEO_TYPE_MPEG_V2))
+    if (handle->video_parser)
     {
         gst_bin_add(GST_BIN(handle->pipeline), handle->video_parser);
     }
+    // Software decoder output conversion
+    if (handle->video_convert)
+    {
+        gst_bin_add_many(GST_BIN(handle->pipeline), handle->video_convert,
+                    handle->video_scale, handle->video_capsfilter, NULL);
+    }
 }
 
 void add_audio_elements_to_bin(MP_HANDLE handle)
 {
-    int pIdx = handle->select_program_idx;
-    int aIdx = handle->select_audio_idx;
-    if ((handle->gst_media_info.ProgramInfo[pIdx].AudioInfo[aIdx].type == AUDIO_TYPE_MPEG_V1) ||
-        (handle->gst_media_info.ProgramInfo[pIdx].AudioInfo[aIdx].type == AUDIO_TYPE_MPEG_V2))
+    if (handle->audio_parser)
     {
         gst_bin_add_many(GST_BIN(handle->pipeline),
                     handle->audio_queue, handle->audio_parser, handle->audio_decoder,
@@ -1018,11 +1756,7 @@ NX_GST_RET add_elements_to_bin(MP_HANDLE handle)
 
 NX_GST_RET link_video_elements(MP_HANDLE handle)
 {
-    int pIdx = handle->select_program_idx;
-    int vIdx = handle->select_video_idx;
-    if ((handle->gst_media_info.ProgramInfo[pIdx].VideoInfo[vIdx].type == VIDEO_TYPE_H264) ||
-        (handle->gst_media_info.ProgramInfo[pIdx].VideoInfo[vIdx].type == VIDEO_TYPE_MPEG_V1) ||
-        (handle->gst_media_info.ProgramInfo[pIdx].VideoInfo[vIdx].type == VIDEO_TYPE_MPEG_V2))
+    if (handle->video_parser)
     {
         if (!gst_element_link_many(handle->video_queue, handle->video_parser,
                         handle->video_decoder, NULL))
@@ -1045,22 +1779,33 @@ NX_GST_RET link_video_elements(MP_HANDLE handle)
         }
     }
 
+    // video_decoder <--> videoconvert <--> videoscale <--> capsfilter <--> tee
+    if (handle->video_convert)
+    {
+        if (!gst_element_link_many(handle->video_decoder, handle->video_convert,
+                        handle->video_scale, handle->video_capsfilter, handle->tee, NULL))
+        {
+            NXGLOGE("Failed to link video_decoder<-->videoconvert<-->videoscale<-->capsfilter<-->tee");
+            return NX_GST_RET_ERROR;
+        }
+    }
     // video_decoder <--> tee
-    if (!gst_element_link_many(handle->video_decoder, handle->tee, NULL))
+    else if (!gst_element_link_many(handle->video_decoder, handle->tee, NULL))
     {
         NXGLOGE("Failed to link video_decoder<-->tee");
     }
     NXGLOGI("Succeed to link video elements with video_decoder<-->tee");
 
+    // link_display() moves it to the sink when a single display is linked
+    handle->video_src_pad = gst_element_get_static_pad(
+            handle->video_convert ? handle->video_capsfilter : handle->video_decoder, "src");
+
     return NX_GST_RET_OK;
 }
 
 NX_GST_RET link_audio_elements(MP_HANDLE handle)
 {
-    int pIdx = handle->select_program_idx;
-    int aIdx = handle->select_audio_idx;
-    if ((handle->gst_media_info.ProgramInfo[pIdx].AudioInfo[aIdx].type == AUDIO_TYPE_MPEG_V1) ||
-        (handle->gst_media_info.ProgramInfo[pIdx].AudioInfo[aIdx].type == AUDIO_TYPE_MPEG_V2))
+    if (handle->audio_parser)
     {
         if (!gst_element_link(handle->audio_queue, handle->audio_parser))
         {
@@ -1148,1023 +1893,2174 @@ NX_GST_RET link_elements(MP_HANDLE handle)
     return NX_GST_RET_OK;
 }
 
-NX_GST_RET link_display(MP_HANDLE handle, enum DISPLAY_TYPE type)
+typedef NX_GST_RET (*VideoRelinkFunc)(MP_HANDLE handle, gpointer data);
+
+// A relink of the decoder output, shared by relink_video_src() and its probe
+struct VideoRelink {
+    MP_HANDLE       handle;
+    VideoRelinkFunc func;
+    gpointer        data;
+    GDestroyNotify  free_data;
+    NX_GST_RET      result;
+    gboolean        done;
+    volatile gint   ref;
+    GMutex          lock;
+    GCond           cond;
+};
+
+static void unref_video_relink(gpointer user_data)
 {
-    NXGLOGI("Display type [%s]", (type == DISPLAY_TYPE_PRIMARY)?"PRIMARY":"SECONDARY");
+    struct VideoRelink *relink = (struct VideoRelink *)user_data;
 
-    if ((DISPLAY_TYPE_PRIMARY == type) && primary_sinks)
-    {
-        NXGLOGE("Failed to link the primary display");
-        return NX_GST_RET_ERROR;
-    }
-    if ((DISPLAY_TYPE_SECONDARY == type) && secondary_sinks)
+    if (g_atomic_int_dec_and_test(&relink->ref))
     {
-        NXGLOGE("Failed to link the secondary display");
-        return NX_GST_RET_ERROR;
+        if (relink->free_data) {
+            relink->free_data(relink->data);
+        }
+        g_mutex_clear(&relink->lock);
+        g_cond_clear(&relink->cond);
+        g_free(relink);
     }
+}
 
-    struct Sink *sink = g_try_new0(struct Sink, 1);
-    GstPad *sinkpad;
-    GstPadTemplate *templ;
-    DSP_RECT rect;
-    gchar *video_sink_name, *queue_name;
+static GstPadProbeReturn video_relink_probe(GstPad *pad, GstPadProbeInfo *info,
+                gpointer user_data)
+{
+    struct VideoRelink *relink = (struct VideoRelink *)user_data;
+    NX_GST_RET result;
 
-    sink->tee = handle->tee;
-    sink->pipeline = handle->pipeline;
+    (void)pad;
+    (void)info;
 
-    // Request a pad from tee
-    templ = gst_element_class_get_pad_template (GST_ELEMENT_GET_CLASS (sink->tee), "src_%u");
-    sink->tee_pad = gst_element_request_pad (sink->tee, templ, NULL, NULL);
-    NXGLOGV("Obtained request pad %s:%s for the %s display",
-            GST_DEBUG_PAD_NAME(sink->tee_pad),
-            (type == DISPLAY_TYPE_PRIMARY)?"primary":"secondary");
+    result = relink->func(relink->handle, relink->data);
+
+    g_mutex_lock(&relink->lock);
+    relink->result = result;
+    relink->done = TRUE;
+    g_cond_signal(&relink->cond);
+    g_mutex_unlock(&relink->lock);
+
+    return GST_PAD_PROBE_REMOVE;
+}
 
-    // Create elements 'queue' and 'nxvideosink'
-    if (DISPLAY_TYPE_PRIMARY == type)
+/* Runs 'func' from an IDLE probe of the decoder output: right away when no
+ * buffer is being pushed, otherwise on the streaming thread once the push in
+ * progress has returned and before the next one. The next buffer goes to the
+ * new peer, none is dropped or pushed to an unlinked pad.
+ * If the output is still busy after VIDEO_RELINK_WAIT_US, it is left to the
+ * probe and taken as done. */
+static NX_GST_RET relink_video_src(MP_HANDLE handle, VideoRelinkFunc func,
+                gpointer data, GDestroyNotify free_data)
+{
+    struct VideoRelink *relink = g_new0(struct VideoRelink, 1);
+    gint64 end_time = g_get_monotonic_time() + VIDEO_RELINK_WAIT_US;
+    NX_GST_RET result = NX_GST_RET_OK;
+
+    relink->handle = handle;
+    relink->func = func;
+    relink->data = data;
+    relink->free_data = free_data;
+    // One for the probe, one for this thread
+    relink->ref = 2;
+    g_mutex_init(&relink->lock);
+    g_cond_init(&relink->cond);
+
+    gst_pad_add_probe(handle->video_src_pad, GST_PAD_PROBE_TYPE_IDLE,
+                    video_relink_probe, relink, unref_video_relink);
+
+    g_mutex_lock(&relink->lock);
+    while (!relink->done)
     {
-        sink->queue = gst_element_factory_make ("queue2", "queue_primary");
-        sink->nxvideosink = gst_element_factory_make ("nxvideosink", "nxvideosink");
+        if (!g_cond_wait_until(&relink->cond, &relink->lock, end_time)) {
+            break;
+        }
     }
-    else
-    {
-        sink->queue = gst_element_factory_make ("queue2", "queue_secondary");
-        sink->nxvideosink = gst_element_factory_make ("nxvideosink", "nxvideosink_hdmi");
+    if (relink->done) {
+        result = relink->result;
+    } else {
+        NXGLOGW("The video output is busy, it is relinked after the current frame");
     }
-    if (!sink->queue || !sink->nxvideosink)
+    g_mutex_unlock(&relink->lock);
+
+    unref_video_relink(relink);
+
+    return result;
+}
+
+/* Links the decoder output to 'peer' instead of its current peer.
+ * Only from a relink_video_src() function, while the output is idle. */
+static gboolean move_video_src(MP_HANDLE handle, GstPad *peer)
+{
+    GstPad *old_peer = gst_pad_get_peer(handle->video_src_pad);
+    GstPadLinkReturn ret;
+
+    if (old_peer)
     {
-        NXGLOGE("Failed to create the video elements");
-        return NX_GST_RET_ERROR;
+        gst_pad_unlink(handle->video_src_pad, old_peer);
+        gst_object_unref(old_peer);
     }
 
-    g_object_set (G_OBJECT (sink->nxvideosink), "sync", true, NULL);
-    g_object_set (G_OBJECT (sink->nxvideosink), "async", false, NULL);
-    g_object_get (G_OBJECT (sink->queue), "name", &queue_name, NULL);
-    g_object_get (G_OBJECT (sink->nxvideosink), "name", &video_sink_name, NULL);
+    ret = gst_pad_link(handle->video_src_pad, peer);
+    NXGLOGI("  ==> %s to link %s:%s to %s:%s",
+            (ret == GST_PAD_LINK_OK) ? "Succeed":"Failed",
+            GST_DEBUG_PAD_NAME(handle->video_src_pad),
+            GST_DEBUG_PAD_NAME(peer));
 
-    NXGLOGV("queue_name(%s) videosink(%s)", queue_name, video_sink_name);
+    return (ret == GST_PAD_LINK_OK);
+}
 
-    if (DISPLAY_TYPE_PRIMARY == type) {
-        rect = handle->primary_dsp_rect;
-    } else {
-        rect = handle->secondary_dsp_rect;
-    }
-    g_object_set(G_OBJECT(sink->nxvideosink), "dst-x", rect.left, NULL);
-    g_object_set(G_OBJECT(sink->nxvideosink), "dst-y", rect.top, NULL);
-    g_object_set(G_OBJECT(sink->nxvideosink), "dst-w", (rect.right - rect.left), NULL);
-    g_object_set(G_OBJECT(sink->nxvideosink), "dst-h", (rect.bottom - rect.top), NULL);
-    g_object_set(sink->nxvideosink, "crtc-index", type, NULL);
+static gboolean move_video_src_to_tee(MP_HANDLE handle)
+{
+    GstPad *tee_sinkpad = gst_element_get_static_pad(handle->tee, "sink");
+    gboolean ret = move_video_src(handle, tee_sinkpad);
 
-    sink->removing = FALSE;
+    gst_object_unref(tee_sinkpad);
 
-    // Add elements 'queue, nxvideosink' to bin
-    gst_bin_add_many(GST_BIN(sink->pipeline),
-                            sink->queue,
-                            sink->nxvideosink,
-                            NULL);
+    return ret;
+}
+
+// Puts 'queue' in front of the sink and links it to a new tee pad
+static NX_GST_RET link_tee_branch(struct Sink *sink, enum DISPLAY_TYPE type)
+{
+    GstPadTemplate *templ;
+    GstPad *sinkpad;
+    GstPadLinkReturn ret;
 
-    // Link queue<-->nxvideosink
-    if (!gst_element_link_many(sink->queue, sink->nxvideosink, NULL))
+    if (DISPLAY_TYPE_PRIMARY == type) {
+        sink->queue = gst_element_factory_make ("queue2", "queue_primary");
+    } else {
+        sink->queue = gst_element_factory_make ("queue2", "queue_secondary");
+    }
+    if (!sink->queue)
     {
-        NXGLOGE("Failed to link %s<-->%s", queue_name, video_sink_name);
+        NXGLOGE("Failed to create the queue");
         return NX_GST_RET_ERROR;
     }
 
-    // Set sync state
+    gst_bin_add(GST_BIN(sink->pipeline), sink->queue);
+    if (!gst_element_link(sink->queue, sink->nxvideosink))
+    {
+        NXGLOGE("Failed to link %s<-->%s", GST_ELEMENT_NAME(sink->queue),
+                GST_ELEMENT_NAME(sink->nxvideosink));
+        return NX_GST_RET_ERROR;
+    }
     gst_element_sync_state_with_parent (sink->queue);
-    gst_element_sync_state_with_parent (sink->nxvideosink);
+
+    // Request a pad from tee
+    templ = gst_element_class_get_pad_template (GST_ELEMENT_GET_CLASS (sink->tee), "src_%u");
+    sink->tee_pad = gst_element_request_pad (sink->tee, templ, NULL, NULL);
+    NXGLOGV("Obtained request pad %s:%s for the %s display",
+            GST_DEBUG_PAD_NAME(sink->tee_pad),
+            (type == DISPLAY_TYPE_PRIMARY)?"primary":"secondary");
 
     // Link tee_pad<-->queue sink pad
     sinkpad = gst_element_get_static_pad(sink->queue, "sink");
-    gboolean ret = gst_pad_link(sink->tee_pad, sinkpad);
-    if (GST_PAD_LINK_OK != ret)
-    {
-        NXGLOGI("  ==> %s to link %s:%s to %s:%s",
-                (ret == GST_PAD_LINK_OK) ? "Succeed":"Failed",
-                GST_DEBUG_PAD_NAME(sink->tee_pad),
-                GST_DEBUG_PAD_NAME(sinkpad));
-        gst_object_unref (sinkpad);
-        return NX_GST_RET_ERROR;
-    }
-    else
-    {
-        NXGLOGI("  ==> Succeed to link %s:%s and %s:%s",
-                GST_DEBUG_PAD_NAME(sink->tee_pad),
-                GST_DEBUG_PAD_NAME(sinkpad));
-    }
+    ret = gst_pad_link(sink->tee_pad, sinkpad);
+    NXGLOGI("  ==> %s to link %s:%s and %s:%s",
+            (ret == GST_PAD_LINK_OK) ? "Succeed":"Failed",
+            GST_DEBUG_PAD_NAME(sink->tee_pad),
+            GST_DEBUG_PAD_NAME(sinkpad));
     gst_object_unref (sinkpad);
 
-    if (DISPLAY_TYPE_PRIMARY == type) {
-        primary_sinks = g_list_append (primary_sinks, sink);
-    } else {
-        secondary_sinks = g_list_append (secondary_sinks, sink);
-    }
+    sink->direct = FALSE;
 
-    g_free (queue_name);
-    g_free (video_sink_name);
+    return (ret == GST_PAD_LINK_OK) ? NX_GST_RET_OK : NX_GST_RET_ERROR;
+}
 
-    return NX_GST_RET_OK;
+static void set_display_rect(GstElement *nxvideosink, const DSP_RECT *rect)
+{
+    g_object_set(G_OBJECT(nxvideosink),
+            "dst-x", rect->left,
+            "dst-y", rect->top,
+            "dst-w", (rect->right - rect->left),
+            "dst-h", (rect->bottom - rect->top),
+            NULL);
 }
 
-static GstPadProbeReturn
-unlink_display_cb (GstPad* pad, GstPadProbeInfo* info, gpointer user_data)
+// Applies the pending rect of the display right before a frame is rendered
+static GstPadProbeReturn display_rect_probe(GstPad *pad, GstPadProbeInfo *info,
+                gpointer user_data)
 {
     struct Sink *sink = (struct Sink *)user_data;
-    GstStateChangeReturn state_ret;
+    MP_HANDLE handle = sink->handle;
+    struct DSP_RECT rect;
 
-    NXGLOGI();
+    (void)pad;
+    (void)info;
 
-    if (!g_atomic_int_compare_and_exchange (&sink->removing, FALSE, TRUE))
-    {
-        NXGLOGI("- GST_PAD_PROBE_OK");
+    if (!g_atomic_int_get(&handle->dsp_rect_dirty[sink->type])) {
         return GST_PAD_PROBE_OK;
     }
 
-    // Unlink tee:src_<-->queue:sink
-    GstPad *sinkpad;
-    sinkpad = gst_element_get_static_pad (sink->queue, "sink");
-    gboolean ret = gst_pad_unlink (sink->tee_pad, sinkpad);
-    NXGLOGI(" ==> %s to unlink %s:%s from %s:%s",
-            (ret == true) ? "Succeed":"Failed",
-            GST_DEBUG_PAD_NAME(sink->tee_pad),
-            GST_DEBUG_PAD_NAME(sinkpad));
-    gst_object_unref (sinkpad);
-
-    // set state of 'nxvideosink' and 'queue' to NULL
-    state_ret = gst_element_set_state (sink->nxvideosink, GST_STATE_NULL);
-    if (state_ret == GST_STATE_CHANGE_FAILURE) {
-        NXGLOGE("Failed to set nxvideosink to the NULL state");
-    }
-    state_ret = gst_element_set_state (sink->queue, GST_STATE_NULL);
-    if (state_ret == GST_STATE_CHANGE_FAILURE) {
-        NXGLOGE("Failed to set queue to the NULL state");
-    }
-
-    // remove queue and nxvideosink
-    if (!gst_bin_remove (GST_BIN (sink->pipeline), sink->queue)) {
-        NXGLOGE("Failed to remove queue from bin");
-    }
-    if (!gst_bin_remove (GST_BIN (sink->pipeline), sink->nxvideosink)) {
-        NXGLOGE("Failed to remove nxvideosink from bin");
-    }
+    pthread_mutex_lock(&handle->stateLock);
+    rect = handle->pending_dsp_rect[sink->type];
+    handle->dsp_rect_dirty[sink->type] = FALSE;
+    pthread_mutex_unlock(&handle->stateLock);
 
-    // release_request_pad and unref 'tee_pad'
-    gst_element_release_request_pad (sink->tee, sink->tee_pad);
-    gst_object_unref (sink->tee_pad);
+    set_display_rect(sink->nxvideosink, &rect);
 
-    NXGLOGV("%s:%d ref_count is %d", __FILE__, __LINE__,
-            GST_OBJECT_REFCOUNT(sink->queue));
+    return GST_PAD_PROBE_OK;
+}
 
-    NXGLOGI("- GST_PAD_PROBE_REMOVE");
-    return GST_PAD_PROBE_REMOVE;
+// Hands 'rect' to the next frame of the display, called with stateLock held
+static void post_display_rect(MP_HANDLE handle, enum DISPLAY_TYPE type,
+                const struct DSP_RECT *rect)
+{
+    handle->pending_dsp_rect[type] = *rect;
+    g_atomic_int_set(&handle->dsp_rect_dirty[type], TRUE);
 }
 
-void unlink_display(enum DISPLAY_TYPE type)
+/* Applies a new rect to the linked display of 'type'. While frames flow it
+ * waits for the next frame, otherwise it is set right away. */
+static void update_display_rect(MP_HANDLE handle, enum DISPLAY_TYPE type,
+                const struct DSP_RECT *rect)
 {
-    NXGLOGI("Display type [%s]", (type == DISPLAY_TYPE_PRIMARY)?"PRIMARY":"SECONDARY");
+    GList *sinks = (DISPLAY_TYPE_PRIMARY == type) ? handle->primary_sinks:handle->secondary_sinks;
 
-    struct Sink *sink;
-    GList *sinks = (DISPLAY_TYPE_PRIMARY == type) ? primary_sinks:secondary_sinks;
+    pthread_mutex_lock(&handle->stateLock);
+    post_display_rect(handle, type, rect);
+    pthread_mutex_unlock(&handle->stateLock);
 
-    if (g_list_length(sinks) > 0)
-    {
-        if (DISPLAY_TYPE_PRIMARY == type)
-        {
-            sink = (Sink*)primary_sinks->data;
-            primary_sinks = g_list_delete_link (primary_sinks, primary_sinks);
-        }
-        else
-        {
-            sink = (Sink*)secondary_sinks->data;
-            secondary_sinks = g_list_delete_link (secondary_sinks, secondary_sinks);
-        }
-        gst_pad_add_probe (sink->tee_pad, GST_PAD_PROBE_TYPE_IDLE,
-                            (GstPadProbeCallback)unlink_display_cb, sink,
-                            (GDestroyNotify) g_free);
+    if (sinks && handle->state != GST_STATE_PLAYING) {
+        set_display_rect(((struct Sink *)sinks->data)->nxvideosink, rect);
     }
 }
 
-NX_GST_RET NX_GSTMP_SetDisplayMode(MP_HANDLE handle, enum DISPLAY_MODE in_mode)
+static gint interpolate(gint from, gint to, gdouble t)
 {
-    _CAutoLock lock(&handle->apiLock);
+    return from + (gint)((to - from) * t + ((to >= from) ? 0.5 : -0.5));
+}
 
-    FUNC_IN();
+/* Steps the rect transitions. Steps which fall between two frames are
+ * merged, the frame probe only applies the latest one. Without frames
+ * flowing each step is set right away, like update_display_rect() does. */
+static gboolean display_anim_cb(gpointer user_data)
+{
+    MP_HANDLE handle = (MP_HANDLE)user_data;
+    gint64 now = g_get_monotonic_time();
+    gboolean running = FALSE;
+    gboolean direct = (handle->state != GST_STATE_PLAYING);
+    gboolean stepped[DISPLAY_TYPE_SECONDARY + 1] = { FALSE, FALSE };
+    struct DSP_RECT rects[DISPLAY_TYPE_SECONDARY + 1];
 
-    if (NULL == handle)
-    {
-        NXGLOGE("handle is NULL");
-        return NX_GST_RET_ERROR;
+    // The lists of sinks are only stable under apiLock. The loop thread must
+    // not wait for an API call, a busy one delays the step to the next tick.
+    if (direct && 0 != pthread_mutex_trylock(&handle->apiLock)) {
+        return G_SOURCE_CONTINUE;
     }
 
-    if ((in_mode < DISPLAY_MODE_LCD_ONLY) ||
-        (in_mode > DISPLAY_MODE_NONE))
+    pthread_mutex_lock(&handle->stateLock);
+    for (int type = DISPLAY_TYPE_PRIMARY; type <= DISPLAY_TYPE_SECONDARY; type++)
     {
-        NXGLOGE("Failed to set display mode - Invalid Display Mode");
-        return NX_GST_RET_ERROR;
-    }
+        struct DspAnimation *anim = &handle->dsp_anim[type];
+        gdouble t;
 
-    enum DISPLAY_MODE old_mode = handle->display_mode;
+        if (!anim->active) {
+            continue;
+        }
 
-    NXGLOGI("The display mode is changed from (%s) to (%s) in state(%s)",
-            get_display_mode_str(old_mode),
-            get_display_mode_str(in_mode),
-            gst_element_state_get_name (handle->state));
+        t = (anim->duration_us > 0) ?
+                (gdouble)(now - anim->start_time) / anim->duration_us : 1.0;
+        if (t >= 1.0) {
+            t = 1.0;
+            anim->active = FALSE;
+        } else {
+            running = TRUE;
+        }
+        // Ease in and out
+        t = t * t * (3.0 - 2.0 * t);
 
-    if ((handle->pipeline_is_linked) && (old_mode != in_mode))
+        anim->current.left = interpolate(anim->from.left, anim->to.left, t);
+        anim->current.top = interpolate(anim->from.top, anim->to.top, t);
+        anim->current.right = interpolate(anim->from.right, anim->to.right, t);
+        anim->current.bottom = interpolate(anim->from.bottom, anim->to.bottom, t);
+        post_display_rect(handle, (enum DISPLAY_TYPE)type, &anim->current);
+        rects[type] = anim->current;
+        stepped[type] = TRUE;
+    }
+    if (!running && handle->dsp_anim_source) {
+        g_source_unref(handle->dsp_anim_source);
+        handle->dsp_anim_source = NULL;
+    }
+    pthread_mutex_unlock(&handle->stateLock);
+
+    if (direct)
     {
-        if (handle->state == GST_STATE_PAUSED || handle->state == GST_STATE_PLAYING)
+        for (int type = DISPLAY_TYPE_PRIMARY; type <= DISPLAY_TYPE_SECONDARY; type++)
         {
-            if (DISPLAY_MODE_LCD_ONLY == old_mode)
-            {
-                if (DISPLAY_MODE_NONE == in_mode) {
-                    unlink_display(DISPLAY_TYPE_PRIMARY);
-                } else {
-                    link_display(handle, DISPLAY_TYPE_SECONDARY);
-                    if (DISPLAY_MODE_HDMI_ONLY == in_mode)
-                    {
-                        unlink_display(DISPLAY_TYPE_PRIMARY);
-                    }
-                }
-            }
-            else if (DISPLAY_MODE_HDMI_ONLY == old_mode)
-            {
-                if (DISPLAY_MODE_NONE == in_mode) {
-                    unlink_display(DISPLAY_TYPE_SECONDARY);
-                } else {
-                    link_display(handle, DISPLAY_TYPE_PRIMARY);
-                    if (DISPLAY_MODE_LCD_ONLY == in_mode)
-                    {
-                        unlink_display(DISPLAY_TYPE_SECONDARY);
-                    }
-                }
-            }
-            else if (DISPLAY_MODE_LCD_HDMI == old_mode)
-            {
-                if (DISPLAY_MODE_NONE == in_mode) {
-                    unlink_display(DISPLAY_TYPE_PRIMARY);
-                    unlink_display(DISPLAY_TYPE_SECONDARY);
-                } else {
-                    if (DISPLAY_MODE_LCD_ONLY == in_mode)
-                    {
-                        unlink_display(DISPLAY_TYPE_SECONDARY);
-                    }
-                    else if (DISPLAY_MODE_HDMI_ONLY == in_mode)
-                    {
-                        unlink_display(DISPLAY_TYPE_PRIMARY);
-                    }
-                }
-            }
-            else
-            {
-                if (DISPLAY_MODE_LCD_ONLY == in_mode) {
-                    link_display(handle, DISPLAY_TYPE_PRIMARY);
-                } else if (DISPLAY_MODE_HDMI_ONLY == in_mode) {
-                    link_display(handle, DISPLAY_TYPE_SECONDARY);
-                } else if (DISPLAY_MODE_LCD_HDMI == in_mode) {
-                    link_display(handle, DISPLAY_TYPE_PRIMARY);
-                    link_display(handle, DISPLAY_TYPE_SECONDARY);
-                }
+            GList *sinks = (DISPLAY_TYPE_PRIMARY == type) ?
+                    handle->primary_sinks : handle->secondary_sinks;
+
+            if (stepped[type] && sinks) {
+                set_display_rect(((struct Sink *)sinks->data)->nxvideosink, &rects[type]);
             }
         }
+        pthread_mutex_unlock(&handle->apiLock);
     }
-    handle->display_mode = in_mode;
 
-    return NX_GST_RET_OK;
+    return running ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
 }
 
-NX_GST_RET NX_GSTMP_SetUri(MP_HANDLE handle, const char *filePath)
+// Creates the nxvideosink of a display, not added to the bin yet
+static struct Sink *make_display_sink(MP_HANDLE handle, enum DISPLAY_TYPE type)
 {
-    _CAutoLock lock(&handle->apiLock);
+    struct Sink *sink = g_try_new0(struct Sink, 1);
 
-    NXGLOGI("%s", filePath);
+    if (!sink) {
+        return NULL;
+    }
+    sink->tee = handle->tee;
+    sink->pipeline = handle->pipeline;
+    sink->handle = handle;
+    sink->type = type;
+    sink->removing = FALSE;
 
-    if(NULL == handle)
+    // Create element 'nxvideosink'
+    if (DISPLAY_TYPE_PRIMARY == type) {
+        sink->nxvideosink = gst_element_factory_make ("nxvideosink", "nxvideosink");
+    } else {
+        sink->nxvideosink = gst_element_factory_make ("nxvideosink", "nxvideosink_hdmi");
+    }
+    if (!sink->nxvideosink)
     {
-        NXGLOGE("handle is NULL");
-        return NX_GST_RET_ERROR;
+        g_free(sink);
+        return NULL;
     }
-    handle->filePath = g_strdup(filePath);
-    handle->error = NX_GST_ERROR_NONE;
 
-    // Start to parse media info
-    struct GST_MEDIA_INFO *media_info;
-    NX_GST_RET result = OpenMediaInfo(&media_info);
-    if (NX_GST_RET_OK != result) {
-        return NX_GST_RET_ERROR;
+    g_object_set (G_OBJECT (sink->nxvideosink), "sync", true, NULL);
+    g_object_set (G_OBJECT (sink->nxvideosink), "async", false, NULL);
+    // Keep the frame on screen for NX_GSTMP_CaptureFrame()
+    g_object_set (G_OBJECT (sink->nxvideosink), "enable-last-sample", true, NULL);
+
+    if (DISPLAY_TYPE_PRIMARY == type) {
+        set_display_rect(sink->nxvideosink, &handle->primary_dsp_rect);
+    } else {
+        set_display_rect(sink->nxvideosink, &handle->secondary_dsp_rect);
     }
+    g_object_set(sink->nxvideosink, "crtc-index", type, NULL);
 
-    enum NX_GST_ERROR err = ParseMediaInfo(media_info, filePath);
-    if (NX_GST_ERROR_NONE != err)
-    {
-        handle->error = err;
-        NXGLOGE("%s", get_nx_gst_error(err));
+    GstPad *sinkpad = gst_element_get_static_pad(sink->nxvideosink, "sink");
+    gst_pad_add_probe(sinkpad, GST_PAD_PROBE_TYPE_BUFFER, display_rect_probe, sink, NULL);
+    gst_object_unref(sinkpad);
 
-        CloseMediaInfo(media_info);
-        return NX_GST_RET_ERROR;
-    }
+    return sink;
+}
 
-    // Copy the parsed media info to handle->gst_media_info
-    CopyMediaInfo(&handle->gst_media_info, media_info);
-    PrintMediaInfo(&handle->gst_media_info, filePath);
-    CloseMediaInfo(media_info);
-    // Done to parse media info
+/* Builds the secondary branch queue <--> nxvideosink_hdmi on an unlinked tee
+ * pad, locked in READY so that the pipeline state changes leave it alone.
+ * The tee ignores the unlinked pad (allow-not-linked). */
+static void make_standby_display(MP_HANDLE handle)
+{
+    struct Sink *sink;
+    GstPadTemplate *templ;
 
-#ifdef SW_V_DECODER
-    if (handle->gst_media_info.container_type > CONTAINER_TYPE_FLV)
-#else
-    if (handle->gst_media_info.container_type >= CONTAINER_TYPE_FLV)
-#endif
-    {
-        NXGLOGE("Not supported container type");
-        return NX_GST_RET_ERROR;
+    sink = make_display_sink(handle, DISPLAY_TYPE_SECONDARY);
+    if (sink) {
+        sink->queue = gst_element_factory_make ("queue2", "queue_secondary");
     }
-    if (handle->gst_media_info.container_type != CONTAINER_TYPE_MPEGTS)
+    if (!sink || !sink->queue)
     {
-        if (handle->gst_media_info.ProgramInfo[0].n_video == 0)
-        {
-            NXGLOGE("Not supported contents(audio only)");
-            return NX_GST_RET_ERROR;
+        NXGLOGE("Failed to create the standby secondary display");
+        if (sink) {
+            gst_object_unref(sink->nxvideosink);
+            g_free(sink);
         }
+        return;
     }
 
-    NXGLOGI("END");
+    gst_element_set_locked_state(sink->queue, TRUE);
+    gst_element_set_locked_state(sink->nxvideosink, TRUE);
+    gst_bin_add_many(GST_BIN(sink->pipeline), sink->queue, sink->nxvideosink, NULL);
+    if (!gst_element_link(sink->queue, sink->nxvideosink)) {
+        NXGLOGE("Failed to link queue_secondary<-->nxvideosink_hdmi");
+    }
+    gst_element_set_state(sink->nxvideosink, GST_STATE_READY);
+    gst_element_set_state(sink->queue, GST_STATE_READY);
 
-    return NX_GST_RET_OK;
+    templ = gst_element_class_get_pad_template (GST_ELEMENT_GET_CLASS (sink->tee), "src_%u");
+    sink->tee_pad = gst_element_request_pad (sink->tee, templ, NULL, NULL);
+
+    pthread_mutex_lock(&handle->stateLock);
+    handle->standby_sink = sink;
+    pthread_mutex_unlock(&handle->stateLock);
+
+    NXGLOGI("The secondary display is on standby");
 }
 
-gboolean isSupportedContents(struct GST_MEDIA_INFO *media_info,
-    int pIdx, int vIdx, int aIdx, int sIdx)
+// Only a state sync and a link are left to do
+static NX_GST_RET activate_standby_display(MP_HANDLE handle, struct Sink *sink)
 {
-    CONTAINER_TYPE container_type;
-    VIDEO_TYPE video_type;
+    GstPad *sinkpad;
+    GstPadLinkReturn ret;
 
-    container_type = media_info->container_type;
-    /* Quicktime, 3GP, Matroska, AVI, MPEG (vob) */
-    if ((container_type == CONTAINER_TYPE_MPEGTS) ||
-        (container_type == CONTAINER_TYPE_QUICKTIME) ||
-        (container_type == CONTAINER_TYPE_MSVIDEO) ||
-        (container_type == CONTAINER_TYPE_MATROSKA) ||
-        (container_type == CONTAINER_TYPE_3GP) ||
-        (container_type == CONTAINER_TYPE_MPEG)
-#ifdef SW_V_DECODER
-        || (container_type == CONTAINER_TYPE_FLV)
-#endif
-        )
-    {
-        if (media_info->ProgramInfo[pIdx].n_video == 0)
-        {
-            NXGLOGE("There is no video to play");
-            return FALSE;
-        }
+    // The rect may have changed since the branch was built
+    set_display_rect(sink->nxvideosink, &handle->secondary_dsp_rect);
 
-        video_type = media_info->ProgramInfo[pIdx].VideoInfo[vIdx].type;
-#ifdef SW_V_DECODER
-        if (video_type > VIDEO_TYPE_FLV)
-#else
-        if (video_type >= VIDEO_TYPE_FLV)
-#endif
-        {
-            NXGLOGE("Not supported video type(%d)", video_type);
-            return FALSE;
-        }
+    gst_element_set_locked_state(sink->nxvideosink, FALSE);
+    gst_element_set_locked_state(sink->queue, FALSE);
+    gst_element_sync_state_with_parent(sink->nxvideosink);
+    gst_element_sync_state_with_parent(sink->queue);
 
-        return TRUE;
-    }
-    else
-    {
-        NXGLOGE("Not supported container type(%d)", container_type);
-        return FALSE;
-    }
+    sinkpad = gst_element_get_static_pad(sink->queue, "sink");
+    ret = gst_pad_link(sink->tee_pad, sinkpad);
+    NXGLOGI("  ==> %s to link %s:%s and %s:%s",
+            (ret == GST_PAD_LINK_OK) ? "Succeed":"Failed",
+            GST_DEBUG_PAD_NAME(sink->tee_pad),
+            GST_DEBUG_PAD_NAME(sinkpad));
+    gst_object_unref(sinkpad);
+
+    return (ret == GST_PAD_LINK_OK) ? NX_GST_RET_OK : NX_GST_RET_ERROR;
 }
 
-NX_GST_RET NX_GSTMP_Prepare(MP_HANDLE handle)
+static void record_activation_time(MP_HANDLE handle, gint64 start_time, gboolean standby)
 {
-    _CAutoLock lock(&handle->apiLock);
+    gint64 elapsed = g_get_monotonic_time() - start_time;
 
-    NXGLOGI("START");
+    pthread_mutex_lock(&handle->stateLock);
+    handle->secondary_activation_us = elapsed;
+    pthread_mutex_unlock(&handle->stateLock);
 
-    GstStateChangeReturn ret;
+    NXGLOGI("The secondary display is linked in %" G_GINT64_FORMAT " us (%s)",
+            elapsed, standby ? "standby":"new branch");
+}
 
-    if(handle->pipeline_is_linked)
+/* Stops and removes the standby branch. The pipeline state changes skip the
+ * locked elements, they would be disposed in READY otherwise. */
+static void drop_standby_display(MP_HANDLE handle)
+{
+    struct Sink *sink;
+
+    pthread_mutex_lock(&handle->stateLock);
+    sink = handle->standby_sink;
+    handle->standby_sink = NULL;
+    pthread_mutex_unlock(&handle->stateLock);
+
+    if (sink)
     {
-        NXGLOGE("pipeline is already linked");
-        // TODO:
-        return NX_GST_RET_OK;
+        gst_element_set_locked_state(sink->nxvideosink, FALSE);
+        gst_element_set_locked_state(sink->queue, FALSE);
+        gst_element_set_state(sink->nxvideosink, GST_STATE_NULL);
+        gst_element_set_state(sink->queue, GST_STATE_NULL);
+        gst_bin_remove(GST_BIN(sink->pipeline), sink->queue);
+        gst_bin_remove(GST_BIN(sink->pipeline), sink->nxvideosink);
+        gst_element_release_request_pad(sink->tee, sink->tee_pad);
+        gst_object_unref(sink->tee_pad);
+        g_free(sink);
     }
+}
 
-    handle->pipeline = gst_pipeline_new("NxGstMoviePlay");
-    if (NULL == handle->pipeline)
+struct DisplayRelink {
+    struct Sink         *sink;
+    struct Sink         *other;
+    enum DISPLAY_TYPE   type;
+};
+
+// The part of link_display() done while the decoder output is idle
+static NX_GST_RET relink_display(MP_HANDLE handle, gpointer data)
+{
+    struct DisplayRelink *relink = (struct DisplayRelink *)data;
+    struct Sink *sink = relink->sink;
+    struct Sink *other = relink->other;
+    enum DISPLAY_TYPE type = relink->type;
+    NX_GST_RET result = NX_GST_RET_OK;
+
+    // With a standby secondary branch the tee stays, so that activating it
+    // is only a link
+    if (NULL == other && !handle->secondary_standby)
     {
-        NXGLOGE("pipeline is NULL");
-        return NX_GST_RET_ERROR;
+        // video_src_pad <--> nxvideosink
+        GstPad *sinkpad = gst_element_get_static_pad(sink->nxvideosink, "sink");
+        if (move_video_src(handle, sinkpad)) {
+            sink->direct = TRUE;
+        } else {
+            result = NX_GST_RET_ERROR;
+        }
+        gst_object_unref(sinkpad);
+    }
+    else if (NULL == other)
+    {
+        // Only the standby branch is on the tee so far
+        // video_src_pad <--> tee <--> queue <--> nxvideosink
+        if (!move_video_src_to_tee(handle)) {
+            result = NX_GST_RET_ERROR;
+        }
+        if (NX_GST_RET_OK == result) {
+            result = link_tee_branch(sink, type);
+        }
+    }
+    else
+    {
+        if (other->direct)
+        {
+            // video_src_pad <--> tee <--> queue <--> nxvideosink of the other display
+            if (!move_video_src_to_tee(handle) ||
+                NX_GST_RET_ERROR == link_tee_branch(other,
+                    (DISPLAY_TYPE_PRIMARY == type) ? DISPLAY_TYPE_SECONDARY : DISPLAY_TYPE_PRIMARY))
+            {
+                result = NX_GST_RET_ERROR;
+            }
+        }
+        if (NX_GST_RET_OK == result) {
+            result = link_tee_branch(sink, type);
+        }
     }
-    handle->bus = gst_pipeline_get_bus(GST_PIPELINE(handle->pipeline));
-    handle->bus_watch_id = gst_bus_add_watch(handle->bus, (GstBusFunc)gst_bus_callback, handle);
-    gst_object_unref(handle->bus);
 
-    gint pIdx = handle->select_program_idx;
-    gint vIdx = handle->select_video_idx;
-    gint aIdx = handle->select_audio_idx;
-    gint sIdx = handle->select_subtitle_idx;
-    NXGLOGI("matched program index(%d), vIdx(%d), aIdx(%d), sIdx(%d)", pIdx, vIdx, aIdx, sIdx);
+    return result;
+}
 
-    if (handle->gst_media_info.ProgramInfo[pIdx].n_video == 0)
+/* A single display is linked straight to the decoder, without the tee and
+ * the queue thread. When a second display is added, the first one is moved
+ * behind the tee while the decoder output is idle. The tee is kept until
+ * no display is left. */
+NX_GST_RET link_display(MP_HANDLE handle, enum DISPLAY_TYPE type)
+{
+    NXGLOGI("Display type [%s]", (type == DISPLAY_TYPE_PRIMARY)?"PRIMARY":"SECONDARY");
+
+    if ((DISPLAY_TYPE_PRIMARY == type) && handle->primary_sinks)
     {
-        NXGLOGE("Failed to prepare nxvideoplayer - no video");
+        NXGLOGE("Failed to link the primary display");
         return NX_GST_RET_ERROR;
     }
-    if (!isSupportedContents(&handle->gst_media_info, pIdx, vIdx, aIdx, sIdx))
+    if ((DISPLAY_TYPE_SECONDARY == type) && handle->secondary_sinks)
     {
-        NXGLOGE("Failed to prepare nxvideoplayer - not supported contents");
+        NXGLOGE("Failed to link the secondary display");
         return NX_GST_RET_ERROR;
     }
-
-    if (NX_GST_RET_ERROR == set_source_element(handle) ||
-        NX_GST_RET_ERROR == set_demux_element(handle))
+    if (NULL == handle->video_src_pad)
     {
-        return NX_GST_RET_ERROR;
-    }
-    gst_bin_add_many(GST_BIN(handle->pipeline), handle->source, handle->demuxer, NULL);
-    if (NX_GST_RET_ERROR == gst_element_link_many(handle->source, handle->demuxer, NULL)) {
-        NXGLOGE("Failed to link source <--> demuxer");
+        NXGLOGE("The video elements are not linked");
         return NX_GST_RET_ERROR;
     }
 
-    // demuxer <--> audio_queue/video_queue/subtitle_queue
-    if (handle->demuxer) {
-        g_signal_connect(handle->demuxer, "pad-added",
-                G_CALLBACK (on_pad_added_demux), handle);
-    }
+    GList *others = (DISPLAY_TYPE_PRIMARY == type) ? handle->secondary_sinks:handle->primary_sinks;
+    struct Sink *other = others ? (struct Sink *)others->data : NULL;
+    struct Sink *sink;
+    NX_GST_RET result = NX_GST_RET_OK;
+    gint64 start_time = g_get_monotonic_time();
+    struct DisplayRelink *relink;
 
-    if (handle->gst_media_info.ProgramInfo[pIdx].n_video > 0)
+    if (DISPLAY_TYPE_SECONDARY == type)
     {
-        if (NX_GST_RET_ERROR == set_video_elements(handle)) {
-            return NX_GST_RET_ERROR;
-        }
-        add_video_elements_to_bin(handle);
-        if (NX_GST_RET_ERROR == link_video_elements(handle)) {
-            return NX_GST_RET_ERROR;
+        pthread_mutex_lock(&handle->stateLock);
+        sink = handle->standby_sink;
+        handle->standby_sink = NULL;
+        pthread_mutex_unlock(&handle->stateLock);
+
+        if (sink)
+        {
+            result = activate_standby_display(handle, sink);
+            handle->secondary_sinks = g_list_append (handle->secondary_sinks, sink);
+            record_activation_time(handle, start_time, TRUE);
+            return result;
         }
     }
 
-    if (handle->gst_media_info.ProgramInfo[pIdx].n_audio > 0)
+    sink = make_display_sink(handle, type);
+    if (!sink)
     {
-        if (NX_GST_RET_ERROR == set_audio_elements(handle)) {
-            return NX_GST_RET_ERROR;
-        }
-        add_audio_elements_to_bin(handle);
-        if (NX_GST_RET_ERROR == link_audio_elements(handle)) {
-            return NX_GST_RET_ERROR;
-        }
-        // decodbin <--> audio_converter
-        if (handle->audio_decoder) {
-            g_signal_connect(handle->audio_decoder, "pad-added",
-                    G_CALLBACK (on_decodebin_pad_added), handle);
-        }
+        NXGLOGE("Failed to create the video elements");
+        return NX_GST_RET_ERROR;
     }
 
-    if (handle->gst_media_info.ProgramInfo[pIdx].n_subtitle > 0)
-    {
-        if (handle->gst_media_info.ProgramInfo[pIdx].n_subtitle >= 1 &&
-            handle->gst_media_info.ProgramInfo[pIdx].SubtitleInfo[sIdx].type == SUBTITLE_TYPE_RAW)
-        {
-            if (NX_GST_RET_ERROR == set_subtitle_elements(handle)) {
-                return NX_GST_RET_ERROR;
-            }
-            add_subtitle_elements_to_bin(handle);
-            if (NX_GST_RET_ERROR == link_subtitle_elements(handle)) {
-                return NX_GST_RET_ERROR;
-            }
-        }
-    }
-
-    handle->rate = 1.0;
+    // Add element 'nxvideosink' to bin
+    gst_bin_add(GST_BIN(sink->pipeline), sink->nxvideosink);
+    gst_element_sync_state_with_parent (sink->nxvideosink);
 
-    handle->pipeline_is_linked = TRUE;
+    relink = g_new0(struct DisplayRelink, 1);
+    relink->sink = sink;
+    relink->other = other;
+    relink->type = type;
+    result = relink_video_src(handle, relink_display, relink, g_free);
 
-    ret = gst_element_set_state(handle->pipeline, GST_STATE_READY);
-    if (ret == GST_STATE_CHANGE_FAILURE) {
-        NXGLOGE("Failed to set the pipeline to the READY state");
-        return NX_GST_RET_ERROR;
+    if (DISPLAY_TYPE_PRIMARY == type) {
+        handle->primary_sinks = g_list_append (handle->primary_sinks, sink);
+    } else {
+        handle->secondary_sinks = g_list_append (handle->secondary_sinks, sink);
+        record_activation_time(handle, start_time, FALSE);
     }
-    
-    start_loop_thread(handle);
-    NXGLOGI("END");
 
-    return NX_GST_RET_OK;
+    return result;
 }
 
-NX_GST_RET NX_GSTMP_Open(MP_HANDLE *pHandle,
-        void (*cb)(void *owner, unsigned int eventType,
-        unsigned int eventData, void * param), void *cbOwner)
+// Parks the decoder output on the tee again, while it is idle
+static NX_GST_RET park_direct_display(MP_HANDLE handle, gpointer data)
 {
-    NXGLOGI("START");
+    struct Sink *sink = (struct Sink *)data;
+    GstStateChangeReturn state_ret;
+    NX_GST_RET result;
 
-    if(*pHandle)
-    {
-        // TODO:
-        NXGLOGE("handle is not freed");
-        return NX_GST_RET_ERROR;
-    }
+    result = move_video_src_to_tee(handle) ? NX_GST_RET_OK : NX_GST_RET_ERROR;
 
-    MP_HANDLE handle = (MP_HANDLE)g_malloc0(sizeof(MOVIE_TYPE));
-    if (NULL == handle)
-    {
-        NXGLOGE("Failed to alloc handle");
-        return NX_GST_RET_ERROR;
+    // No push is in progress, nxvideosink is idle and gets no more frames
+    state_ret = gst_element_set_state (sink->nxvideosink, GST_STATE_NULL);
+    if (state_ret == GST_STATE_CHANGE_FAILURE) {
+        NXGLOGE("Failed to set nxvideosink to the NULL state");
     }
-
-    pthread_mutex_init(&handle->apiLock, NULL);
-    pthread_mutex_init(&handle->stateLock, NULL);
-
-    _CAutoLock lock(&handle->apiLock);
-
-    handle->owner = cbOwner;
-    handle->callback = cb;
-    handle->display_mode = DISPLAY_MODE_LCD_ONLY;
-
-    if(!gst_is_initialized())
-    {
-        gst_init(NULL, NULL);
+    if (!gst_bin_remove (GST_BIN (sink->pipeline), sink->nxvideosink)) {
+        NXGLOGE("Failed to remove nxvideosink from bin");
     }
 
-    *pHandle = handle;
-
-    NXGLOGI("END");
+    return result;
+}
 
-    return NX_GST_RET_OK;
+/* Parks the decoder output on the tee again and removes nxvideosink once
+ * the push in progress, if any, has returned. Stopping it in the middle of a
+ * frame would return FLUSHING to the decoder and stall the video branch. */
+static void unlink_direct_display(MP_HANDLE handle, struct Sink *sink)
+{
+    relink_video_src(handle, park_direct_display, sink, g_free);
 }
 
-void NX_GSTMP_Close(MP_HANDLE handle)
+// Unlinks the branch from the tee, then stops and removes it
+static void remove_tee_branch(struct Sink *sink)
 {
-    _CAutoLock lock(&handle->apiLock);
+    GstStateChangeReturn state_ret;
 
-    NXGLOGI("START");
+    // Unlink tee:src_<-->queue:sink
+    GstPad *sinkpad;
+    sinkpad = gst_element_get_static_pad (sink->queue, "sink");
+    gboolean ret = gst_pad_unlink (sink->tee_pad, sinkpad);
+    NXGLOGI(" ==> %s to unlink %s:%s from %s:%s",
+            (ret == true) ? "Succeed":"Failed",
+            GST_DEBUG_PAD_NAME(sink->tee_pad),
+            GST_DEBUG_PAD_NAME(sinkpad));
+    gst_object_unref (sinkpad);
 
-    if (NULL == handle)
-    {
-        NXGLOGE("handle is already NULL");
-        return;
+    // set state of 'nxvideosink' and 'queue' to NULL
+    state_ret = gst_element_set_state (sink->nxvideosink, GST_STATE_NULL);
+    if (state_ret == GST_STATE_CHANGE_FAILURE) {
+        NXGLOGE("Failed to set nxvideosink to the NULL state");
     }
-
-    if(handle->pipeline_is_linked)
-    {
-        gst_element_set_state(handle->pipeline, GST_STATE_NULL);
-
-        unlink_display(DISPLAY_TYPE_PRIMARY);
-        unlink_display(DISPLAY_TYPE_SECONDARY);
-
-        if (NULL != handle->pipeline)
-        {
-            gst_object_unref(handle->pipeline);
-            handle->pipeline = NULL;
-        }
-        g_source_remove(handle->bus_watch_id);
-        stop_my_thread(handle);
-        handle->pipeline_is_linked = FALSE;
+    state_ret = gst_element_set_state (sink->queue, GST_STATE_NULL);
+    if (state_ret == GST_STATE_CHANGE_FAILURE) {
+        NXGLOGE("Failed to set queue to the NULL state");
     }
 
-    pthread_mutex_destroy(&handle->apiLock);
-    pthread_mutex_destroy(&handle->stateLock);
-
-    g_free(handle->filePath);
-    g_free(handle);
+    // remove queue and nxvideosink
+    if (!gst_bin_remove (GST_BIN (sink->pipeline), sink->queue)) {
+        NXGLOGE("Failed to remove queue from bin");
+    }
+    if (!gst_bin_remove (GST_BIN (sink->pipeline), sink->nxvideosink)) {
+        NXGLOGE("Failed to remove nxvideosink from bin");
+    }
 
-    NXGLOGI("END");
+    // release_request_pad and unref 'tee_pad'
+    gst_element_release_request_pad (sink->tee, sink->tee_pad);
+    gst_object_unref (sink->tee_pad);
 }
 
-NX_GST_RET
-NX_GSTMP_GetMediaInfo(MP_HANDLE handle, const char* filePath, GST_MEDIA_INFO *pGstMInfo)
+static GstPadProbeReturn
+unlink_display_cb (GstPad* pad, GstPadProbeInfo* info, gpointer user_data)
 {
-    _CAutoLock lock(&handle->apiLock);
+    struct Sink *sink = (struct Sink *)user_data;
 
-    NXGLOGI("START");
+    NXGLOGI();
 
-    if (NULL == pGstMInfo || NULL == handle)
+    if (!g_atomic_int_compare_and_exchange (&sink->removing, FALSE, TRUE))
     {
-        NXGLOGE("pGstMInfo/handle is NULL");
-        return NX_GST_RET_ERROR;
+        NXGLOGI("- GST_PAD_PROBE_OK");
+        return GST_PAD_PROBE_OK;
     }
 
-    CopyMediaInfo(pGstMInfo, &handle->gst_media_info);
+    remove_tee_branch(sink);
 
-    NXGLOGI("END");
-    return NX_GST_RET_OK;
+    NXGLOGI("- GST_PAD_PROBE_REMOVE");
+    return GST_PAD_PROBE_REMOVE;
 }
 
-NX_GST_RET
-NX_GSTMP_SetDisplayInfo(MP_HANDLE handle, enum DISPLAY_TYPE type,
-                        int dspWidth, int dspHeight, struct DSP_RECT rect)
+// Puts the secondary branch back on standby instead of removing it
+static GstPadProbeReturn
+park_display_cb (GstPad* pad, GstPadProbeInfo* info, gpointer user_data)
 {
-    _CAutoLock lock(&handle->apiLock);
-
-    FUNC_IN();
+    struct Sink *sink = (struct Sink *)user_data;
+    MP_HANDLE handle = sink->handle;
 
-    if (NULL == handle)
+    if (!g_atomic_int_compare_and_exchange (&sink->removing, FALSE, TRUE))
     {
-        NXGLOGE("handle is NULL");
-        return NX_GST_RET_ERROR;
+        return GST_PAD_PROBE_OK;
     }
 
-    memcpy(&handle->gst_media_info, &rect, sizeof(struct DSP_RECT));
-
-    NXGLOGD("left(%d), right(%d), top(%d), bottom(%d), dspWidth(%d), dspHeight(%d)",
-            rect.left, rect.right, rect.top, rect.bottom, dspWidth, dspHeight);
-
-    if (type == DISPLAY_TYPE_SECONDARY)
-    {
-        memcpy(&handle->secondary_dsp_rect, &rect, sizeof(struct DSP_RECT));
-    }
-    else
+    pthread_mutex_lock(&handle->stateLock);
+    if (NULL != handle->standby_sink)
     {
-        memcpy(&handle->primary_dsp_rect, &rect, sizeof(struct DSP_RECT));
+        // The display was linked again with a new branch meanwhile
+        pthread_mutex_unlock(&handle->stateLock);
+        remove_tee_branch(sink);
+        g_free(sink);
+        return GST_PAD_PROBE_REMOVE;
     }
+    pthread_mutex_unlock(&handle->stateLock);
 
-    FUNC_OUT();
+    GstPad *sinkpad = gst_element_get_static_pad (sink->queue, "sink");
+    gst_pad_unlink (sink->tee_pad, sinkpad);
+    gst_object_unref (sinkpad);
 
-    return NX_GST_RET_OK;
-}
+    gst_element_set_locked_state(sink->queue, TRUE);
+    gst_element_set_locked_state(sink->nxvideosink, TRUE);
+    gst_element_set_state(sink->nxvideosink, GST_STATE_READY);
+    gst_element_set_state(sink->queue, GST_STATE_READY);
+    sink->removing = FALSE;
 
-int64_t NX_GSTMP_GetPosition(MP_HANDLE handle)
-{
-    _CAutoLock lock(&handle->apiLock);
+    pthread_mutex_lock(&handle->stateLock);
+    handle->standby_sink = sink;
+    pthread_mutex_unlock(&handle->stateLock);
 
-    GstState state, pending;
-    GstStateChangeReturn ret;
-    gint64 position;
+    NXGLOGI("The secondary display is on standby");
+    return GST_PAD_PROBE_REMOVE;
+}
 
-    FUNC_IN();
+void unlink_display(MP_HANDLE handle, enum DISPLAY_TYPE type)
+{
+    NXGLOGI("Display type [%s]", (type == DISPLAY_TYPE_PRIMARY)?"PRIMARY":"SECONDARY");
 
-    if (!handle || !handle->pipeline_is_linked) {
-        return -1;
-    }
+    struct Sink *sink;
+    GList *sinks = (DISPLAY_TYPE_PRIMARY == type) ? handle->primary_sinks:handle->secondary_sinks;
 
-    ret = gst_element_get_state(handle->pipeline, &state, &pending, 500000000);		//	wait 500 msec
-    if (GST_STATE_CHANGE_FAILURE != ret)
+    if (g_list_length(sinks) > 0)
     {
-        if ((GST_STATE_PLAYING == state) || (GST_STATE_PAUSED == state))
+        if (DISPLAY_TYPE_PRIMARY == type)
         {
-            GstFormat format = GST_FORMAT_TIME;
-            if (gst_element_query_position(handle->pipeline, format, &position))
-            {
-                //NXGLOGV("Position: %" GST_TIME_FORMAT "\r",
-                //        __func__, GST_TIME_ARGS (position));
-            }
+            sink = (Sink*)handle->primary_sinks->data;
+            handle->primary_sinks = g_list_delete_link (handle->primary_sinks, handle->primary_sinks);
         }
         else
         {
-            NXGLOGE("Invalid state to query POSITION");
-            return -1;
+            sink = (Sink*)handle->secondary_sinks->data;
+            handle->secondary_sinks = g_list_delete_link (handle->secondary_sinks, handle->secondary_sinks);
+        }
+        if (sink->direct) {
+            unlink_direct_display(handle, sink);
+        } else if (DISPLAY_TYPE_SECONDARY == type && handle->secondary_standby) {
+            gst_pad_add_probe (sink->tee_pad, GST_PAD_PROBE_TYPE_IDLE,
+                                (GstPadProbeCallback)park_display_cb, sink, NULL);
+        } else {
+            gst_pad_add_probe (sink->tee_pad, GST_PAD_PROBE_TYPE_IDLE,
+                                (GstPadProbeCallback)unlink_display_cb, sink,
+                                (GDestroyNotify) g_free);
         }
     }
-    else
-    {
-        NXGLOGE("Failed to query POSITION");
-        return -1;
-    }
-
-    //FUNC_OUT();
-
-    return position;
 }
 
-int64_t NX_GSTMP_GetDuration(MP_HANDLE handle)
+NX_GST_RET NX_GSTMP_SetDisplayMode(MP_HANDLE handle, enum DISPLAY_MODE in_mode)
 {
     _CAutoLock lock(&handle->apiLock);
 
-    GstState state, pending;
-    GstStateChangeReturn ret;
-    gint64 duration;
+    FUNC_IN();
 
-    //FUNC_IN();
+    if (NULL == handle)
+    {
+        NXGLOGE("handle is NULL");
+        return NX_GST_RET_ERROR;
+    }
 
-    if (!handle || !handle->pipeline_is_linked)
+    if ((in_mode < DISPLAY_MODE_LCD_ONLY) ||
+        (in_mode > DISPLAY_MODE_NONE))
     {
-        NXGLOGE(": invalid state or invalid operation.(%p,%d)\n",
-                handle, handle->pipeline_is_linked);
-        return -1;
+        NXGLOGE("Failed to set display mode - Invalid Display Mode");
+        return NX_GST_RET_ERROR;
     }
 
-    ret = gst_element_get_state(handle->pipeline, &state, &pending, 500000000);		//	wait 500 msec
-    if (GST_STATE_CHANGE_FAILURE != ret)
+    enum DISPLAY_MODE old_mode = handle->display_mode;
+
+    NXGLOGI("The display mode is changed from (%s) to (%s) in state(%s)",
+            get_display_mode_str(old_mode),
+            get_display_mode_str(in_mode),
+            gst_element_state_get_name (handle->state));
+
+    if ((handle->pipeline_is_linked) && (old_mode != in_mode))
     {
-        NXGLOGI("state(%d)", state);
-        if (state == GST_STATE_PLAYING || state == GST_STATE_PAUSED)
+        if (handle->state == GST_STATE_PAUSED || handle->state == GST_STATE_PLAYING)
         {
-            GstFormat format = GST_FORMAT_TIME;
-            if (gst_element_query_duration(handle->pipeline, format, &duration))
+            if (DISPLAY_MODE_LCD_ONLY == old_mode)
             {
-                NXGLOGI("Duration: %" GST_TIME_FORMAT "\r",
-                        GST_TIME_ARGS (duration));
+                if (DISPLAY_MODE_NONE == in_mode) {
+                    unlink_display(handle, DISPLAY_TYPE_PRIMARY);
+                } else {
+                    link_display(handle, DISPLAY_TYPE_SECONDARY);
+                    if (DISPLAY_MODE_HDMI_ONLY == in_mode)
+                    {
+                        unlink_display(handle, DISPLAY_TYPE_PRIMARY);
+                    }
+                }
             }
-        }
-        else
-        {
-            NXGLOGE("Invalid state to query DURATION");
-            return -1;
-        }
+            else if (DISPLAY_MODE_HDMI_ONLY == old_mode)
+            {
+                if (DISPLAY_MODE_NONE == in_mode) {
+                    unlink_display(handle, DISPLAY_TYPE_SECONDARY);
+                } else {
+                    link_display(handle, DISPLAY_TYPE_PRIMARY);
+                    if (DISPLAY_MODE_LCD_ONLY == in_mode)
+                    {
+                        unlink_display(handle, DISPLAY_TYPE_SECONDARY);
+                    }
+                }
+            }
+            else if (DISPLAY_MODE_LCD_HDMI == old_mode)
+            {
+                if (DISPLAY_MODE_NONE == in_mode) {
+                    unlink_display(handle, DISPLAY_TYPE_PRIMARY);
+                    unlink_display(handle, DISPLAY_TYPE_SECONDARY);
+                } else {
+                    if (DISPLAY_MODE_LCD_ONLY == in_mode)
+                    {
+                        unlink_display(handle, DISPLAY_TYPE_SECONDARY);
+                    }
+                    else if (DISPLAY_MODE_HDMI_ONLY == in_mode)
+                    {
+                        unlink_display(handle, DISPLAY_TYPE_PRIMARY);
+                    }
+                }
+            }
+            else
+            {
+                if (DISPLAY_MODE_LCD_ONLY == in_mode) {
+                    link_display(handle, DISPLAY_TYPE_PRIMARY);
+                } else if (DISPLAY_MODE_HDMI_ONLY == in_mode) {
+                    link_display(handle, DISPLAY_TYPE_SECONDARY);
+                } else if (DISPLAY_MODE_LCD_HDMI == in_mode) {
+                    link_display(handle, DISPLAY_TYPE_PRIMARY);
+                    link_display(handle, DISPLAY_TYPE_SECONDARY);
+                }
+            }
+
+            if (DISPLAY_MODE_NONE == in_mode) {
+                suspend_video(handle);
+            } else if (DISPLAY_MODE_NONE == old_mode) {
+                resume_video(handle);
+            }
+        }
+    }
+    handle->display_mode = in_mode;
+
+    return NX_GST_RET_OK;
+}
+
+NX_GST_RET NX_GSTMP_SetUri(MP_HANDLE handle, const char *filePath)
+{
+    _CAutoLock lock(&handle->apiLock);
+
+    NXGLOGI("%s", filePath);
+
+    if(NULL == handle)
+    {
+        NXGLOGE("handle is NULL");
+        return NX_GST_RET_ERROR;
+    }
+    handle->filePath = g_strdup(filePath);
+    handle->error = NX_GST_ERROR_NONE;
+
+    // Start to parse media info
+    struct GST_MEDIA_INFO *media_info;
+    NX_GST_RET result = OpenMediaInfo(&media_info);
+    if (NX_GST_RET_OK != result) {
+        return NX_GST_RET_ERROR;
+    }
+
+    enum NX_GST_ERROR err = ParseMediaInfo(media_info, filePath);
+    if (NX_GST_ERROR_NONE != err)
+    {
+        handle->error = err;
+        NXGLOGE("%s", get_nx_gst_error(err));
+
+        CloseMediaInfo(media_info);
+        return NX_GST_RET_ERROR;
+    }
+
+    // Copy the parsed media info to handle->gst_media_info
+    CopyMediaInfo(&handle->gst_media_info, media_info);
+    PrintMediaInfo(&handle->gst_media_info, filePath);
+    CloseMediaInfo(media_info);
+    // Done to parse media info
+
+    // Subtitle file next to the media file, the one of the previous file
+    // is dropped otherwise
+    gchar *subtitlePath = NX_FindSidecarSubtitle(filePath);
+    if (subtitlePath) {
+        NXGLOGI("Found external subtitle %s", subtitlePath);
+    }
+    set_ext_subtitle(handle, subtitlePath);
+    g_free(subtitlePath);
+
+#ifdef SW_V_DECODER
+    if (handle->gst_media_info.container_type > CONTAINER_TYPE_FLV)
+#else
+    if (handle->gst_media_info.container_type >= CONTAINER_TYPE_FLV)
+#endif
+    {
+        NXGLOGE("Not supported container type");
+        return NX_GST_RET_ERROR;
+    }
+    if (handle->gst_media_info.container_type != CONTAINER_TYPE_MPEGTS)
+    {
+        if (handle->gst_media_info.ProgramInfo[0].n_video == 0)
+        {
+            NXGLOGE("Not supported contents(audio only)");
+            return NX_GST_RET_ERROR;
+        }
+    }
+
+    NXGLOGI("END");
+
+    return NX_GST_RET_OK;
+}
+
+gboolean isSupportedContents(struct GST_MEDIA_INFO *media_info,
+    int pIdx, int vIdx, int aIdx, int sIdx)
+{
+    CONTAINER_TYPE container_type;
+    VIDEO_TYPE video_type;
+
+    container_type = media_info->container_type;
+    /* Quicktime, 3GP, Matroska, AVI, MPEG (vob) */
+    if ((container_type == CONTAINER_TYPE_MPEGTS) ||
+        (container_type == CONTAINER_TYPE_QUICKTIME) ||
+        (container_type == CONTAINER_TYPE_MSVIDEO) ||
+        (container_type == CONTAINER_TYPE_MATROSKA) ||
+        (container_type == CONTAINER_TYPE_3GP) ||
+        (container_type == CONTAINER_TYPE_MPEG)
+#ifdef SW_V_DECODER
+        || (container_type == CONTAINER_TYPE_FLV)
+#endif
+        )
+    {
+        if (media_info->ProgramInfo[pIdx].n_video == 0)
+        {
+            NXGLOGE("There is no video to play");
+            return FALSE;
+        }
+
+        video_type = media_info->ProgramInfo[pIdx].VideoInfo[vIdx].type;
+        if (!IS_SUPPORTED_VIDEO_TYPE(video_type))
+        {
+            NXGLOGE("Not supported video type(%d)", video_type);
+            return FALSE;
+        }
+
+        return TRUE;
+    }
+    else
+    {
+        NXGLOGE("Not supported container type(%d)", container_type);
+        return FALSE;
+    }
+}
+
+NX_GST_RET NX_GSTMP_Prepare(MP_HANDLE handle)
+{
+    _CAutoLock lock(&handle->apiLock);
+
+    NXGLOGI("START");
+
+    GstStateChangeReturn ret;
+
+    if(handle->pipeline_is_linked)
+    {
+        NXGLOGE("pipeline is already linked");
+        // TODO:
+        return NX_GST_RET_OK;
+    }
+
+    handle->pipeline = gst_pipeline_new("NxGstMoviePlay");
+    if (NULL == handle->pipeline)
+    {
+        NXGLOGE("pipeline is NULL");
+        return NX_GST_RET_ERROR;
+    }
+    handle->bus = gst_pipeline_get_bus(GST_PIPELINE(handle->pipeline));
+    handle->bus_watch_id = gst_bus_add_watch(handle->bus, (GstBusFunc)gst_bus_callback, handle);
+    gst_object_unref(handle->bus);
+
+    gint pIdx = handle->select_program_idx;
+    gint vIdx = handle->select_video_idx;
+    gint aIdx = handle->select_audio_idx;
+    gint sIdx = handle->select_subtitle_idx;
+    NXGLOGI("matched program index(%d), vIdx(%d), aIdx(%d), sIdx(%d)", pIdx, vIdx, aIdx, sIdx);
+
+    if (handle->gst_media_info.ProgramInfo[pIdx].n_video == 0)
+    {
+        NXGLOGE("Failed to prepare nxvideoplayer - no video");
+        return NX_GST_RET_ERROR;
+    }
+    if (!isSupportedContents(&handle->gst_media_info, pIdx, vIdx, aIdx, sIdx))
+    {
+        NXGLOGE("Failed to prepare nxvideoplayer - not supported contents");
+        return NX_GST_RET_ERROR;
+    }
+
+    if (NX_GST_RET_ERROR == set_source_element(handle) ||
+        NX_GST_RET_ERROR == set_demux_element(handle))
+    {
+        return NX_GST_RET_ERROR;
+    }
+    gst_bin_add_many(GST_BIN(handle->pipeline), handle->source, handle->demuxer, NULL);
+    if (NX_GST_RET_ERROR == gst_element_link_many(handle->source, handle->demuxer, NULL)) {
+        NXGLOGE("Failed to link source <--> demuxer");
+        return NX_GST_RET_ERROR;
+    }
+
+    // demuxer <--> audio_queue/video_queue/subtitle_queue
+    if (handle->demuxer) {
+        g_signal_connect(handle->demuxer, "pad-added",
+                G_CALLBACK (on_pad_added_demux), handle);
+    }
+
+    if (handle->gst_media_info.ProgramInfo[pIdx].n_video > 0)
+    {
+        if (NX_GST_RET_ERROR == set_video_elements(handle)) {
+            return NX_GST_RET_ERROR;
+        }
+        add_video_elements_to_bin(handle);
+        if (NX_GST_RET_ERROR == link_video_elements(handle)) {
+            return NX_GST_RET_ERROR;
+        }
+        if (handle->secondary_standby) {
+            make_standby_display(handle);
+        }
+    }
+
+    if (handle->gst_media_info.ProgramInfo[pIdx].n_audio > 0)
+    {
+        if (NX_GST_RET_ERROR == set_audio_elements(handle)) {
+            return NX_GST_RET_ERROR;
+        }
+        add_audio_elements_to_bin(handle);
+        if (NX_GST_RET_ERROR == link_audio_elements(handle)) {
+            return NX_GST_RET_ERROR;
+        }
+        // decodbin <--> audio_converter
+        if (handle->audio_decoder && NULL == handle->audio_parser) {
+            g_signal_connect(handle->audio_decoder, "pad-added",
+                    G_CALLBACK (on_decodebin_pad_added), handle);
+        }
+    }
+
+    // An external subtitle replaces the embedded one
+    if (handle->gst_media_info.ProgramInfo[pIdx].n_subtitle > 0 && NULL == handle->ext_subtitle)
+    {
+        if (handle->gst_media_info.ProgramInfo[pIdx].n_subtitle >= 1 &&
+            handle->gst_media_info.ProgramInfo[pIdx].SubtitleInfo[sIdx].type == SUBTITLE_TYPE_RAW)
+        {
+            if (NX_GST_RET_ERROR == set_subtitle_elements(handle)) {
+                return NX_GST_RET_ERROR;
+            }
+            add_subtitle_elements_to_bin(handle);
+            if (NX_GST_RET_ERROR == link_subtitle_elements(handle)) {
+                return NX_GST_RET_ERROR;
+            }
+        }
+    }
+
+    handle->rate = 1.0;
+
+    handle->pipeline_is_linked = TRUE;
+
+    ret = gst_element_set_state(handle->pipeline, GST_STATE_READY);
+    if (ret == GST_STATE_CHANGE_FAILURE) {
+        NXGLOGE("Failed to set the pipeline to the READY state");
+        return NX_GST_RET_ERROR;
+    }
+    
+    start_loop_thread(handle);
+    NXGLOGI("END");
+
+    return NX_GST_RET_OK;
+}
+
+NX_GST_RET NX_GSTMP_Open(MP_HANDLE *pHandle,
+        void (*cb)(void *owner, unsigned int eventType,
+        unsigned int eventData, void * param), void *cbOwner)
+{
+    NXGLOGI("START");
+
+    if(*pHandle)
+    {
+        // TODO:
+        NXGLOGE("handle is not freed");
+        return NX_GST_RET_ERROR;
+    }
+
+    MP_HANDLE handle = (MP_HANDLE)g_malloc0(sizeof(MOVIE_TYPE));
+    if (NULL == handle)
+    {
+        NXGLOGE("Failed to alloc handle");
+        return NX_GST_RET_ERROR;
+    }
+
+    pthread_mutex_init(&handle->apiLock, NULL);
+    pthread_mutex_init(&handle->stateLock, NULL);
+
+    _CAutoLock lock(&handle->apiLock);
+
+    handle->owner = cbOwner;
+    handle->callback = cb;
+    handle->display_mode = DISPLAY_MODE_LCD_ONLY;
+    handle->event_queue = NX_CreateEventQueue(EVENT_QUEUE_SIZE, EVENT_QUEUE_RESERVED);
+    handle->ext_subtitle_cue = -1;
+    handle->sw_vdec_config.skip_loop_filter_lateness = SW_VDEC_SKIP_LOOP_FILTER_LATENESS;
+    handle->sw_vdec_config.skip_frame_lateness = SW_VDEC_SKIP_FRAME_LATENESS;
+    handle->sw_vdec_config.max_width = SW_VDEC_MAX_WIDTH;
+    handle->sw_vdec_config.max_height = SW_VDEC_MAX_HEIGHT;
+
+    if(!gst_is_initialized())
+    {
+        gst_init(NULL, NULL);
+    }
+
+    *pHandle = handle;
+
+    NXGLOGI("END");
+
+    return NX_GST_RET_OK;
+}
+
+void NX_GSTMP_Close(MP_HANDLE handle)
+{
+    _CAutoLock lock(&handle->apiLock);
+
+    NXGLOGI("START");
+
+    if (NULL == handle)
+    {
+        NXGLOGE("handle is already NULL");
+        return;
+    }
+
+    // Wait for the pending captures, their events are dropped below
+    if (NULL != handle->capture_pool) {
+        g_thread_pool_free(handle->capture_pool, FALSE, TRUE);
+        handle->capture_pool = NULL;
+    }
+
+    if(handle->pipeline_is_linked)
+    {
+        // Remove the secondary branch instead of parking it
+        handle->secondary_standby = FALSE;
+
+        gst_element_set_state(handle->pipeline, GST_STATE_NULL);
+
+        unlink_display(handle, DISPLAY_TYPE_PRIMARY);
+        unlink_display(handle, DISPLAY_TYPE_SECONDARY);
+        // After the NULL state, a branch parked meanwhile is caught as well
+        drop_standby_display(handle);
+
+        if (NULL != handle->pipeline)
+        {
+            gst_object_unref(handle->pipeline);
+            handle->pipeline = NULL;
+        }
+        g_source_remove(handle->bus_watch_id);
+        stop_my_thread(handle);
+        handle->pipeline_is_linked = FALSE;
+    }
+    if (NULL != handle->demux_video_pad) {
+        gst_object_unref(handle->demux_video_pad);
+        handle->demux_video_pad = NULL;
+    }
+    if (NULL != handle->video_src_pad) {
+        gst_object_unref(handle->video_src_pad);
+        handle->video_src_pad = NULL;
+    }
+
+    // Drop the events which were not delivered yet
+    NX_EVENT event;
+    while (NX_PopEvent(handle->event_queue, &event)) {
+        free_event_param(handle, &event);
+    }
+    NX_DestroyEventQueue(handle->event_queue);
+
+    for (int i = 0; i < SUBTITLE_RING_SIZE; i++) {
+        g_free(handle->subtitle_ring[i].info.subtitleText);
+    }
+    NX_FreeSubtitleTrack(handle->ext_subtitle);
+
+    pthread_mutex_destroy(&handle->apiLock);
+    pthread_mutex_destroy(&handle->stateLock);
+
+    g_free(handle->filePath);
+    g_free(handle);
+
+    NXGLOGI("END");
+}
+
+NX_GST_RET
+NX_GSTMP_GetMediaInfo(MP_HANDLE handle, const char* filePath, GST_MEDIA_INFO *pGstMInfo)
+{
+    _CAutoLock lock(&handle->apiLock);
+
+    NXGLOGI("START");
+
+    if (NULL == pGstMInfo || NULL == handle)
+    {
+        NXGLOGE("pGstMInfo/handle is NULL");
+        return NX_GST_RET_ERROR;
+    }
+
+    CopyMediaInfo(pGstMInfo, &handle->gst_media_info);
+
+    NXGLOGI("END");
+    return NX_GST_RET_OK;
+}
+
+NX_GST_RET
+NX_GSTMP_SetDisplayInfo(MP_HANDLE handle, enum DISPLAY_TYPE type,
+                        int dspWidth, int dspHeight, struct DSP_RECT rect)
+{
+    _CAutoLock lock(&handle->apiLock);
+
+    FUNC_IN();
+
+    if (NULL == handle)
+    {
+        NXGLOGE("handle is NULL");
+        return NX_GST_RET_ERROR;
+    }
+
+    if (type != DISPLAY_TYPE_SECONDARY) {
+        type = DISPLAY_TYPE_PRIMARY;
+    }
+
+    handle->gst_media_info.dsp_rect = rect;
+
+    NXGLOGD("left(%d), right(%d), top(%d), bottom(%d), dspWidth(%d), dspHeight(%d)",
+            rect.left, rect.right, rect.top, rect.bottom, dspWidth, dspHeight);
+
+    if (type == DISPLAY_TYPE_SECONDARY)
+    {
+        memcpy(&handle->secondary_dsp_rect, &rect, sizeof(struct DSP_RECT));
+    }
+    else
+    {
+        memcpy(&handle->primary_dsp_rect, &rect, sizeof(struct DSP_RECT));
+    }
+
+    // A running transition of this display is replaced
+    pthread_mutex_lock(&handle->stateLock);
+    handle->dsp_anim[type].active = FALSE;
+    pthread_mutex_unlock(&handle->stateLock);
+
+    update_display_rect(handle, type, &rect);
+
+    FUNC_OUT();
+
+    return NX_GST_RET_OK;
+}
+
+NX_GST_RET
+NX_GSTMP_AnimateDisplayRect(MP_HANDLE handle, enum DISPLAY_TYPE type,
+                        struct DSP_RECT rect, int32_t duration_ms)
+{
+    _CAutoLock lock(&handle->apiLock);
+
+    FUNC_IN();
+
+    if (NULL == handle)
+    {
+        NXGLOGE("handle is NULL");
+        return NX_GST_RET_ERROR;
+    }
+    if (type != DISPLAY_TYPE_PRIMARY && type != DISPLAY_TYPE_SECONDARY)
+    {
+        NXGLOGE("Invalid display type(%d)", type);
+        return NX_GST_RET_ERROR;
+    }
+
+    struct DSP_RECT *target = (type == DISPLAY_TYPE_SECONDARY) ?
+            &handle->secondary_dsp_rect : &handle->primary_dsp_rect;
+    struct DspAnimation *anim = &handle->dsp_anim[type];
+
+    pthread_mutex_lock(&handle->stateLock);
+    // Starts from where a running transition is
+    anim->from = anim->active ? anim->current : *target;
+    // Displays linked from now on start at the end of the transition
+    *target = rect;
+    anim->to = rect;
+    anim->start_time = g_get_monotonic_time();
+    anim->duration_us = (gint64)MAX(duration_ms, 0) * 1000;
+    anim->active = TRUE;
+
+    if (NULL == handle->dsp_anim_source && NULL != handle->context)
+    {
+        handle->dsp_anim_source = g_timeout_source_new(DSP_ANIM_INTERVAL_MS);
+        g_source_set_callback(handle->dsp_anim_source, display_anim_cb, handle, NULL);
+        g_source_attach(handle->dsp_anim_source, handle->context);
+    }
+    else if (NULL == handle->context)
+    {
+        // Not prepared yet, nothing to animate
+        anim->active = FALSE;
+    }
+    pthread_mutex_unlock(&handle->stateLock);
+
+    FUNC_OUT();
+
+    return NX_GST_RET_OK;
+}
+
+int64_t NX_GSTMP_GetPosition(MP_HANDLE handle)
+{
+    _CAutoLock lock(&handle->apiLock);
+
+    GstState state, pending;
+    GstStateChangeReturn ret;
+    gint64 position;
+
+    FUNC_IN();
+
+    if (!handle || !handle->pipeline_is_linked) {
+        return -1;
+    }
+
+    ret = gst_element_get_state(handle->pipeline, &state, &pending, 500000000);		//	wait 500 msec
+    if (GST_STATE_CHANGE_FAILURE != ret)
+    {
+        if ((GST_STATE_PLAYING == state) || (GST_STATE_PAUSED == state))
+        {
+            GstFormat format = GST_FORMAT_TIME;
+            if (gst_element_query_position(handle->pipeline, format, &position))
+            {
+                //NXGLOGV("Position: %" GST_TIME_FORMAT "\r",
+                //        __func__, GST_TIME_ARGS (position));
+            }
+        }
+        else
+        {
+            NXGLOGE("Invalid state to query POSITION");
+            return -1;
+        }
+    }
+    else
+    {
+        NXGLOGE("Failed to query POSITION");
+        return -1;
+    }
+
+    //FUNC_OUT();
+
+    return position;
+}
+
+int64_t NX_GSTMP_GetDuration(MP_HANDLE handle)
+{
+    _CAutoLock lock(&handle->apiLock);
+
+    GstState state, pending;
+    GstStateChangeReturn ret;
+    gint64 duration;
+
+    //FUNC_IN();
+
+    if (!handle || !handle->pipeline_is_linked)
+    {
+        NXGLOGE(": invalid state or invalid operation.(%p,%d)\n",
+                handle, handle->pipeline_is_linked);
+        return -1;
+    }
+
+    ret = gst_element_get_state(handle->pipeline, &state, &pending, 500000000);		//	wait 500 msec
+    if (GST_STATE_CHANGE_FAILURE != ret)
+    {
+        NXGLOGI("state(%d)", state);
+        if (state == GST_STATE_PLAYING || state == GST_STATE_PAUSED)
+        {
+            GstFormat format = GST_FORMAT_TIME;
+            if (gst_element_query_duration(handle->pipeline, format, &duration))
+            {
+                NXGLOGI("Duration: %" GST_TIME_FORMAT "\r",
+                        GST_TIME_ARGS (duration));
+            }
+        }
+        else
+        {
+            NXGLOGE("Invalid state to query DURATION");
+            return -1;
+        }
+    }
+    else
+    {
+        NXGLOGE("Failed to query DURATION");
+        return -1;
+    }
+
+    //FUNC_OUT();
+
+    return duration;
+}
+
+NX_GST_RET NX_GSTMP_SetVolume(MP_HANDLE handle, int volume)
+{
+    _CAutoLock lock(&handle->apiLock);
+
+    FUNC_IN();
+
+    if (!handle || !handle->alsasink || !handle->volume)
+    {
+        return NX_GST_RET_ERROR;
+    }
+
+    gdouble vol = (double)volume/100.;
+    NXGLOGI("set volume to %f", vol);
+    g_object_set(G_OBJECT (handle->volume), "volume", vol, NULL);
+
+    FUNC_OUT();
+
+    return NX_GST_RET_OK;
+}
+
+#ifdef STEP_SEEK
+static gboolean send_step_event(MP_HANDLE handle)
+{
+    gboolean ret;
+
+    if (handle->nxvideosink == NULL)
+    {
+        /* If we have not done so, obtain the sink through which we will send the step events */
+        g_object_get(handle->pipeline, "video-sink", &handle->nxvideosink, NULL);
+    }
+
+    ret = gst_element_send_event (handle->nxvideosink,
+                    gst_event_new_step(GST_FORMAT_BUFFERS, 1,
+                                        ABS (handle->rate), TRUE, FALSE));
+
+    NXGLOGI("Stepping one frame");
+
+    return ret;
+}
+#endif
+
+static int send_seek_event(MP_HANDLE handle)
+{
+    int ret = -1;
+    gint64 position;
+    GstEvent *seek_event;
+    GstFormat format = GST_FORMAT_TIME;
+    //GstSeekFlags flags = (GstSeekFlags)(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_SNAP_AFTER | GST_SEEK_FLAG_KEY_UNIT);
+    GstSeekFlags flags = (GstSeekFlags)(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE);
+
+    /* Obtain the current position, needed for the seek event */
+    if (!gst_element_query_position (handle->pipeline, format, &position))
+    {
+        NXGLOGE("Unable to retrieve current position");
+        return ret;
+    }
+
+    /* Create the seek event */
+    if (handle->rate > 0)
+    {
+        seek_event =
+            gst_event_new_seek (handle->rate, format, flags,
+                                GST_SEEK_TYPE_SET, position,
+                                GST_SEEK_TYPE_END, 0);
+    }
+    else
+    {
+        seek_event =
+            gst_event_new_seek (handle->rate, format, flags,
+                                GST_SEEK_TYPE_SET, 0,
+                                GST_SEEK_TYPE_SET, position);
+    }
+
+    struct Sink *pri_sink = NULL, *sec_sink = NULL;
+    if (handle->primary_sinks) {
+        pri_sink = (Sink*)handle->primary_sinks->data;
+        if (handle->rate > 2.00) {
+            g_object_set (G_OBJECT (pri_sink->nxvideosink), "sync", false, NULL);
+        } else {
+            g_object_set (G_OBJECT (pri_sink->nxvideosink), "sync", true, NULL);
+        }
+    }
+    if (handle->secondary_sinks) {
+        sec_sink = (Sink*)handle->secondary_sinks->data;
+        if (handle->rate > 2.00) {
+            g_object_set (G_OBJECT (sec_sink->nxvideosink), "sync", false, NULL);
+        } else {
+            g_object_set (G_OBJECT (sec_sink->nxvideosink), "sync", true, NULL);
+        }
+    }
+
+    /* Send the event, to the whole pipeline when no display is linked */
+    if (pri_sink) {
+        ret = gst_element_send_event (pri_sink->nxvideosink, seek_event) ? 0:-1;
+    } else if (sec_sink) {
+        ret = gst_element_send_event (sec_sink->nxvideosink, seek_event) ? 0:-1;
+    } else {
+        ret = gst_element_send_event (handle->pipeline, seek_event) ? 0:-1;
+    }
+
+    kick_ext_subtitle(handle);
+
+    NXGLOGI("Current rate: %g", handle->rate);
+    return ret;
+}
+
+static NX_GST_RET seek_to_time (MP_HANDLE handle, gint64 time_nanoseconds)
+{
+    GstFormat format = GST_FORMAT_TIME;
+
+    if (!gst_element_seek (handle->pipeline, handle->rate, format,
+                          GST_SEEK_FLAG_FLUSH,		/* gdouble rate */
+                          GST_SEEK_TYPE_SET,		/* GstSeekType start_type */
+                          time_nanoseconds,			/* gint64 start */
+                          GST_SEEK_TYPE_NONE,		/* GstSeekType stop_type */
+                          GST_CLOCK_TIME_NONE))		/* gint64 stop */
+    {
+        NXGLOGE("Failed to seek %lld!", time_nanoseconds);
+        return NX_GST_RET_ERROR;
+    }
+    /* And wait for this seek to complete */
+    gst_element_get_state (handle->pipeline, NULL, NULL, GST_CLOCK_TIME_NONE);
+    kick_ext_subtitle(handle);
+
+    return NX_GST_RET_OK;
+}
+
+NX_GST_RET NX_GSTMP_Seek(MP_HANDLE handle, int64_t seekTime)
+{
+    _CAutoLock lock(&handle->apiLock);
+
+    FUNC_IN();
+
+    NX_GST_RET ret = NX_GST_RET_ERROR;
+    
+    if (!handle || !handle->pipeline_is_linked)
+    {
+        NXGLOGE("Invalid state or invalid operation.(%p,%d)\n",
+                handle, handle->pipeline_is_linked);
+        return ret;
+    }
+
+    GstState state, pending;
+    if(GST_STATE_CHANGE_FAILURE != gst_element_get_state(handle->pipeline, &state, &pending, 500000000))	
+    {
+        if(state == GST_STATE_PLAYING || state == GST_STATE_PAUSED)
+        {
+            NXGLOGI("state(%s) with the rate %f", gst_element_state_get_name (state), handle->rate);
+            ret = seek_to_time(handle, seekTime*(1000*1000)); /*mSec to NanoSec*/
+        }
+        else
+        {
+            NXGLOGE("Invalid state to seek");
+            ret = NX_GST_RET_ERROR;
+        }
+    }
+    else
+    {
+        NXGLOGE("Failed to seek");
+        ret = NX_GST_RET_ERROR;
+    }
+
+    FUNC_OUT();
+
+    return ret;
+}
+
+NX_GST_RET NX_GSTMP_Play(MP_HANDLE handle)
+{
+    _CAutoLock lock(&handle->apiLock);
+
+    GstStateChangeReturn ret;
+
+    FUNC_IN();
+
+    if (!handle || !handle->pipeline_is_linked)
+    {
+        NXGLOGE("invalid state or invalid operation.(%p,%d)\n",
+                handle, handle->pipeline_is_linked);
+        return NX_GST_RET_ERROR;
+    }
+
+    GstState state, pending;
+    if (GST_STATE_CHANGE_FAILURE != gst_element_get_state(handle->pipeline, &state, &pending, 500000000))
+    {
+        NXGLOGI("The previous state '%s' with (x%d)", gst_element_state_get_name (state), int(handle->rate));
+        ret = gst_element_set_state(handle->pipeline, GST_STATE_PLAYING);
+        NXGLOGI("set_state(PLAYING) ==> ret(%s)", get_gst_state_change_ret(ret));
+        if (GST_STATE_CHANGE_FAILURE == ret)
+        {
+            NXGLOGE("Failed to set the pipeline to the PLAYING state(ret=%d)", ret);
+            return NX_GST_RET_ERROR;
+        }
+    }
+    else
+    {
+        NXGLOGE("Failed to get state");
+        return NX_GST_RET_ERROR;
+    }
+
+    FUNC_OUT();
+
+    return	NX_GST_RET_OK;
+}
+
+NX_GST_RET NX_GSTMP_Pause(MP_HANDLE handle)
+{
+    _CAutoLock lock(&handle->apiLock);
+
+    NXGLOGI("START");
+
+    if (!handle || !handle->pipeline_is_linked)
+    {
+        NXGLOGE("invalid state or invalid operation.(%p,%d)\n",
+                handle, handle->pipeline_is_linked);
+        return NX_GST_RET_ERROR;
+    }
+
+    GstStateChangeReturn ret;
+    ret = gst_element_set_state (handle->pipeline, GST_STATE_PAUSED);
+    if (GST_STATE_CHANGE_FAILURE == ret)
+    {
+        NXGLOGE("Failed to set the pipeline to the PAUSED state(ret=%d)", ret);
+        return NX_GST_RET_ERROR;
+    }
+
+    NXGLOGI("END");
+
+    return	NX_GST_RET_OK;
+}
+
+NX_GST_RET NX_GSTMP_Stop(MP_HANDLE handle)
+{
+    _CAutoLock lock(&handle->apiLock);
+
+    NXGLOGI("START");
+
+    if (!handle || !handle->pipeline_is_linked)
+    {
+        NXGLOGE("invalid state or invalid operation.(%p,%d)\n",
+                handle, handle->pipeline_is_linked);
+        return NX_GST_RET_ERROR;
+    }
+
+    GstStateChangeReturn ret;
+    handle->rate = 1.0;
+    ret = gst_element_set_state(handle->pipeline, GST_STATE_NULL);
+    NXGLOGI("set_state(NULL) ret(%s)", get_gst_state_change_ret(ret));
+    if(GST_STATE_CHANGE_FAILURE == ret)
+    {
+        NXGLOGE("Failed to set the pipeline to the NULL state(ret=%d)", ret);
+        return NX_GST_RET_ERROR;
+    }
+
+    NXGLOGI("END");
+
+    return	NX_GST_RET_OK;
+}
+
+enum NX_MEDIA_STATE NX_GSTMP_GetState(MP_HANDLE handle)
+{
+    _CAutoLock lock(&handle->apiLock);
+
+    if (!handle) {
+        NXGLOGE("handle is null");
+        return MP_STATE_STOPPED;
+    }
+    if (!handle->pipeline_is_linked) {
+        NXGLOGE("pipeline is unlinked");
+        return MP_STATE_STOPPED;
+    }
+
+    //FUNC_IN();
+
+    GstState state, pending;
+    enum NX_MEDIA_STATE nx_state = MP_STATE_STOPPED;
+    GstStateChangeReturn ret;
+    ret = gst_element_get_state(handle->pipeline, &state, &pending, 500000000);		//	wait 500 msec
+    NXGLOGV("ret(%s) state(%s), pending(%s)",
+    	   get_gst_state_change_ret(ret),
+           gst_element_state_get_name(state),
+           gst_element_state_get_name(pending));
+    if (GST_STATE_CHANGE_SUCCESS == ret || GST_STATE_CHANGE_NO_PREROLL == ret) {
+        nx_state = GstState2NxState(state);
+    }
+    else if (GST_STATE_CHANGE_ASYNC == ret) {
+        nx_state = GstState2NxState(pending);
+    }
+    else
+    {
+        NXGLOGE("Failed to get state");
+        nx_state = MP_STATE_STOPPED;
+    }
+
+    NXGLOGV("nx_state(%s)", get_nx_media_state(nx_state));
+
+    //FUNC_OUT();
+    return nx_state;
+}
+
+NX_GST_RET NX_GSTMP_VideoMute(MP_HANDLE handle, int32_t bOnoff)
+{
+    _CAutoLock lock(&handle->apiLock);
+
+    FUNC_IN();
+
+    if (!handle || !handle->pipeline_is_linked)
+    {
+        NXGLOGE("invalid state or invalid operation.(%p,%d)\n",
+                handle, handle->pipeline_is_linked);
+        return NX_GST_RET_ERROR;
+    }
+
+    int dsp_top = handle->gst_media_info.dsp_rect.top;
+    int dsp_height = handle->gst_media_info.dsp_rect.bottom - handle->gst_media_info.dsp_rect.top;
+
+    NXGLOGI("bOnoff(%s) dst-y(%d)",
+            bOnoff ? "Enable video mute":"Disable video mute",
+            bOnoff ? dsp_height:dsp_top);
+
+    struct Sink *sink = NULL;
+    if (handle->primary_sinks) {
+        sink = (Sink*)handle->primary_sinks->data;
+    } else if (handle->secondary_sinks) {
+        sink = (Sink*)handle->secondary_sinks->data;
+    }
+
+    if (sink)
+    {
+        if (bOnoff) {
+            g_object_set(G_OBJECT(sink->nxvideosink), "dst-y", dsp_height, NULL);
+        } else {
+            g_object_set(G_OBJECT(sink->nxvideosink), "dst-y", dsp_top, NULL);
+        }
+    }
+
+    return	NX_GST_RET_OK;
+
+    FUNC_OUT();
+}
+
+double NX_GSTMP_GetVideoSpeed(MP_HANDLE handle)
+{
+    gdouble speed = 1.0;
+
+    if (!handle || !handle->pipeline_is_linked)
+    {
+        NXGLOGE("Return the default video speed since it's not ready");
+        return speed;
+    }
+
+    NXGLOGI("rate: %d", (int)handle->rate);
+    if ((int)handle->rate == 0) {
+        speed = 1.0;
+    } else {
+        speed = handle->rate;
+    }
+
+    NXGLOGI("current playback speed (%f)", speed);
+    return speed;
+}
+
+NX_GST_RET NX_GSTMP_SelectStream(MP_HANDLE handle, STREAM_TYPE type, int32_t idx)
+{
+    NXGLOGI("START");
+
+    if (!handle) {
+        NXGLOGE("handle is NULL");
+        return NX_GST_RET_ERROR;
+    }
+
+    NXGLOGI("Select %s - idx(%d)",
+            (STREAM_TYPE_PROGRAM == type) ? "Program":
+            (STREAM_TYPE_VIDEO == type) ? "Video":
+            (STREAM_TYPE_AUDIO == type) ? "Audio":"Subtitle",
+            idx);
+
+    int pIdx = handle->select_program_idx;
+
+    switch (type)
+    {
+        case STREAM_TYPE_PROGRAM:
+            if ((handle->gst_media_info.n_program <= idx) || (idx < 0))
+            {
+                handle->select_program_idx = DEFAULT_STREAM_IDX;
+                NXGLOGE("Failed to select program idx - idx is out of bounds. Set default idx(0)");
+            } else {
+                handle->select_program_idx = idx;
+            }
+        break;
+        case STREAM_TYPE_VIDEO:
+            if ((handle->gst_media_info.ProgramInfo[pIdx].n_video <= idx) || (idx < 0))
+            {
+                handle->select_video_idx = DEFAULT_STREAM_IDX;
+                NXGLOGE("Failed to select video idx - idx is out of bounds. Set default idx(0)");
+            } else {
+                handle->select_video_idx = idx;
+            }
+            if (!IS_SUPPORTED_VIDEO_TYPE(handle->gst_media_info.ProgramInfo[pIdx].VideoInfo[handle->select_video_idx].type))
+            {
+                NXGLOGE("Unsupported video codec type");
+                return NX_GST_RET_ERROR;
+            }
+            break;
+        case STREAM_TYPE_AUDIO:
+            if ((handle->gst_media_info.ProgramInfo[pIdx].n_audio <= idx) || (idx < 0)) {
+                handle->select_audio_idx = DEFAULT_STREAM_IDX;
+                NXGLOGE("Failed to select audio idx - idx is out of bounds. Set default idx(0)");
+            } else {
+                handle->select_audio_idx = idx;
+            }
+            break;
+        case STREAM_TYPE_SUBTITLE:
+            if ((handle->gst_media_info.ProgramInfo[pIdx].n_subtitle <= idx) || (idx < 0))
+            {
+                handle->select_subtitle_idx = DEFAULT_STREAM_IDX;
+                NXGLOGE("Failed to select subtitle idx - idx is out of bounds. Set default idx(0)");
+            } else {
+                handle->select_subtitle_idx = idx;
+            }
+
+            if (handle->gst_media_info.ProgramInfo[pIdx].SubtitleInfo[handle->select_subtitle_idx].type != SUBTITLE_TYPE_RAW)
+            {
+                NXGLOGE("Unsupported subtitle codec type");
+                return NX_GST_RET_ERROR;
+            }
+            break;
+        default:
+            NXGLOGE("Unsupported stream type");
+            return NX_GST_RET_ERROR;
+    }
+
+    NXGLOGI("Final select_%s_idx(%d)",
+            (STREAM_TYPE_PROGRAM == type) ? "Program":
+            (STREAM_TYPE_VIDEO == type) ? "Video":
+            (STREAM_TYPE_AUDIO == type) ? "Audio":"Subtitle",
+            (STREAM_TYPE_VIDEO == type) ? handle->select_video_idx: 
+            (STREAM_TYPE_AUDIO == type) ? handle->select_audio_idx:handle->select_subtitle_idx);
+
+    if (handle->pipeline_is_linked &&
+        (handle->state == GST_STATE_PLAYING || handle->state == GST_STATE_PAUSED))
+    {
+       switch_streams(handle);
+    }
+
+    NXGLOGI("END");
+    return NX_GST_RET_OK;
+}
+
+/* It's available in PAUSED or PLAYING state */
+NX_GST_RET NX_GSTMP_SetVideoSpeed(MP_HANDLE handle, double rate)
+{
+    FUNC_IN();
+
+    if (!handle || !handle->pipeline_is_linked)
+    {
+        NXGLOGE("invalid state or invalid operation.(%p,%d)\n",
+                handle, handle->pipeline_is_linked);
+        return NX_GST_RET_ERROR;
+    }
+
+    int index = handle->select_program_idx;
+    if (false == handle->gst_media_info.ProgramInfo[index].seekable)
+    {
+        NXGLOGE("This video doesn't support 'seekable'");
+        return NX_GST_RET_ERROR;
+    }
+
+	if (rate == 0.0) {
+		NXGLOGE("The playback rate 0.0 is not allowed");
+		return NX_GST_RET_ERROR;
+	}
+
+    handle->rate = rate;
+    if (send_seek_event(handle) < 0)
+        return NX_GST_RET_ERROR;
+    else
+        return NX_GST_RET_OK;
+}
+
+static void
+stream_notify_cb (GstStreamCollection * collection, GstStream * stream,
+    GParamSpec * pspec, guint * val)
+{
+    NXGLOGI("Got stream-notify from stream %s for %s (collection %p)",
+            stream->stream_id, pspec->name, collection);
+    if (g_str_equal (pspec->name, "caps")) {
+        GstCaps *caps = gst_stream_get_caps (stream);
+        gchar *caps_str = gst_caps_to_string (caps);
+        NXGLOGI(" New caps: %s\n", caps_str);
+        g_free (caps_str);
+        gst_caps_unref (caps);
+    }
+}
+
+static gboolean
+switch_streams (MP_HANDLE handle)
+{
+    guint i;
+    gint pIdx = 0, vIdx = 0, aIdx = 0, sIdx = 0;
+    gint nb_video = 0, nb_audio = 0, nb_text = 0;
+    GstStream *videos[256], *audios[256], *texts[256];
+    GList *streams = NULL;
+    GstEvent *ev;
+
+    NXGLOGI("Switching Streams...");
+
+    if (NULL == handle)
+    {
+        NXGLOGE("handle is NULL");
+        return FALSE;
+    }
+
+    pIdx = handle->select_program_idx;
+    vIdx = handle->select_video_idx;
+    aIdx = handle->select_audio_idx;
+    sIdx = handle->select_subtitle_idx;
+
+    nb_video = handle->gst_media_info.ProgramInfo[pIdx].n_video;
+    nb_audio = handle->gst_media_info.ProgramInfo[pIdx].n_audio;
+    nb_text = handle->gst_media_info.ProgramInfo[pIdx].n_subtitle;
+
+    pIdx = handle->select_program_idx;
+    vIdx = handle->select_video_idx;
+    aIdx = handle->select_audio_idx;
+    sIdx = handle->select_subtitle_idx;
+
+    nb_video = handle->gst_media_info.ProgramInfo[pIdx].n_video;
+    nb_audio = handle->gst_media_info.ProgramInfo[pIdx].n_audio;
+    nb_text = handle->gst_media_info.ProgramInfo[pIdx].n_subtitle;
+
+    if (nb_video) {
+        gchar *stream_id = handle->gst_media_info.ProgramInfo[pIdx].VideoInfo[vIdx].stream_id;
+        streams = g_list_append (streams, stream_id);
+        NXGLOGI("  Selecting video channel #%d : %s", handle->select_video_idx,
+                (stream_id ? stream_id:""));
+    }
+    if (nb_audio) {
+        gchar *stream_id = handle->gst_media_info.ProgramInfo[pIdx].AudioInfo[aIdx].stream_id;
+        streams = g_list_append (streams, stream_id);
+        NXGLOGI("  Selecting audio channel #%d : %s\n", handle->select_audio_idx,
+                (stream_id ? stream_id:""));
     }
-    else
-    {
-        NXGLOGE("Failed to query DURATION");
-        return -1;
+    if (nb_text) {
+        gchar *stream_id = handle->gst_media_info.ProgramInfo[pIdx].SubtitleInfo[sIdx].stream_id;
+        streams = g_list_append (streams, stream_id);
+        NXGLOGI("  Selecting text channel #%d : %s\n", handle->select_subtitle_idx,
+                (stream_id ? stream_id:""));
     }
 
-    //FUNC_OUT();
+    ev = gst_event_new_select_streams (streams);
+    gst_element_send_event (handle->pipeline, ev);
+    g_list_free (streams);
 
-    return duration;
+    return G_SOURCE_CONTINUE;
 }
 
-NX_GST_RET NX_GSTMP_SetVolume(MP_HANDLE handle, int volume)
+NX_GST_RET NX_GSTMP_SetSubtitleDelivery(MP_HANDLE handle, enum SUBTITLE_DELIVERY mode)
 {
     _CAutoLock lock(&handle->apiLock);
 
     FUNC_IN();
 
-    if (!handle || !handle->alsasink || !handle->volume)
+    if (!handle)
     {
+        NXGLOGE("handle is NULL");
         return NX_GST_RET_ERROR;
     }
 
-    gdouble vol = (double)volume/100.;
-    NXGLOGI("set volume to %f", vol);
-    g_object_set(G_OBJECT (handle->volume), "volume", vol, NULL);
-
-    FUNC_OUT();
-
-    return NX_GST_RET_OK;
-}
-
-#ifdef STEP_SEEK
-static gboolean send_step_event(MP_HANDLE handle)
-{
-    gboolean ret;
-
-    if (handle->nxvideosink == NULL)
+    if (SUBTITLE_DELIVERY_RING == mode)
     {
-        /* If we have not done so, obtain the sink through which we will send the step events */
-        g_object_get(handle->pipeline, "video-sink", &handle->nxvideosink, NULL);
+        // Allocate the text buffers up front so that delivery never allocates
+        for (int i = 0; i < SUBTITLE_RING_SIZE; i++)
+        {
+            struct SubtitleSlot *slot = &handle->subtitle_ring[i];
+            if (NULL == slot->info.subtitleText)
+            {
+                slot->info.subtitleText = (gchar *)g_malloc0(SUBTITLE_TEXT_SIZE);
+                slot->capacity = SUBTITLE_TEXT_SIZE;
+            }
+        }
     }
-
-    ret = gst_element_send_event (handle->nxvideosink,
-                    gst_event_new_step(GST_FORMAT_BUFFERS, 1,
-                                        ABS (handle->rate), TRUE, FALSE));
-
-    NXGLOGI("Stepping one frame");
-
-    return ret;
-}
-#endif
-
-static int send_seek_event(MP_HANDLE handle)
-{
-    int ret = -1;
-    gint64 position;
-    GstEvent *seek_event;
-    GstFormat format = GST_FORMAT_TIME;
-    //GstSeekFlags flags = (GstSeekFlags)(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_SNAP_AFTER | GST_SEEK_FLAG_KEY_UNIT);
-    GstSeekFlags flags = (GstSeekFlags)(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE);
-
-    /* Obtain the current position, needed for the seek event */
-    if (!gst_element_query_position (handle->pipeline, format, &position))
+    else if (SUBTITLE_DELIVERY_ALLOC != mode)
     {
-        NXGLOGE("Unable to retrieve current position");
-        return ret;
+        NXGLOGE("Invalid subtitle delivery mode(%d)", mode);
+        return NX_GST_RET_ERROR;
     }
 
-    /* Create the seek event */
-    if (handle->rate > 0)
-    {
-        seek_event =
-            gst_event_new_seek (handle->rate, format, flags,
-                                GST_SEEK_TYPE_SET, position,
-                                GST_SEEK_TYPE_END, 0);
-    }
-    else
-    {
-        seek_event =
-            gst_event_new_seek (handle->rate, format, flags,
-                                GST_SEEK_TYPE_SET, 0,
-                                GST_SEEK_TYPE_SET, position);
-    }
+    NXGLOGI("subtitle delivery mode(%s)",
+            (SUBTITLE_DELIVERY_RING == mode) ? "ring":"alloc");
+    handle->subtitle_delivery = mode;
 
-    struct Sink *pri_sink = NULL, *sec_sink = NULL;
-    if (primary_sinks) {
-        pri_sink = (Sink*)primary_sinks->data;
-        if (handle->rate > 2.00) {
-            g_object_set (G_OBJECT (pri_sink->nxvideosink), "sync", false, NULL);
-        } else {
-            g_object_set (G_OBJECT (pri_sink->nxvideosink), "sync", true, NULL);
-        }
-        /* Send the event */
-        ret = gst_element_send_event (pri_sink->nxvideosink, seek_event) ? 0:-1;
-    }
-    if (secondary_sinks) {
-        sec_sink = (Sink*)secondary_sinks->data;
-        if (handle->rate > 2.00) {
-            g_object_set (G_OBJECT (sec_sink->nxvideosink), "sync", false, NULL);
-        } else {
-            g_object_set (G_OBJECT (sec_sink->nxvideosink), "sync", true, NULL);
-        }
-    }
+    FUNC_OUT();
 
-    NXGLOGI("Current rate: %g", handle->rate);
-    return ret;
+    return NX_GST_RET_OK;
 }
 
-static NX_GST_RET seek_to_time (MP_HANDLE handle, gint64 time_nanoseconds)
+NX_GST_RET NX_GSTMP_ReleaseSubtitle(MP_HANDLE handle, struct SUBTITLE_INFO *pInfo)
 {
-    GstFormat format = GST_FORMAT_TIME;
-
-    if (!gst_element_seek (handle->pipeline, handle->rate, format,
-                          GST_SEEK_FLAG_FLUSH,		/* gdouble rate */
-                          GST_SEEK_TYPE_SET,		/* GstSeekType start_type */
-                          time_nanoseconds,			/* gint64 start */
-                          GST_SEEK_TYPE_NONE,		/* GstSeekType stop_type */
-                          GST_CLOCK_TIME_NONE))		/* gint64 stop */
+    if (!handle || !pInfo)
     {
-        NXGLOGE("Failed to seek %lld!", time_nanoseconds);
+        NXGLOGE("handle/pInfo is NULL");
         return NX_GST_RET_ERROR;
     }
-    /* And wait for this seek to complete */
-    gst_element_get_state (handle->pipeline, NULL, NULL, GST_CLOCK_TIME_NONE);
+
+    release_subtitle_info(handle, pInfo);
 
     return NX_GST_RET_OK;
 }
 
-NX_GST_RET NX_GSTMP_Seek(MP_HANDLE handle, int64_t seekTime)
+NX_GST_RET NX_GSTMP_SetExternalSubtitle(MP_HANDLE handle, const char *subtitlePath)
 {
     _CAutoLock lock(&handle->apiLock);
 
     FUNC_IN();
 
-    NX_GST_RET ret = NX_GST_RET_ERROR;
-    
-    if (!handle || !handle->pipeline_is_linked)
-    {
-        NXGLOGE("Invalid state or invalid operation.(%p,%d)\n",
-                handle, handle->pipeline_is_linked);
-        return ret;
-    }
-
-    GstState state, pending;
-    if(GST_STATE_CHANGE_FAILURE != gst_element_get_state(handle->pipeline, &state, &pending, 500000000))	
-    {
-        if(state == GST_STATE_PLAYING || state == GST_STATE_PAUSED)
-        {
-            NXGLOGI("state(%s) with the rate %f", gst_element_state_get_name (state), handle->rate);
-            ret = seek_to_time(handle, seekTime*(1000*1000)); /*mSec to NanoSec*/
-        }
-        else
-        {
-            NXGLOGE("Invalid state to seek");
-            ret = NX_GST_RET_ERROR;
-        }
-    }
-    else
+    if (!handle)
     {
-        NXGLOGE("Failed to seek");
-        ret = NX_GST_RET_ERROR;
+        NXGLOGE("handle is NULL");
+        return NX_GST_RET_ERROR;
     }
+    NX_GST_RET ret = set_ext_subtitle(handle, subtitlePath);
 
     FUNC_OUT();
 
     return ret;
 }
 
-NX_GST_RET NX_GSTMP_Play(MP_HANDLE handle)
+NX_GST_RET NX_GSTMP_SetSwDecoderConfig(MP_HANDLE handle, const struct SW_VDEC_CONFIG *config)
 {
     _CAutoLock lock(&handle->apiLock);
 
-    GstStateChangeReturn ret;
-
     FUNC_IN();
 
-    if (!handle || !handle->pipeline_is_linked)
+    if (!handle || !config)
     {
-        NXGLOGE("invalid state or invalid operation.(%p,%d)\n",
-                handle, handle->pipeline_is_linked);
+        NXGLOGE("Invalid argument");
         return NX_GST_RET_ERROR;
     }
-
-    GstState state, pending;
-    if (GST_STATE_CHANGE_FAILURE != gst_element_get_state(handle->pipeline, &state, &pending, 500000000))
-    {
-        NXGLOGI("The previous state '%s' with (x%d)", gst_element_state_get_name (state), int(handle->rate));
-        ret = gst_element_set_state(handle->pipeline, GST_STATE_PLAYING);
-        NXGLOGI("set_state(PLAYING) ==> ret(%s)", get_gst_state_change_ret(ret));
-        if (GST_STATE_CHANGE_FAILURE == ret)
-        {
-            NXGLOGE("Failed to set the pipeline to the PLAYING state(ret=%d)", ret);
-            return NX_GST_RET_ERROR;
-        }
-    }
-    else
+    if (handle->pipeline_is_linked)
     {
-        NXGLOGE("Failed to get state");
+        NXGLOGE("The software decoder must be configured before NX_GSTMP_Prepare()");
         return NX_GST_RET_ERROR;
     }
 
+    handle->sw_vdec_config = *config;
+#ifndef SW_V_DECODER
+    NXGLOGI("Built without SW_V_DECODER, the software decoder is never used");
+#endif
+
     FUNC_OUT();
 
-    return	NX_GST_RET_OK;
+    return NX_GST_RET_OK;
 }
 
-NX_GST_RET NX_GSTMP_Pause(MP_HANDLE handle)
+NX_GST_RET NX_GSTMP_SetSecondaryStandby(MP_HANDLE handle, int32_t enable)
 {
     _CAutoLock lock(&handle->apiLock);
 
-    NXGLOGI("START");
+    FUNC_IN();
 
-    if (!handle || !handle->pipeline_is_linked)
+    if (!handle)
     {
-        NXGLOGE("invalid state or invalid operation.(%p,%d)\n",
-                handle, handle->pipeline_is_linked);
+        NXGLOGE("handle is NULL");
         return NX_GST_RET_ERROR;
     }
-
-    GstStateChangeReturn ret;
-    ret = gst_element_set_state (handle->pipeline, GST_STATE_PAUSED);
-    if (GST_STATE_CHANGE_FAILURE == ret)
+    if (handle->pipeline_is_linked)
     {
-        NXGLOGE("Failed to set the pipeline to the PAUSED state(ret=%d)", ret);
+        NXGLOGE("The secondary standby must be set before NX_GSTMP_Prepare()");
         return NX_GST_RET_ERROR;
     }
 
-    NXGLOGI("END");
+    handle->secondary_standby = enable ? TRUE : FALSE;
 
-    return	NX_GST_RET_OK;
+    FUNC_OUT();
+
+    return NX_GST_RET_OK;
 }
 
-NX_GST_RET NX_GSTMP_Stop(MP_HANDLE handle)
+NX_GST_RET NX_GSTMP_GetSecondaryActivationTime(MP_HANDLE handle, int64_t *pUsec)
 {
-    _CAutoLock lock(&handle->apiLock);
+    if (!handle || !pUsec)
+    {
+        NXGLOGE("handle/pUsec is NULL");
+        return NX_GST_RET_ERROR;
+    }
 
-    NXGLOGI("START");
+    pthread_mutex_lock(&handle->stateLock);
+    *pUsec = handle->secondary_activation_us;
+    pthread_mutex_unlock(&handle->stateLock);
 
-    if (!handle || !handle->pipeline_is_linked)
+    return NX_GST_RET_OK;
+}
+
+NX_GST_RET NX_GSTMP_GetEventStats(MP_HANDLE handle, struct MP_EVENT_STATS *pStats)
+{
+    if (!handle || !pStats)
     {
-        NXGLOGE("invalid state or invalid operation.(%p,%d)\n",
-                handle, handle->pipeline_is_linked);
+        NXGLOGE("handle/pStats is NULL");
         return NX_GST_RET_ERROR;
     }
 
-    GstStateChangeReturn ret;
-    handle->rate = 1.0;
-    ret = gst_element_set_state(handle->pipeline, GST_STATE_NULL);
-    NXGLOGI("set_state(NULL) ret(%s)", get_gst_state_change_ret(ret));
-    if(GST_STATE_CHANGE_FAILURE == ret)
+    pthread_mutex_lock(&handle->stateLock);
+    *pStats = handle->event_stats;
+    if (handle->event_stats.dispatched > 0) {
+        pStats->avg_latency_us = handle->total_latency_us / handle->event_stats.dispatched;
+    }
+    pthread_mutex_unlock(&handle->stateLock);
+
+    pStats->queue_depth = NX_GetEventQueueDepth(handle->event_queue);
+    pStats->overflowed = NX_GetEventQueueOverflowed(handle->event_queue);
+    pStats->dropped = 0;
+    for (int i = 0; i < MP_EVENT_TYPE_NUM; i++) {
+        pStats->dropped_by_type[i] = g_atomic_int_get(&handle->dropped_events[i]);
+        pStats->dropped += pStats->dropped_by_type[i];
+    }
+
+    return NX_GST_RET_OK;
+}
+
+NX_GST_RET NX_GSTMP_SetLoopThreads(int32_t threads)
+{
+    if (threads < 1 || threads > LOOP_POOL_MAX_THREADS)
     {
-        NXGLOGE("Failed to set the pipeline to the NULL state(ret=%d)", ret);
+        NXGLOGE("threads(%d) must be 1 ~ %d", threads, LOOP_POOL_MAX_THREADS);
         return NX_GST_RET_ERROR;
     }
 
-    NXGLOGI("END");
+    NX_SetLoopPoolSize((guint)threads);
 
-    return	NX_GST_RET_OK;
+    return NX_GST_RET_OK;
 }
 
-enum NX_MEDIA_STATE NX_GSTMP_GetState(MP_HANDLE handle)
+struct CaptureJob
 {
-    _CAutoLock lock(&handle->apiLock);
-
-    if (!handle) {
-        NXGLOGE("handle is null");
-        return MP_STATE_STOPPED;
-    }
-    if (!handle->pipeline_is_linked) {
-        NXGLOGE("pipeline is unlinked");
-        return MP_STATE_STOPPED;
-    }
+    GstSample   *sample;
+    gint        width;
+    gchar       *outPath;
+};
 
-    //FUNC_IN();
+// Runs on a thread of capture_pool
+static void capture_frame_job(gpointer data, gpointer user_data)
+{
+    struct CaptureJob *job = (struct CaptureJob *)data;
+    MP_HANDLE handle = (MP_HANDLE)user_data;
+    struct CAPTURE_FRAME *frame;
+    NX_GST_RET ret = NX_GST_RET_ERROR;
+    gint64 start_time = g_get_monotonic_time();
 
-    GstState state, pending;
-    enum NX_MEDIA_STATE nx_state = MP_STATE_STOPPED;
-    GstStateChangeReturn ret;
-    ret = gst_element_get_state(handle->pipeline, &state, &pending, 500000000);		//	wait 500 msec
-    NXGLOGV("ret(%s) state(%s), pending(%s)",
-    	   get_gst_state_change_ret(ret),
-           gst_element_state_get_name(state),
-           gst_element_state_get_name(pending));
-    if (GST_STATE_CHANGE_SUCCESS == ret || GST_STATE_CHANGE_NO_PREROLL == ret) {
-        nx_state = GstState2NxState(state);
-    }
-    else if (GST_STATE_CHANGE_ASYNC == ret) {
-        nx_state = GstState2NxState(pending);
+    frame = NX_ConvertSample(job->sample, job->width);
+    if (frame && job->outPath)
+    {
+        if (NX_SaveCapturedFrame(frame, job->outPath)) {
+            ret = NX_GST_RET_OK;
+        }
+        NX_FreeCapturedFrame(frame);
+        frame = NULL;
     }
-    else
+    else if (frame)
     {
-        NXGLOGE("Failed to get state");
-        nx_state = MP_STATE_STOPPED;
+        ret = NX_GST_RET_OK;
     }
 
-    NXGLOGV("nx_state(%s)", get_nx_media_state(nx_state));
+    NXGLOGI("Captured in %" G_GINT64_FORMAT " us, ret(%d)",
+            g_get_monotonic_time() - start_time, ret);
 
-    //FUNC_OUT();
-    return nx_state;
+    post_event(handle, MP_EVENT_FRAME_CAPTURED, ret, frame);
+
+    gst_sample_unref(job->sample);
+    g_free(job->outPath);
+    g_free(job);
 }
 
-NX_GST_RET NX_GSTMP_VideoMute(MP_HANDLE handle, int32_t bOnoff)
+NX_GST_RET NX_GSTMP_CaptureFrame(MP_HANDLE handle, enum DISPLAY_TYPE type,
+                                int32_t width, const char *outPath)
 {
     _CAutoLock lock(&handle->apiLock);
 
@@ -2172,263 +4068,243 @@ NX_GST_RET NX_GSTMP_VideoMute(MP_HANDLE handle, int32_t bOnoff)
 
     if (!handle || !handle->pipeline_is_linked)
     {
-        NXGLOGE("invalid state or invalid operation.(%p,%d)\n",
-                handle, handle->pipeline_is_linked);
+        NXGLOGE("invalid state or invalid operation.(%p)", handle);
         return NX_GST_RET_ERROR;
     }
 
-    int dsp_top = handle->gst_media_info.dsp_rect.top;
-    int dsp_height = handle->gst_media_info.dsp_rect.bottom - handle->gst_media_info.dsp_rect.top;
-
-    NXGLOGI("bOnoff(%s) dst-y(%d)",
-            bOnoff ? "Enable video mute":"Disable video mute",
-            bOnoff ? dsp_height:dsp_top);
-
-    // TODO:
-    struct Sink *sink;
-    if (primary_sinks) {
-        sink = (Sink*)primary_sinks->data;
-    } else if (secondary_sinks) {
-        sink = (Sink*)secondary_sinks->data;
+    GList *sinks = (DISPLAY_TYPE_PRIMARY == type) ? handle->primary_sinks:handle->secondary_sinks;
+    if (NULL == sinks)
+    {
+        NXGLOGE("No video on the display(%d)", type);
+        return NX_GST_RET_ERROR;
     }
 
-    if (sink)
+    // The frame on screen, only referenced here
+    GstSample *sample = NULL;
+    g_object_get(((struct Sink *)sinks->data)->nxvideosink, "last-sample", &sample, NULL);
+    if (NULL == sample)
     {
-        if (bOnoff) {
-            g_object_set(G_OBJECT(sink->nxvideosink), "dst-y", dsp_height, NULL);
-        } else {
-            g_object_set(G_OBJECT(sink->nxvideosink), "dst-y", dsp_top, NULL);
-        }
+        NXGLOGE("No frame is rendered yet");
+        return NX_GST_RET_ERROR;
     }
 
-    return	NX_GST_RET_OK;
+    if (NULL == handle->capture_pool) {
+        handle->capture_pool = g_thread_pool_new(capture_frame_job, handle, 1, FALSE, NULL);
+    }
+
+    struct CaptureJob *job = g_new0(struct CaptureJob, 1);
+    job->sample = sample;
+    job->width = width;
+    job->outPath = g_strdup(outPath);
+    g_thread_pool_push(handle->capture_pool, job, NULL);
 
     FUNC_OUT();
+
+    return NX_GST_RET_OK;
 }
 
-double NX_GSTMP_GetVideoSpeed(MP_HANDLE handle)
+void NX_GSTMP_ReleaseCapturedFrame(struct CAPTURE_FRAME *pFrame)
 {
-    gdouble speed = 1.0;
+    NX_FreeCapturedFrame(pFrame);
+}
 
-    if (!handle || !handle->pipeline_is_linked)
+NX_GST_RET NX_GSTMP_MakeThumbnail(const gchar *uri, int64_t pos_msec, int32_t width, const char *outPath)
+{
+    return makeThumbnail(uri, pos_msec, width, outPath, 0, NULL);
+}
+
+NX_GST_RET NX_GSTMP_MakeThumbnailEx(const char *uri, int64_t pos_msec, int32_t width,
+                        const char *outPath, int32_t flags, struct THUMBNAIL_RESULT *pResult)
+{
+    return makeThumbnail(uri, pos_msec, width, outPath, flags, pResult);
+}
+
+NX_GST_RET NX_GSTMP_MakeThumbnailToBuffer(const char *uri, int64_t pos_msec, int32_t width,
+                        int32_t flags, struct THUMBNAIL_BUFFER *pBuffer,
+                        struct THUMBNAIL_RESULT *pResult)
+{
+    if (!uri || !pBuffer || width <= 0 || (pBuffer->data && pBuffer->size <= 0))
     {
-        NXGLOGE("Return the default video speed since it's not ready");
-        return speed;
+        NXGLOGE("invalid parameter.(%s, %d, %p)", uri, width, pBuffer);
+        return NX_GST_RET_ERROR;
     }
 
-    NXGLOGI("rate: %d", (int)handle->rate);
-    if ((int)handle->rate == 0) {
-        speed = 1.0;
-    } else {
-        speed = handle->rate;
-    }
+    return makeThumbnailToBuffer(uri, pos_msec, width, flags, pBuffer, pResult);
+}
 
-    NXGLOGI("current playback speed (%f)", speed);
-    return speed;
+void NX_GSTMP_ReleaseThumbnailBuffer(struct THUMBNAIL_BUFFER *pBuffer)
+{
+    if (!pBuffer)
+        return;
+
+    g_free(pBuffer->data);
+    pBuffer->data = NULL;
+    pBuffer->size = 0;
 }
 
-NX_GST_RET NX_GSTMP_SelectStream(MP_HANDLE handle, STREAM_TYPE type, int32_t idx)
+void NX_GSTMP_SetThumbnailCache(const char *cacheDir, int64_t maxDiskBytes,
+                        int64_t maxMemoryBytes)
 {
-    NXGLOGI("START");
+    NX_ConfigureThumbnailCache(cacheDir, maxDiskBytes, maxMemoryBytes);
+}
 
-    if (!handle) {
-        NXGLOGE("handle is NULL");
+NX_GST_RET NX_GSTMP_OpenThumbnailService(TH_HANDLE *pHandle)
+{
+    return NX_GSTMP_OpenThumbnailServiceEx(pHandle, 1, 1);
+}
+
+NX_GST_RET NX_GSTMP_OpenThumbnailServiceEx(TH_HANDLE *pHandle, int32_t workers,
+                        int32_t hwDecoders)
+{
+    if (!pHandle || workers <= 0 || hwDecoders < 0)
+    {
+        NXGLOGE("invalid parameter.(%p, %d, %d)", pHandle, workers, hwDecoders);
         return NX_GST_RET_ERROR;
     }
 
-    NXGLOGI("Select %s - idx(%d)",
-            (STREAM_TYPE_PROGRAM == type) ? "Program":
-            (STREAM_TYPE_VIDEO == type) ? "Video":
-            (STREAM_TYPE_AUDIO == type) ? "Audio":"Subtitle",
-            idx);
+    *pHandle = NX_CreateThumbnailService(workers, hwDecoders);
 
-    int pIdx = handle->select_program_idx;
+    return NX_GST_RET_OK;
+}
 
-    switch (type)
+int32_t NX_GSTMP_RequestThumbnail(TH_HANDLE handle, const char *uri, int64_t pos_msec,
+                        int32_t width, const char *outPath,
+                        NX_THUMBNAIL_CB cb, void *owner)
+{
+    if (!handle || !uri || !outPath || width <= 0)
     {
-        case STREAM_TYPE_PROGRAM:
-            if ((handle->gst_media_info.n_program <= idx) || (idx < 0))
-            {
-                handle->select_program_idx = DEFAULT_STREAM_IDX;
-                NXGLOGE("Failed to select program idx - idx is out of bounds. Set default idx(0)");
-            } else {
-                handle->select_program_idx = idx;
-            }
-        break;
-        case STREAM_TYPE_VIDEO:
-            if ((handle->gst_media_info.ProgramInfo[pIdx].n_video <= idx) || (idx < 0))
-            {
-                handle->select_video_idx = DEFAULT_STREAM_IDX;
-                NXGLOGE("Failed to select video idx - idx is out of bounds. Set default idx(0)");
-            } else {
-                handle->select_video_idx = idx;
-            }
-#ifdef SW_V_DECODER
-            if (handle->gst_media_info.ProgramInfo[pIdx].VideoInfo[handle->select_video_idx].type > VIDEO_TYPE_FLV)
-#else
-            if (handle->gst_media_info.ProgramInfo[pIdx].VideoInfo[handle->select_video_idx].type >= VIDEO_TYPE_FLV)
-#endif
-            {
-                NXGLOGE("Unsupported video codec type");
-                return NX_GST_RET_ERROR;
-            }
-            break;
-        case STREAM_TYPE_AUDIO:
-            if ((handle->gst_media_info.ProgramInfo[pIdx].n_audio <= idx) || (idx < 0)) {
-                handle->select_audio_idx = DEFAULT_STREAM_IDX;
-                NXGLOGE("Failed to select audio idx - idx is out of bounds. Set default idx(0)");
-            } else {
-                handle->select_audio_idx = idx;
-            }
-            break;
-        case STREAM_TYPE_SUBTITLE:
-            if ((handle->gst_media_info.ProgramInfo[pIdx].n_subtitle <= idx) || (idx < 0))
-            {
-                handle->select_subtitle_idx = DEFAULT_STREAM_IDX;
-                NXGLOGE("Failed to select subtitle idx - idx is out of bounds. Set default idx(0)");
-            } else {
-                handle->select_subtitle_idx = idx;
-            }
-
-            if (handle->gst_media_info.ProgramInfo[pIdx].SubtitleInfo[handle->select_subtitle_idx].type != SUBTITLE_TYPE_RAW)
-            {
-                NXGLOGE("Unsupported subtitle codec type");
-                return NX_GST_RET_ERROR;
-            }
-            break;
-        default:
-            NXGLOGE("Unsupported stream type");
-            return NX_GST_RET_ERROR;
+        NXGLOGE("invalid parameter.(%p, %s, %s, %d)", handle, uri, outPath, width);
+        return -1;
     }
 
-    NXGLOGI("Final select_%s_idx(%d)",
-            (STREAM_TYPE_PROGRAM == type) ? "Program":
-            (STREAM_TYPE_VIDEO == type) ? "Video":
-            (STREAM_TYPE_AUDIO == type) ? "Audio":"Subtitle",
-            (STREAM_TYPE_VIDEO == type) ? handle->select_video_idx: 
-            (STREAM_TYPE_AUDIO == type) ? handle->select_audio_idx:handle->select_subtitle_idx);
+    return NX_RequestThumbnail(handle, uri, pos_msec, width, outPath, cb, owner);
+}
 
-    if (handle->pipeline_is_linked &&
-        (handle->state == GST_STATE_PLAYING || handle->state == GST_STATE_PAUSED))
+int32_t NX_GSTMP_RequestThumbnailEx(TH_HANDLE handle, const char *uri, int64_t pos_msec,
+                        int32_t width, const char *outPath, int32_t priority,
+                        int32_t timeoutMsec, NX_THUMBNAIL_CB cb, void *owner)
+{
+    if (!handle || !uri || !outPath || width <= 0 || timeoutMsec < 0)
     {
-       switch_streams(handle);
+        NXGLOGE("invalid parameter.(%p, %s, %s, %d, %d)", handle, uri, outPath,
+                width, timeoutMsec);
+        return -1;
     }
 
-    NXGLOGI("END");
-    return NX_GST_RET_OK;
+    return NX_RequestThumbnailEx(handle, uri, pos_msec, width, outPath, priority,
+                                timeoutMsec, cb, owner);
 }
 
-/* It's available in PAUSED or PLAYING state */
-NX_GST_RET NX_GSTMP_SetVideoSpeed(MP_HANDLE handle, double rate)
+int32_t NX_GSTMP_RequestThumbnailStrip(TH_HANDLE handle, const char *uri,
+                        const int64_t *pos_msec, int32_t count, int32_t width,
+                        const char *spritePath, NX_THUMBNAIL_CB cb, void *owner)
 {
-    FUNC_IN();
+    if (!handle || !uri || !pos_msec || count <= 0 || width <= 0)
+    {
+        NXGLOGE("invalid parameter.(%p, %s, %p, %d, %d)", handle, uri, pos_msec, count, width);
+        return -1;
+    }
 
-    if (!handle || !handle->pipeline_is_linked)
+    return NX_RequestThumbnailStrip(handle, uri, (const gint64 *)pos_msec, count,
+                                    width, spritePath, cb, owner);
+}
+
+int32_t NX_GSTMP_RequestPreviewTrack(TH_HANDLE handle, const char *uri,
+                        int32_t intervalMsec, int32_t width, const char *trackPath,
+                        NX_THUMBNAIL_CB cb, void *owner)
+{
+    if (!handle || !uri || !trackPath || intervalMsec <= 0 || width <= 0)
     {
-        NXGLOGE("invalid state or invalid operation.(%p,%d)\n",
-                handle, handle->pipeline_is_linked);
-        return NX_GST_RET_ERROR;
+        NXGLOGE("invalid parameter.(%p, %s, %s, %d, %d)", handle, uri, trackPath,
+                intervalMsec, width);
+        return -1;
     }
 
-    int index = handle->select_program_idx;
-    if (false == handle->gst_media_info.ProgramInfo[index].seekable)
+    return NX_RequestPreviewTrack(handle, uri, intervalMsec, width, trackPath, cb, owner);
+}
+
+NX_GST_RET NX_GSTMP_OpenPreviewTrack(const char *trackPath, PV_HANDLE *pHandle)
+{
+    if (!trackPath || !pHandle)
     {
-        NXGLOGE("This video doesn't support 'seekable'");
+        NXGLOGE("invalid parameter.(%s, %p)", trackPath, pHandle);
         return NX_GST_RET_ERROR;
     }
 
-	if (rate == 0.0) {
-		NXGLOGE("The playback rate 0.0 is not allowed");
-		return NX_GST_RET_ERROR;
-	}
+    *pHandle = NX_OpenPreviewTrack(trackPath);
 
-    handle->rate = rate;
-    if (send_seek_event(handle) < 0)
-        return NX_GST_RET_ERROR;
-    else
-        return NX_GST_RET_OK;
+    return (*pHandle) ? NX_GST_RET_OK : NX_GST_RET_ERROR;
 }
 
-static void
-stream_notify_cb (GstStreamCollection * collection, GstStream * stream,
-    GParamSpec * pspec, guint * val)
+NX_GST_RET NX_GSTMP_GetPreviewImage(PV_HANDLE handle, int64_t pos_msec,
+                        struct PREVIEW_IMAGE *pImage)
 {
-    NXGLOGI("Got stream-notify from stream %s for %s (collection %p)",
-            stream->stream_id, pspec->name, collection);
-    if (g_str_equal (pspec->name, "caps")) {
-        GstCaps *caps = gst_stream_get_caps (stream);
-        gchar *caps_str = gst_caps_to_string (caps);
-        NXGLOGI(" New caps: %s\n", caps_str);
-        g_free (caps_str);
-        gst_caps_unref (caps);
+    if (!handle || !pImage)
+    {
+        NXGLOGE("invalid parameter.(%p, %p)", handle, pImage);
+        return NX_GST_RET_ERROR;
     }
+
+    return NX_GetPreviewImage(handle, pos_msec, pImage) ? NX_GST_RET_OK : NX_GST_RET_ERROR;
 }
 
-static gboolean
-switch_streams (MP_HANDLE handle)
+void NX_GSTMP_ClosePreviewTrack(PV_HANDLE handle)
 {
-    guint i;
-    gint pIdx = 0, vIdx = 0, aIdx = 0, sIdx = 0;
-    gint nb_video = 0, nb_audio = 0, nb_text = 0;
-    GstStream *videos[256], *audios[256], *texts[256];
-    GList *streams = NULL;
-    GstEvent *ev;
-
-    NXGLOGI("Switching Streams...");
+    NX_ClosePreviewTrack(handle);
+}
 
-    if (NULL == handle)
+NX_GST_RET NX_GSTMP_SetThumbnailFlags(TH_HANDLE handle, int32_t flags)
+{
+    if (!handle)
     {
         NXGLOGE("handle is NULL");
-        return FALSE;
+        return NX_GST_RET_ERROR;
     }
 
-    pIdx = handle->select_program_idx;
-    vIdx = handle->select_video_idx;
-    aIdx = handle->select_audio_idx;
-    sIdx = handle->select_subtitle_idx;
+    NX_SetThumbnailFlags(handle, flags);
 
-    nb_video = handle->gst_media_info.ProgramInfo[pIdx].n_video;
-    nb_audio = handle->gst_media_info.ProgramInfo[pIdx].n_audio;
-    nb_text = handle->gst_media_info.ProgramInfo[pIdx].n_subtitle;
+    return NX_GST_RET_OK;
+}
 
-    pIdx = handle->select_program_idx;
-    vIdx = handle->select_video_idx;
-    aIdx = handle->select_audio_idx;
-    sIdx = handle->select_subtitle_idx;
+NX_GST_RET NX_GSTMP_SetThumbnailPriority(TH_HANDLE handle, int32_t jobId, int32_t priority)
+{
+    if (!handle)
+    {
+        NXGLOGE("handle is NULL");
+        return NX_GST_RET_ERROR;
+    }
 
-    nb_video = handle->gst_media_info.ProgramInfo[pIdx].n_video;
-    nb_audio = handle->gst_media_info.ProgramInfo[pIdx].n_audio;
-    nb_text = handle->gst_media_info.ProgramInfo[pIdx].n_subtitle;
+    return NX_SetThumbnailPriority(handle, jobId, priority) ?
+            NX_GST_RET_OK : NX_GST_RET_ERROR;
+}
 
-    if (nb_video) {
-        gchar *stream_id = handle->gst_media_info.ProgramInfo[pIdx].VideoInfo[vIdx].stream_id;
-        streams = g_list_append (streams, stream_id);
-        NXGLOGI("  Selecting video channel #%d : %s", handle->select_video_idx,
-                (stream_id ? stream_id:""));
-    }
-    if (nb_audio) {
-        gchar *stream_id = handle->gst_media_info.ProgramInfo[pIdx].AudioInfo[aIdx].stream_id;
-        streams = g_list_append (streams, stream_id);
-        NXGLOGI("  Selecting audio channel #%d : %s\n", handle->select_audio_idx,
-                (stream_id ? stream_id:""));
-    }
-    if (nb_text) {
-        gchar *stream_id = handle->gst_media_info.ProgramInfo[pIdx].SubtitleInfo[sIdx].stream_id;
-        streams = g_list_append (streams, stream_id);
-        NXGLOGI("  Selecting text channel #%d : %s\n", handle->select_subtitle_idx,
-                (stream_id ? stream_id:""));
+NX_GST_RET NX_GSTMP_CancelThumbnail(TH_HANDLE handle, int32_t jobId)
+{
+    if (!handle)
+    {
+        NXGLOGE("handle is NULL");
+        return NX_GST_RET_ERROR;
     }
 
-    ev = gst_event_new_select_streams (streams);
-    gst_element_send_event (handle->pipeline, ev);
-    g_list_free (streams);
+    return NX_CancelThumbnail(handle, jobId) ? NX_GST_RET_OK : NX_GST_RET_ERROR;
+}
 
-    return G_SOURCE_CONTINUE;
+void NX_GSTMP_CloseThumbnailService(TH_HANDLE handle)
+{
+    NX_DestroyThumbnailService(handle);
 }
 
-NX_GST_RET NX_GSTMP_MakeThumbnail(const gchar *uri, int64_t pos_msec, int32_t width, const char *outPath)
+NX_GST_RET NX_GSTMP_SetLogLevel(const char *tag, int32_t level)
 {
-    return makeThumbnail(uri, pos_msec, width, outPath);
+    if (level < NX_GST_LOG_NONE || level > NX_GST_LOG_VERBOSE)
+    {
+        NXGLOGE("invalid parameter.(%s, %d)", tag, level);
+        return NX_GST_RET_ERROR;
+    }
+
+    nx_gst_log_set_level(tag, level);
+
+    return NX_GST_RET_OK;
 }
 
 enum NX_MEDIA_STATE GstState2NxState(GstState state)
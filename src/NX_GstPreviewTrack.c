@@ -0,0 +1,314 @@
+//------------------------------------------------------------------------------
+//
+//	Copyright (C) 2015 Nexell Co. All Rights Reserved
+//	Nexell Co. Proprietary & Confidential
+//
+//	NEXELL INFORMS THAT THIS CODE AND INFORMATION IS PROVIDED "AS IS" BASE
+//  AND	WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING
+//  BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS
+//  FOR A PARTICULAR PURPOSE.
+//
+//	Module		: libnxgstvplayer.so
+//	File		: NX_GstPreviewTrack.c
+//	Description	: Scrubbing preview track file, written by the thumbnail service
+//	Author		:
+//	Export		:
+//	History		:
+//
+//------------------------------------------------------------------------------
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "NX_GstPreviewTrack.h"
+#include "NX_GstLog.h"
+#define LOG_TAG "[NX_GstPreviewTrack]"
+
+#define PREVIEW_MAGIC   "NXPVTRK1"
+
+struct PreviewHeader {
+    gchar       magic[8];
+    guint32     interval_msec;
+    guint32     count;
+    // Of all the images, the size of the first one
+    guint32     width;
+    guint32     height;
+    // THUMBNAIL_FORMAT_JPEG
+    guint32     format;
+    guint32     reserved;
+};
+
+struct PreviewEntry {
+    // From the start of the file
+    guint64     offset;
+    guint32     size;
+    gint32      pos_msec;
+};
+
+struct PreviewTrackWriter {
+    gchar       *path;
+    gchar       *tmp_path;
+    FILE        *fp;
+    struct PreviewHeader header;
+    struct PreviewEntry *entries;
+    // Where the next image goes
+    guint64     offset;
+    gint32      images;
+};
+
+struct PREVIEW_TRACK {
+    GMappedFile *file;
+    const guint8 *data;
+    gsize       size;
+    const struct PreviewHeader *header;
+    const struct PreviewEntry *entries;
+};
+
+struct PreviewTrackWriter *NX_CreatePreviewTrack(const gchar *path, gint32 interval_msec,
+                                                gint32 count)
+{
+    struct PreviewTrackWriter *writer;
+    gsize table_size = count * sizeof(struct PreviewEntry);
+
+    if (interval_msec <= 0 || count <= 0)
+        return NULL;
+
+    writer = g_new0(struct PreviewTrackWriter, 1);
+    writer->path = g_strdup(path);
+    writer->tmp_path = g_strdup_printf("%s.tmp", path);
+    writer->fp = g_fopen(writer->tmp_path, "wb");
+    if (NULL == writer->fp)
+    {
+        NXGLOGE("Failed to create %s", writer->tmp_path);
+        g_free(writer->tmp_path);
+        g_free(writer->path);
+        g_free(writer);
+        return NULL;
+    }
+
+    memcpy(writer->header.magic, PREVIEW_MAGIC, sizeof(writer->header.magic));
+    writer->header.interval_msec = interval_msec;
+    writer->header.count = count;
+    writer->header.format = THUMBNAIL_FORMAT_JPEG;
+    writer->entries = g_new0(struct PreviewEntry, count);
+    writer->offset = sizeof(struct PreviewHeader) + table_size;
+
+    // Room for the header and the table, written by NX_FinishPreviewTrack()
+    if (1 != fwrite(&writer->header, sizeof(writer->header), 1, writer->fp) ||
+        1 != fwrite(writer->entries, table_size, 1, writer->fp))
+    {
+        NXGLOGE("Failed to write %s", writer->tmp_path);
+        NX_FinishPreviewTrack(writer, FALSE);
+        return NULL;
+    }
+
+    return writer;
+}
+
+gboolean NX_AddPreviewImage(struct PreviewTrackWriter *writer, gint32 index, gint64 pos_msec,
+                            const gchar *data, gsize size, gint32 width, gint32 height)
+{
+    if (index < 0 || index >= (gint32)writer->header.count || 0 == size || size > G_MAXUINT32)
+        return FALSE;
+
+    if (1 != fwrite(data, size, 1, writer->fp))
+    {
+        NXGLOGE("Failed to write %s", writer->tmp_path);
+        return FALSE;
+    }
+
+    if (0 == writer->images)
+    {
+        writer->header.width = width;
+        writer->header.height = height;
+    }
+    writer->entries[index].offset = writer->offset;
+    writer->entries[index].size = (guint32)size;
+    writer->entries[index].pos_msec = (gint32)CLAMP(pos_msec, 0, G_MAXINT32);
+    writer->offset += size;
+    writer->images++;
+
+    return TRUE;
+}
+
+// Each interval without an image takes the one before it, or the first one
+static void fill_entries(struct PreviewEntry *entries, gint32 count)
+{
+    gint32 first = -1;
+
+    for (gint32 i = 0; i < count; i++)
+    {
+        if (entries[i].size > 0)
+        {
+            if (first < 0)
+                first = i;
+        }
+        else if (first >= 0)
+        {
+            entries[i] = entries[i - 1];
+        }
+    }
+    for (gint32 i = 0; i < first; i++) {
+        entries[i] = entries[first];
+    }
+}
+
+gboolean NX_FinishPreviewTrack(struct PreviewTrackWriter *writer, gboolean ok)
+{
+    gboolean res = FALSE;
+
+    if (ok && writer->images > 0)
+    {
+        fill_entries(writer->entries, writer->header.count);
+
+        // Synced before the rename, a crash leaves no partial track behind
+        res = (0 == fseek(writer->fp, 0, SEEK_SET) &&
+                1 == fwrite(&writer->header, sizeof(writer->header), 1, writer->fp) &&
+                1 == fwrite(writer->entries, writer->header.count * sizeof(struct PreviewEntry),
+                            1, writer->fp) &&
+                0 == fflush(writer->fp) &&
+                0 == fsync(fileno(writer->fp)));
+    }
+    if (0 != fclose(writer->fp)) {
+        res = FALSE;
+    }
+
+    if (res && 0 != g_rename(writer->tmp_path, writer->path))
+    {
+        NXGLOGE("Failed to rename %s", writer->tmp_path);
+        res = FALSE;
+    }
+    if (!res) {
+        g_unlink(writer->tmp_path);
+    }
+
+    NXGLOGI("%s: %d/%u images, %" G_GUINT64_FORMAT " bytes, res(%d)", writer->path,
+            writer->images, writer->header.count, writer->offset, res);
+
+    g_free(writer->entries);
+    g_free(writer->tmp_path);
+    g_free(writer->path);
+    g_free(writer);
+
+    return res;
+}
+
+static gboolean valid_header(const struct PreviewHeader *header)
+{
+    return (0 == memcmp(header->magic, PREVIEW_MAGIC, sizeof(header->magic)) &&
+            header->interval_msec > 0 && header->count > 0);
+}
+
+PV_HANDLE NX_OpenPreviewTrack(const gchar *path)
+{
+    struct PREVIEW_TRACK *track;
+    GMappedFile *file;
+    GError *error = NULL;
+    const struct PreviewHeader *header;
+    gsize size;
+
+    file = g_mapped_file_new(path, FALSE, &error);
+    if (NULL == file)
+    {
+        NXGLOGE("Failed to map %s: %s", path, error->message);
+        g_clear_error(&error);
+        return NULL;
+    }
+
+    size = g_mapped_file_get_length(file);
+    header = (const struct PreviewHeader *)g_mapped_file_get_contents(file);
+    if (size < sizeof(struct PreviewHeader) || !valid_header(header) ||
+        (size - sizeof(struct PreviewHeader)) / sizeof(struct PreviewEntry) < header->count)
+    {
+        NXGLOGE("%s is not a preview track", path);
+        g_mapped_file_unref(file);
+        return NULL;
+    }
+
+    track = g_new0(struct PREVIEW_TRACK, 1);
+    track->file = file;
+    track->data = (const guint8 *)header;
+    track->size = size;
+    track->header = header;
+    track->entries = (const struct PreviewEntry *)(header + 1);
+
+    // Checked once here, the lookups trust the table
+    for (guint32 i = 0; i < header->count; i++)
+    {
+        const struct PreviewEntry *entry = &track->entries[i];
+
+        if (0 == entry->size || entry->offset > size || entry->size > size - entry->offset)
+        {
+            NXGLOGE("%s: bad entry %u", path, i);
+            NX_ClosePreviewTrack(track);
+            return NULL;
+        }
+    }
+
+    NXGLOGI("%s: %u images every %u msec, %ux%u", path, header->count,
+            header->interval_msec, header->width, header->height);
+
+    return track;
+}
+
+gboolean NX_IsPreviewTrackCurrent(const gchar *path, const gchar *source, gint32 interval_msec)
+{
+    struct PreviewHeader header;
+    GStatBuf track_st, source_st;
+    gboolean res = FALSE;
+    FILE *fp;
+
+    if (0 != g_stat(path, &track_st) || 0 != g_stat(source, &source_st) ||
+        track_st.st_mtime < source_st.st_mtime)
+    {
+        return FALSE;
+    }
+
+    fp = g_fopen(path, "rb");
+    if (fp)
+    {
+        res = (1 == fread(&header, sizeof(header), 1, fp) && valid_header(&header) &&
+                header.interval_msec == (guint32)interval_msec);
+        fclose(fp);
+    }
+
+    return res;
+}
+
+gboolean NX_GetPreviewImage(PV_HANDLE track, gint64 pos_msec, struct PREVIEW_IMAGE *image)
+{
+    const struct PreviewHeader *header = track->header;
+    const struct PreviewEntry *entry;
+    gint64 index;
+
+    // The nearest interval, the last one stands for the rest of the file
+    index = (MAX(pos_msec, 0) + header->interval_msec / 2) / header->interval_msec;
+    entry = &track->entries[MIN(index, (gint64)header->count - 1)];
+
+    image->format = (enum THUMBNAIL_FORMAT)header->format;
+    image->data = track->data + entry->offset;
+    image->size = entry->size;
+    image->pos_msec = entry->pos_msec;
+    image->width = header->width;
+    image->height = header->height;
+
+    return TRUE;
+}
+
+void NX_ClosePreviewTrack(PV_HANDLE track)
+{
+    if (NULL == track)
+        return;
+
+    g_mapped_file_unref(track->file);
+    g_free(track);
+}
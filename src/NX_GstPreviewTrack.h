@@ -0,0 +1,69 @@
+//------------------------------------------------------------------------------
+//
+//	Copyright (C) 2015 Nexell Co. All Rights Reserved
+//	Nexell Co. Proprietary & Confidential
+//
+//	NEXELL INFORMS THAT THIS CODE AND INFORMATION IS PROVIDED "AS IS" BASE
+//  AND	WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING
+//  BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS
+//  FOR A PARTICULAR PURPOSE.
+//
+//	Module		: libnxgstvplayer.so
+//	File		: NX_GstPreviewTrack.h
+//	Description	: Scrubbing preview track file, written by the thumbnail service
+//	Author		:
+//	Export		:
+//	History		:
+//
+//------------------------------------------------------------------------------
+
+#ifndef __NX_GSTPREVIEWTRACK_H
+#define __NX_GSTPREVIEWTRACK_H
+
+#include <glib.h>
+#include "NX_GstTypes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif	//	__cplusplus
+
+/*
+ * A preview track holds one JPEG image every 'interval_msec' of a file,
+ * for the seek bar. The file is a header, a table of one entry per
+ * interval and the images, in native byte order since it is made and read
+ * on the same device. An interval without an image of its own (the keyframe
+ * of the previous one, or a decoding failure) points to the image before
+ * it, so that a lookup is a division and a table read.
+ */
+struct PreviewTrackWriter;
+
+/* Starts '<path>.tmp' for 'count' intervals, renamed to 'path' by
+ * NX_FinishPreviewTrack() */
+struct PreviewTrackWriter *NX_CreatePreviewTrack(const gchar *path, gint32 interval_msec,
+                                                gint32 count);
+
+// Appends the image of interval 'index', taken at 'pos_msec'
+gboolean NX_AddPreviewImage(struct PreviewTrackWriter *writer, gint32 index, gint64 pos_msec,
+                            const gchar *data, gsize size, gint32 width, gint32 height);
+
+/* Writes the table and renames the file if 'ok' and it has an image, removes
+ * it otherwise. Frees 'writer' in any case. */
+gboolean NX_FinishPreviewTrack(struct PreviewTrackWriter *writer, gboolean ok);
+
+// Maps the file, NULL if it is not a valid preview track
+PV_HANDLE NX_OpenPreviewTrack(const gchar *path);
+
+// TRUE if 'path' is a preview track of 'interval_msec' newer than 'source'
+gboolean NX_IsPreviewTrackCurrent(const gchar *path, const gchar *source, gint32 interval_msec);
+
+/* The image of the interval of 'pos_msec', in O(1). Its data stays valid
+ * until NX_ClosePreviewTrack(). */
+gboolean NX_GetPreviewImage(PV_HANDLE track, gint64 pos_msec, struct PREVIEW_IMAGE *image);
+
+void NX_ClosePreviewTrack(PV_HANDLE track);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __NX_GSTPREVIEWTRACK_H
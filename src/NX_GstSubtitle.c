@@ -0,0 +1,576 @@
+//------------------------------------------------------------------------------
+//
+//	Copyright (C) 2015 Nexell Co. All Rights Reserved
+//	Nexell Co. Proprietary & Confidential
+//
+//	NEXELL INFORMS THAT THIS CODE AND INFORMATION IS PROVIDED "AS IS" BASE
+//  AND	WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING
+//  BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS
+//  FOR A PARTICULAR PURPOSE.
+//
+//	Module		: libnxgstvplayer.so
+//	File		: NX_GstSubtitle.c
+//	Description	: External subtitle files (SRT/SSA/ASS/VTT)
+//	Author		:
+//	Export		:
+//	History		:
+//
+//------------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "NX_GstSubtitle.h"
+#include "NX_GstLog.h"
+#define LOG_TAG "[GstSubtitle]"
+
+#define SUBTITLE_MSECOND        G_GINT64_CONSTANT(1000000)
+#define SSA_MAX_FIELDS          16
+
+enum SUBTITLE_FORMAT {
+    SUBTITLE_FORMAT_SRT,
+    SUBTITLE_FORMAT_SSA,
+    SUBTITLE_FORMAT_VTT,
+};
+
+// Growing arrays used while parsing, turned into the final track afterwards
+typedef struct SubtitleBuilder {
+    NX_SUBTITLE_CUE *cues;
+    guint           n_cues;
+    guint           cue_capacity;
+    gchar           *text;
+    gsize           text_size;
+    gsize           text_capacity;
+} SubtitleBuilder;
+
+static void text_reserve(SubtitleBuilder *b, gsize len)
+{
+    if (b->text_size + len > b->text_capacity)
+    {
+        gsize capacity = MAX(b->text_capacity * 2, 4096);
+        while (capacity < b->text_size + len)
+            capacity *= 2;
+        b->text = g_realloc(b->text, capacity);
+        b->text_capacity = capacity;
+    }
+}
+
+static void text_append(SubtitleBuilder *b, const gchar *str, gsize len)
+{
+    text_reserve(b, len);
+    memcpy(b->text + b->text_size, str, len);
+    b->text_size += len;
+}
+
+static void cue_begin(SubtitleBuilder *b, gint64 start, gint64 end)
+{
+    NX_SUBTITLE_CUE *cue;
+
+    if (b->n_cues == b->cue_capacity)
+    {
+        b->cue_capacity = MAX(b->cue_capacity * 2, 256);
+        b->cues = g_renew(NX_SUBTITLE_CUE, b->cues, b->cue_capacity);
+    }
+    cue = &b->cues[b->n_cues];
+    cue->start = start;
+    cue->end = end;
+    cue->text_offset = (guint32)b->text_size;
+    cue->text_length = 0;
+}
+
+// Strips trailing newlines, terminates the text and keeps the cue if it is
+// not empty
+static void cue_end(SubtitleBuilder *b)
+{
+    NX_SUBTITLE_CUE *cue = &b->cues[b->n_cues];
+
+    while (b->text_size > cue->text_offset && b->text[b->text_size - 1] == '\n')
+        b->text_size--;
+    cue->text_length = (guint32)(b->text_size - cue->text_offset);
+    if (cue->text_length == 0 || cue->end <= cue->start)
+    {
+        b->text_size = cue->text_offset;
+        return;
+    }
+    text_append(b, "", 1);
+    b->n_cues++;
+}
+
+// Appends a line of SRT/VTT text, dropping <i>, <font ..>, <c.x> like tags
+static void cue_append_line(SubtitleBuilder *b, const gchar *line, gsize len)
+{
+    NX_SUBTITLE_CUE *cue = &b->cues[b->n_cues];
+    gsize i;
+
+    if (b->text_size > cue->text_offset)
+        text_append(b, "\n", 1);
+
+    text_reserve(b, len);
+    for (i = 0; i < len; i++)
+    {
+        if (line[i] == '<')
+        {
+            const gchar *close = memchr(line + i, '>', len - i);
+            if (close)
+            {
+                i = close - line;
+                continue;
+            }
+        }
+        else if (line[i] == '&')
+        {
+            // VTT escapes
+            static const struct { const char *name; gsize len; char c; } entities[] = {
+                { "&amp;", 5, '&' }, { "&lt;", 4, '<' }, { "&gt;", 4, '>' }, { "&nbsp;", 6, ' ' },
+            };
+            guint e;
+            for (e = 0; e < G_N_ELEMENTS(entities); e++)
+            {
+                if (len - i >= entities[e].len &&
+                    strncmp(line + i, entities[e].name, entities[e].len) == 0)
+                    break;
+            }
+            if (e < G_N_ELEMENTS(entities))
+            {
+                b->text[b->text_size++] = entities[e].c;
+                i += entities[e].len - 1;
+                continue;
+            }
+        }
+        b->text[b->text_size++] = line[i];
+    }
+}
+
+// Appends the text field of an SSA/ASS event: {...} override blocks are
+// dropped, \N and \n are line breaks and \h is a hard space
+static void cue_append_ssa(SubtitleBuilder *b, const gchar *str, gsize len)
+{
+    gsize i;
+
+    text_reserve(b, len);
+    for (i = 0; i < len; i++)
+    {
+        if (str[i] == '{')
+        {
+            const gchar *close = memchr(str + i, '}', len - i);
+            if (close)
+            {
+                i = close - str;
+                continue;
+            }
+        }
+        if (str[i] == '\\' && i + 1 < len)
+        {
+            if (str[i + 1] == 'N' || str[i + 1] == 'n')
+            {
+                b->text[b->text_size++] = '\n';
+                i++;
+                continue;
+            }
+            if (str[i + 1] == 'h')
+            {
+                b->text[b->text_size++] = ' ';
+                i++;
+                continue;
+            }
+        }
+        b->text[b->text_size++] = str[i];
+    }
+}
+
+/* Parses [[hh:]mm:]ss[.,]fff. SRT uses a comma, VTT a dot and SSA a dot
+ * with centiseconds. */
+static gboolean parse_timestamp(const gchar **pp, const gchar *end, gint64 *out)
+{
+    const gchar *p = *pp;
+    gint64 fields[3];
+    gint64 frac = 0;
+    gint n = 0, digits = 0;
+
+    while (p < end && (*p == ' ' || *p == '\t'))
+        p++;
+
+    for (;;)
+    {
+        gint64 v = 0;
+        if (p >= end || !g_ascii_isdigit(*p))
+            return FALSE;
+        while (p < end && g_ascii_isdigit(*p))
+            v = v * 10 + (*p++ - '0');
+        fields[n++] = v;
+        if (p < end && *p == ':' && n < 3)
+        {
+            p++;
+            continue;
+        }
+        break;
+    }
+
+    if (p < end && (*p == ',' || *p == '.'))
+    {
+        p++;
+        while (p < end && g_ascii_isdigit(*p))
+        {
+            if (digits < 3)
+            {
+                frac = frac * 10 + (*p - '0');
+                digits++;
+            }
+            p++;
+        }
+    }
+    // A lone number is the SRT cue index, not a time
+    if (n < 2 && digits == 0)
+        return FALSE;
+    for (; digits < 3; digits++)
+        frac *= 10;
+
+    gint64 hours = (n == 3) ? fields[0] : 0;
+    gint64 minutes = (n >= 2) ? fields[n - 2] : 0;
+    gint64 seconds = fields[n - 1];
+
+    *out = ((hours * 3600 + minutes * 60 + seconds) * 1000 + frac) * SUBTITLE_MSECOND;
+    *pp = p;
+    return TRUE;
+}
+
+// "start --> end [settings]"
+static gboolean parse_cue_timing(const gchar *line, const gchar *end,
+                                 gint64 *start, gint64 *stop)
+{
+    const gchar *p = line;
+
+    if (!parse_timestamp(&p, end, start))
+        return FALSE;
+    while (p < end && (*p == ' ' || *p == '\t'))
+        p++;
+    if (end - p < 3 || strncmp(p, "-->", 3) != 0)
+        return FALSE;
+    p += 3;
+    return parse_timestamp(&p, end, stop);
+}
+
+static gboolean next_line(const gchar **pos, const gchar *end,
+                          const gchar **line, gsize *len)
+{
+    const gchar *p = *pos;
+    const gchar *eol;
+
+    if (p >= end)
+        return FALSE;
+
+    eol = memchr(p, '\n', end - p);
+    if (!eol)
+        eol = end;
+    *line = p;
+    *len = eol - p;
+    if (*len > 0 && p[*len - 1] == '\r')
+        (*len)--;
+    *pos = (eol < end) ? eol + 1 : end;
+    return TRUE;
+}
+
+// SRT and VTT share the same block structure: a timing line followed by
+// text lines up to an empty line. Indexes, WEBVTT header, NOTE and STYLE
+// blocks have no timing line and are skipped.
+static void parse_srt_vtt(SubtitleBuilder *b, const gchar *data, gsize size)
+{
+    const gchar *pos = data, *end = data + size;
+    const gchar *line;
+    gsize len;
+    gboolean in_cue = FALSE;
+    gint64 start, stop;
+
+    while (next_line(&pos, end, &line, &len))
+    {
+        if (in_cue)
+        {
+            if (len == 0)
+            {
+                cue_end(b);
+                in_cue = FALSE;
+            }
+            else
+            {
+                cue_append_line(b, line, len);
+            }
+        }
+        else if (len > 0 && parse_cue_timing(line, line + len, &start, &stop))
+        {
+            cue_begin(b, start, stop);
+            in_cue = TRUE;
+        }
+    }
+    if (in_cue)
+        cue_end(b);
+}
+
+static gint split_fields(const gchar *str, gsize len, gint max_fields,
+                          const gchar **fields, gsize *lengths)
+{
+    gint n = 0;
+    gsize i, begin = 0;
+
+    for (i = 0; i <= len && n < max_fields; i++)
+    {
+        // The last field takes the rest of the line, commas included
+        if (i == len || (str[i] == ',' && n < max_fields - 1))
+        {
+            gsize b = begin, e = i;
+            while (b < e && str[b] == ' ')
+                b++;
+            if (n < max_fields - 1)
+                while (e > b && str[e - 1] == ' ')
+                    e--;
+            fields[n] = str + b;
+            lengths[n] = e - b;
+            n++;
+            begin = i + 1;
+        }
+    }
+    return n;
+}
+
+static void parse_ssa(SubtitleBuilder *b, const gchar *data, gsize size)
+{
+    const gchar *pos = data, *end = data + size;
+    const gchar *line;
+    gsize len;
+    gboolean in_events = FALSE;
+    // Default "Layer, Start, End, Style, Name, MarginL, MarginR, MarginV, Effect, Text"
+    gint n_fields = 10, start_idx = 1, end_idx = 2;
+    const gchar *fields[SSA_MAX_FIELDS];
+    gsize lengths[SSA_MAX_FIELDS];
+
+    while (next_line(&pos, end, &line, &len))
+    {
+        if (len > 0 && line[0] == '[')
+        {
+            in_events = (len >= 8 && g_ascii_strncasecmp(line, "[Events]", 8) == 0);
+            continue;
+        }
+        if (!in_events)
+            continue;
+
+        if (len > 7 && g_ascii_strncasecmp(line, "Format:", 7) == 0)
+        {
+            gint i, n = split_fields(line + 7, len - 7, SSA_MAX_FIELDS, fields, lengths);
+            n_fields = n;
+            for (i = 0; i < n; i++)
+            {
+                if (lengths[i] == 5 && g_ascii_strncasecmp(fields[i], "Start", 5) == 0)
+                    start_idx = i;
+                else if (lengths[i] == 3 && g_ascii_strncasecmp(fields[i], "End", 3) == 0)
+                    end_idx = i;
+            }
+        }
+        else if (len > 9 && g_ascii_strncasecmp(line, "Dialogue:", 9) == 0)
+        {
+            gint64 start, stop;
+            const gchar *p;
+            gint n = split_fields(line + 9, len - 9, n_fields, fields, lengths);
+
+            if (n != n_fields)
+                continue;
+            p = fields[start_idx];
+            if (!parse_timestamp(&p, fields[start_idx] + lengths[start_idx], &start))
+                continue;
+            p = fields[end_idx];
+            if (!parse_timestamp(&p, fields[end_idx] + lengths[end_idx], &stop))
+                continue;
+
+            cue_begin(b, start, stop);
+            cue_append_ssa(b, fields[n - 1], lengths[n - 1]);
+            cue_end(b);
+        }
+    }
+}
+
+static int compare_cue(const void *a, const void *b)
+{
+    const NX_SUBTITLE_CUE *ca = a;
+    const NX_SUBTITLE_CUE *cb = b;
+
+    if (ca->start != cb->start)
+        return (ca->start < cb->start) ? -1 : 1;
+    // Keep the file order of cues starting together
+    return (ca->text_offset < cb->text_offset) ? -1 : 1;
+}
+
+static enum SUBTITLE_FORMAT detect_format(const gchar *data, gsize size)
+{
+    if (size >= 6 && strncmp(data, "WEBVTT", 6) == 0)
+        return SUBTITLE_FORMAT_VTT;
+    if (g_strstr_len(data, MIN(size, 4096), "[Script Info]") ||
+        g_strstr_len(data, size, "[Events]"))
+        return SUBTITLE_FORMAT_SSA;
+    return SUBTITLE_FORMAT_SRT;
+}
+
+NX_SUBTITLE_TRACK *NX_LoadSubtitleFile(const char *path)
+{
+    NX_SUBTITLE_TRACK *track;
+    SubtitleBuilder b = { 0, };
+    gchar *contents = NULL, *converted = NULL;
+    const gchar *data;
+    gsize size = 0;
+    GError *err = NULL;
+    guint i;
+
+    if (!g_file_get_contents(path, &contents, &size, &err))
+    {
+        NXGLOGE("Failed to read %s: %s", path, err ? err->message : "");
+        g_clear_error(&err);
+        return NULL;
+    }
+
+    data = contents;
+    if (!g_utf8_validate(data, size, NULL))
+    {
+        // Most of the non-UTF-8 files around are Korean (CP949) or Latin-1
+        gsize written = 0;
+        converted = g_convert(data, size, "UTF-8", "CP949", NULL, &written, NULL);
+        if (!converted)
+            converted = g_convert(data, size, "UTF-8", "ISO-8859-1", NULL, &written, NULL);
+        if (converted)
+        {
+            data = converted;
+            size = written;
+        }
+    }
+    // UTF-8 BOM
+    if (size >= 3 && (guchar)data[0] == 0xEF && (guchar)data[1] == 0xBB &&
+        (guchar)data[2] == 0xBF)
+    {
+        data += 3;
+        size -= 3;
+    }
+
+    if (detect_format(data, size) == SUBTITLE_FORMAT_SSA)
+        parse_ssa(&b, data, size);
+    else
+        parse_srt_vtt(&b, data, size);
+
+    g_free(converted);
+    g_free(contents);
+
+    if (b.n_cues == 0)
+    {
+        NXGLOGE("No subtitle found in %s", path);
+        g_free(b.cues);
+        g_free(b.text);
+        return NULL;
+    }
+
+    qsort(b.cues, b.n_cues, sizeof(NX_SUBTITLE_CUE), compare_cue);
+
+    track = g_new0(NX_SUBTITLE_TRACK, 1);
+    track->cues = g_renew(NX_SUBTITLE_CUE, b.cues, b.n_cues);
+    track->n_cues = b.n_cues;
+    track->text = g_realloc(b.text, b.text_size);
+    track->text_size = b.text_size;
+    track->max_end = g_new(gint64, b.n_cues);
+    for (i = 0; i < b.n_cues; i++)
+    {
+        gint64 prev = (i > 0) ? track->max_end[i - 1] : 0;
+        track->max_end[i] = MAX(prev, track->cues[i].end);
+    }
+
+    NXGLOGI("Loaded %u cues from %s", track->n_cues, path);
+    return track;
+}
+
+void NX_FreeSubtitleTrack(NX_SUBTITLE_TRACK *track)
+{
+    if (track)
+    {
+        g_free(track->cues);
+        g_free(track->max_end);
+        g_free(track->text);
+        g_free(track);
+    }
+}
+
+gint NX_FindSubtitleCue(const NX_SUBTITLE_TRACK *track, gint64 pos,
+                        gint64 *next_change)
+{
+    guint lo, hi, mid, first, started, i;
+    gint found = -1;
+    gint64 next = -1;
+
+    // 'started' = number of cues which started at or before pos
+    lo = 0;
+    hi = track->n_cues;
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (track->cues[mid].start <= pos)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    started = lo;
+
+    // 'first' = first cue which may still be visible at pos
+    lo = 0;
+    hi = started;
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (track->max_end[mid] <= pos)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    first = lo;
+
+    // Among overlapping cues the one started last is shown
+    for (i = started; i > first; i--)
+    {
+        if (track->cues[i - 1].end > pos)
+        {
+            found = (gint)(i - 1);
+            next = track->cues[i - 1].end;
+            break;
+        }
+    }
+
+    if (started < track->n_cues &&
+        (next < 0 || track->cues[started].start < next))
+        next = track->cues[started].start;
+
+    if (next_change)
+        *next_change = next;
+    return found;
+}
+
+gchar *NX_FindSidecarSubtitle(const char *mediaPath)
+{
+    static const char *exts[] = {
+        ".srt", ".SRT", ".ass", ".ASS", ".ssa", ".SSA", ".vtt", ".VTT", NULL
+    };
+    const char *slash, *dot;
+    gsize base_len;
+    gint i;
+
+    if (!mediaPath)
+        return NULL;
+
+    slash = strrchr(mediaPath, '/');
+    dot = strrchr(mediaPath, '.');
+    base_len = (dot && (!slash || dot > slash)) ? (gsize)(dot - mediaPath) : strlen(mediaPath);
+
+    for (i = 0; exts[i]; i++)
+    {
+        gchar *path = g_strdup_printf("%.*s%s", (int)base_len, mediaPath, exts[i]);
+        if (g_file_test(path, G_FILE_TEST_IS_REGULAR))
+            return path;
+        g_free(path);
+    }
+    return NULL;
+}
@@ -0,0 +1,67 @@
+//------------------------------------------------------------------------------
+//
+//	Copyright (C) 2015 Nexell Co. All Rights Reserved
+//	Nexell Co. Proprietary & Confidential
+//
+//	NEXELL INFORMS THAT THIS CODE AND INFORMATION IS PROVIDED "AS IS" BASE
+//  AND	WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING
+//  BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS
+//  FOR A PARTICULAR PURPOSE.
+//
+//	Module		: libnxgstvplayer.so
+//	File		: NX_GstSubtitle.h
+//	Description	: External subtitle files (SRT/SSA/ASS/VTT)
+//	Author		:
+//	Export		:
+//	History		:
+//
+//------------------------------------------------------------------------------
+
+#ifndef __NX_GSTSUBTITLE_H
+#define __NX_GSTSUBTITLE_H
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif	//	__cplusplus
+
+typedef struct NX_SUBTITLE_CUE {
+    // Nanoseconds
+    gint64      start;
+    gint64      end;
+    // Position of the text in NX_SUBTITLE_TRACK.text
+    guint32     text_offset;
+    guint32     text_length;
+} NX_SUBTITLE_CUE;
+
+/* All the cues of a file, sorted by start time.
+ * max_end[i] is the latest end time among cues[0..i], it never decreases,
+ * so the first cue which can still be visible at a position is found with
+ * a binary search as well. */
+typedef struct NX_SUBTITLE_TRACK {
+    NX_SUBTITLE_CUE *cues;
+    gint64          *max_end;
+    guint           n_cues;
+    // NUL separated texts of all the cues
+    gchar           *text;
+    gsize           text_size;
+} NX_SUBTITLE_TRACK;
+
+// Returns the path of '<media basename>.{srt,ass,ssa,vtt}' if it exists
+gchar *NX_FindSidecarSubtitle(const char *mediaPath);
+
+NX_SUBTITLE_TRACK *NX_LoadSubtitleFile(const char *path);
+void NX_FreeSubtitleTrack(NX_SUBTITLE_TRACK *track);
+
+/* Returns the index of the cue visible at 'pos', or -1.
+ * 'next_change' receives the next time the result can change, or -1 after
+ * the last cue. */
+gint NX_FindSubtitleCue(const NX_SUBTITLE_TRACK *track, gint64 pos,
+                        gint64 *next_change);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __NX_GSTSUBTITLE_H
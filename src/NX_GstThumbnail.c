@@ -19,161 +19,1569 @@
 
 // Refer to pipeline-manipulation
 
+#include <string.h>
 #include <gst/gst.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include "NX_GstThumbnail.h"
+#include "NX_GstCapture.h"
+#include "NX_GstThumbnailCache.h"
+#include "NX_GstPreviewTrack.h"
 #include "NX_GstLog.h"
 #define LOG_TAG "[NX_GstThumbnail]"
 
-NX_GST_RET
-makeThumbnail(const char *uri, int64_t pos_msec, int32_t width, const char *outPath)
+// Longest wait for the pipeline to preroll, then for the frame after the seek
+#define THUMBNAIL_TIMEOUT       (5 * GST_SECOND)
+// Tiles per row of a sprite sheet
+#define SPRITE_COLUMNS          10
+// THUMBNAIL_FLAG_SKIP_FLAT: a luma variance below is a flat frame (std dev 8),
+// skipped for the next keyframe at most FLAT_MAX_RETRIES times or until
+// FLAT_TIME_BUDGET is spent. Otherwise the least flat frame tried is kept.
+#define FLAT_VARIANCE           64
+#define FLAT_MAX_RETRIES        8
+#define FLAT_TIME_BUDGET        (2 * G_USEC_PER_SEC)
+// THUMBNAIL_FLAG_BEST_FRAME: keyframes scored at most, within BEST_WINDOW
+// msec around the position. BEST_TIME_BUDGET bounds the frames after the
+// first one, the last pull is cut short to fit in.
+#define BEST_FRAME_COUNT        5
+#define BEST_WINDOW             (10 * 1000)
+#define BEST_TIME_BUDGET        (G_USEC_PER_SEC)
+// THUMBNAIL_FLAG_EMBEDDED_IMAGE: longest tag pass
+#define EMBEDDED_TIMEOUT        (G_USEC_PER_SEC)
+// Decode workers of a thumbnail service at most
+#define THUMBNAIL_MAX_WORKERS   8
+// Preview tracks: intervals at most, the last one stands for the rest of a
+// longer file, and the priority of their jobs, behind the thumbnails
+#define PREVIEW_MAX_IMAGES      65536
+#define PREVIEW_PRIORITY        (-1)
+
+/* uridecodebin ! appsink
+ * Built once per worker and reused, only the uri changes between two jobs.
+ * uridecodebin still plugs the demuxer and the decoder of each file.
+ * The appsink takes the decoded picture as is, NX_ConvertSample() scales
+ * and converts it to the thumbnail at once. */
+struct ThumbnailPipeline {
+    GstElement  *pipeline;
+    GstElement  *decodebin;
+    GstElement  *sink;
+    GstBus      *bus;
+    // Of the current file, read by the decoder probes
+    gint32      flags;
+    gint32      width;
+    // Tag pass of find_embedded_image(), the first buffer ends it
+    gboolean    tag_pass;
+    volatile gint tag_pass_end;
+    // Of the current job: its deadline in monotonic time, G_MAXINT64 for
+    // none, set when it is cancelled, and whether it may take a hardware
+    // decoder
+    gint64      deadline;
+    volatile gint cancelled;
+    gboolean    allow_hw;
+};
+
+struct ThumbnailJob {
+    gint32          id;
+    gchar           *uri;
+    gint64          pos_msec;
+    gint32          width;
+    gchar           *outPath;
+    gint32          flags;
+    NX_THUMBNAIL_CB callback;
+    void            *owner;
+    // Strip jobs only: positions in ascending order, and their index in
+    // the request. outPath is the sprite sheet, NULL for none.
+    gint64          *positions;
+    gint32          *indexes;
+    gint32          count;
+    // Preview track jobs only, outPath is the track
+    gint32          interval_msec;
+    // makeThumbnailToBuffer() only, written instead of outPath
+    struct THUMBNAIL_BUFFER *buffer;
+    // Service jobs: higher first, and the longest run in msec, 0 for none
+    gint32          priority;
+    gint32          timeout_msec;
+};
+
+struct ThumbnailWorker {
+    struct THUMBNAIL_SERVICE    *service;
+    GThread                     *thread;
+    struct ThumbnailPipeline    *tp;
+    // In progress, under the lock of the service
+    struct ThumbnailJob         *job;
+};
+
+/* The queued jobs are sorted by priority, then in request order. Each
+ * worker takes the first one and runs it on its own pipeline. */
+struct THUMBNAIL_SERVICE {
+    GMutex          lock;
+    GCond           cond;
+    GQueue          jobs;
+    gboolean        quit;
+    struct ThumbnailWorker *workers;
+    gint32          n_workers;
+    // The hardware decoder has few instances, the workers beyond this
+    // number decode in software
+    gint32          hw_decoders;
+    gint32          hw_in_use;
+    volatile gint   next_id;
+    // THUMBNAIL_FLAG of the jobs requested from now on
+    volatile gint   flags;
+};
+
+static void on_pad_added(GstElement *element, GstPad *pad, gpointer data)
+{
+    struct ThumbnailPipeline *tp = (struct ThumbnailPipeline *)data;
+    GstPad *sinkpad = gst_element_get_static_pad(tp->sink, "sink");
+    GstCaps *caps = gst_pad_query_caps(pad, NULL);
+    const gchar *name = gst_caps_is_empty(caps) ? "" :
+                    gst_structure_get_name(gst_caps_get_structure(caps, 0));
+
+    // The first video stream only, audio pads are left unlinked
+    if (g_str_has_prefix(name, "video/") && !gst_pad_is_linked(sinkpad))
+    {
+        if (GST_PAD_LINK_OK != gst_pad_link(pad, sinkpad)) {
+            NXGLOGE("Failed to link %s", name);
+        }
+    }
+
+    gst_caps_unref(caps);
+    gst_object_unref(sinkpad);
+}
+
+static gboolean has_property(GstElement *element, const char *name)
+{
+    return (NULL != g_object_class_find_property(G_OBJECT_GET_CLASS(element), name));
+}
+
+// The cover art first, then the preview image, then an image attachment
+static GstSample *embedded_image(const GstTagList *tags)
 {
-    GstElement *pipeline, *sink;
-    gint video_width, video_height;
+    static const gchar *names[] = { GST_TAG_IMAGE, GST_TAG_PREVIEW_IMAGE, GST_TAG_ATTACHMENT };
     GstSample *sample;
-    gchar *descr;
-    GError *error = NULL;
-    GdkPixbuf *pixbuf;
-    gint64 duration, position;
-    GstStateChangeReturn ret;
-    gboolean res;
-    GstMapInfo map;
-    gchar *str_caps;
-    const gchar* type = "jpeg";
+    GstCaps *caps;
 
-    FUNC_IN();
+    for (guint i = 0; i < G_N_ELEMENTS(names); i++)
+    {
+        for (guint n = 0; n < gst_tag_list_get_tag_size(tags, names[i]); n++)
+        {
+            if (!gst_tag_list_get_sample_index(tags, names[i], n, &sample))
+                continue;
+
+            caps = gst_sample_get_caps(sample);
+            if (caps && !gst_caps_is_empty(caps) && g_str_has_prefix(
+                    gst_structure_get_name(gst_caps_get_structure(caps, 0)), "image/"))
+            {
+                return sample;
+            }
+            gst_sample_unref(sample);
+        }
+    }
+    return NULL;
+}
 
-    NXGLOGI("uri(%s), pos_msec(%ld), width(%d)", uri, pos_msec, width);
+/* Tag pass: nothing reaches the decoder. The tags ahead of the first buffer,
+ * which carry the images of the headers, are searched for one. */
+static GstPadProbeReturn tag_pass_probe(struct ThumbnailPipeline *tp, GstPad *pad,
+                                        GstPadProbeInfo *info)
+{
+    GstStructure *structure = NULL;
+    GstSample *image;
+    GstTagList *tags;
 
-    gboolean isGstInitialized = gst_is_initialized();
-    NXGLOGI("isGstInitialized(%s)", isGstInitialized?"initialized":"uninitialized");
-    if (!isGstInitialized)
+    if (info->type & GST_PAD_PROBE_TYPE_BUFFER)
     {
-        gst_init(NULL, NULL);
+        if (g_atomic_int_compare_and_exchange(&tp->tag_pass_end, 0, 1)) {
+            structure = gst_structure_new_empty("nx-embedded-end");
+        }
+    }
+    else if (GST_EVENT_TAG == GST_EVENT_TYPE(GST_PAD_PROBE_INFO_EVENT(info)))
+    {
+        gst_event_parse_tag(GST_PAD_PROBE_INFO_EVENT(info), &tags);
+        if (NULL != (image = embedded_image(tags)))
+        {
+            structure = gst_structure_new("nx-embedded-image",
+                                        "image", GST_TYPE_SAMPLE, image, NULL);
+            gst_sample_unref(image);
+        }
+    }
+
+    if (structure) {
+        gst_element_post_message(tp->pipeline,
+                                gst_message_new_application(GST_OBJECT(pad), structure));
+    }
+
+    return (info->type & GST_PAD_PROBE_TYPE_BUFFER) ? GST_PAD_PROBE_DROP : GST_PAD_PROBE_OK;
+}
+
+/* Runs on the sink pad of the video decoder in THUMBNAIL_FLAG_FAST_DECODE,
+ * or for the tag pass. Only keyframes are decoded, a key unit seek always
+ * lands on one. */
+static GstPadProbeReturn decoder_probe(GstPad *pad, GstPadProbeInfo *info,
+                                    gpointer user_data)
+{
+    struct ThumbnailPipeline *tp = (struct ThumbnailPipeline *)user_data;
+
+    if (tp->tag_pass)
+        return tag_pass_probe(tp, pad, info);
+
+    if (info->type & GST_PAD_PROBE_TYPE_BUFFER)
+    {
+        GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+
+        return GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT) ?
+                GST_PAD_PROBE_DROP : GST_PAD_PROBE_OK;
+    }
+
+    GstEvent *event = GST_PAD_PROBE_INFO_EVENT(info);
+    if (GST_EVENT_CAPS == GST_EVENT_TYPE(event))
+    {
+        GstElement *decoder = gst_pad_get_parent_element(pad);
+        GstCaps *caps;
+        gint width = 0, lowres = 0;
+
+        gst_event_parse_caps(event, &caps);
+        gst_structure_get_int(gst_caps_get_structure(caps, 0), "width", &width);
+
+        // avdec_*: 1/2 or 1/4 of the size, as long as it stays above the thumbnail
+        while (lowres < 2 && (width >> (lowres + 1)) >= tp->width) {
+            lowres++;
+        }
+        if (decoder && has_property(decoder, "lowres"))
+        {
+            NXGLOGI("%s: %d -> lowres(%d)", GST_ELEMENT_NAME(decoder), width, lowres);
+            g_object_set(decoder, "lowres", lowres, NULL);
+        }
+        if (decoder) {
+            gst_object_unref(decoder);
+        }
+    }
+
+    return GST_PAD_PROBE_OK;
+}
+
+static void on_element_added(GstBin *bin, GstBin *sub_bin, GstElement *element,
+                            gpointer data)
+{
+    struct ThumbnailPipeline *tp = (struct ThumbnailPipeline *)data;
+    GstElementFactory *factory = gst_element_get_factory(element);
+    const gchar *klass;
+
+    if (!(tp->flags & THUMBNAIL_FLAG_FAST_DECODE || tp->tag_pass) || NULL == factory)
+        return;
+
+    klass = gst_element_factory_get_metadata(factory, GST_ELEMENT_METADATA_KLASS);
+    if (klass && strstr(klass, "Decoder") && strstr(klass, "Video"))
+    {
+        GstPad *sinkpad = gst_element_get_static_pad(element, "sink");
+        if (sinkpad)
+        {
+            gst_pad_add_probe(sinkpad, (GstPadProbeType)(GST_PAD_PROBE_TYPE_BUFFER |
+                        GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM), decoder_probe, tp, NULL);
+            gst_object_unref(sinkpad);
+        }
     }
+}
+
+/* Values of the "autoplug-select" signal of decodebin, which does not
+ * install a GType for them */
+typedef enum {
+    AUTOPLUG_SELECT_TRY,
+    AUTOPLUG_SELECT_EXPOSE,
+    AUTOPLUG_SELECT_SKIP,
+} AutoplugSelectResult;
 
-    // caps filter
-    str_caps = g_strdup_printf("video/x-raw,format=RGB,width=%d,pixel-aspect-ratio=1/1", width);
-    NXGLOGI("str_caps(%s)", str_caps);
+static gboolean is_hw_decoder(GstElementFactory *factory)
+{
+    const gchar *klass = gst_element_factory_get_metadata(factory, GST_ELEMENT_METADATA_KLASS);
 
-    // gst-launch-1.0 option
-    descr = g_strdup_printf("uridecodebin uri=file://%s ! videoconvert ! videoscale ! appsink name=sink caps=%s", uri, str_caps);
-    NXGLOGI("descr(%s)", descr);
-    pipeline = gst_parse_launch (descr, &error);
+    return (!g_strcmp0(GST_OBJECT_NAME(factory), "nxvideodec") ||
+            (klass && strstr(klass, "Decoder") && strstr(klass, "Hardware")));
+}
 
-    g_free(str_caps);
-    g_free(descr);
+/* A worker without a hardware decoder slot falls back to the software
+ * decoders, see THUMBNAIL_SERVICE.hw_decoders */
+static AutoplugSelectResult on_autoplug_select(GstElement *bin, GstPad *pad, GstCaps *caps,
+                                            GstElementFactory *factory, gpointer data)
+{
+    struct ThumbnailPipeline *tp = (struct ThumbnailPipeline *)data;
 
-    if (error != NULL)
+    if (!tp->allow_hw && is_hw_decoder(factory))
     {
-        NXGLOGE("could not construct pipeline: %s", error->message);
-        g_error_free(error);
-        return NX_GST_RET_ERROR;
+        NXGLOGI("skip %s, no hardware decoder left", GST_OBJECT_NAME(factory));
+        return AUTOPLUG_SELECT_SKIP;
     }
+    return AUTOPLUG_SELECT_TRY;
+}
+
+static struct ThumbnailPipeline *create_pipeline(void)
+{
+    struct ThumbnailPipeline *tp = g_new0(struct ThumbnailPipeline, 1);
+    GstCaps *caps;
+
+    tp->pipeline = gst_pipeline_new("thumbnail");
+    tp->decodebin = gst_element_factory_make("uridecodebin", NULL);
+    tp->sink = gst_element_factory_make("appsink", NULL);
+
+    if (!tp->pipeline || !tp->decodebin || !tp->sink)
+    {
+        NXGLOGE("Failed to create the elements");
+        if (tp->pipeline) gst_object_unref(tp->pipeline);
+        if (tp->decodebin) gst_object_unref(tp->decodebin);
+        if (tp->sink) gst_object_unref(tp->sink);
+        g_free(tp);
+        return NULL;
+    }
+
+    // Any raw format, at the size of the decoder
+    caps = gst_caps_new_empty_simple("video/x-raw");
+    g_object_set(tp->sink, "caps", caps, NULL);
+    gst_caps_unref(caps);
+
+    gst_bin_add_many(GST_BIN(tp->pipeline), tp->decodebin, tp->sink, NULL);
+
+    // gst_parse_launch() links the dynamic pad once only, it is linked
+    // again for every file here
+    g_signal_connect(tp->decodebin, "pad-added", G_CALLBACK(on_pad_added), tp);
+    g_signal_connect(tp->decodebin, "autoplug-select", G_CALLBACK(on_autoplug_select), tp);
+    g_signal_connect(tp->pipeline, "deep-element-added", G_CALLBACK(on_element_added), tp);
+
+    tp->bus = gst_element_get_bus(tp->pipeline);
+    tp->deadline = G_MAXINT64;
+    tp->allow_hw = TRUE;
+
+    return tp;
+}
+
+static void destroy_pipeline(struct ThumbnailPipeline *tp)
+{
+    if (NULL == tp)
+        return;
+
+    gst_element_set_state(tp->pipeline, GST_STATE_NULL);
+    gst_object_unref(tp->bus);
+    gst_object_unref(tp->pipeline);
+    g_free(tp);
+}
+
+/* Nobody watches the bus, so the messages of a job are dropped once it is
+ * done instead of piling up over the jobs. */
+static void flush_bus(struct ThumbnailPipeline *tp)
+{
+    GstMessage *msg;
+
+    while (NULL != (msg = gst_bus_pop_filtered(tp->bus, GST_MESSAGE_ERROR)))
+    {
+        GError *error = NULL;
+        gchar *debug = NULL;
+
+        gst_message_parse_error(msg, &error, &debug);
+        NXGLOGE("%s: %s", GST_OBJECT_NAME(msg->src), error->message);
+        g_clear_error(&error);
+        g_free(debug);
+        gst_message_unref(msg);
+    }
+}
+
+/* Time left until 'deadline' and the deadline of the job, in monotonic time,
+ * up to THUMBNAIL_TIMEOUT. None once the job is cancelled. */
+static GstClockTime time_left(struct ThumbnailPipeline *tp, gint64 deadline)
+{
+    gint64 left = MIN(deadline, tp->deadline) - g_get_monotonic_time();
+
+    if (g_atomic_int_get(&tp->cancelled))
+        return 0;
+
+    return (left > 0) ? MIN((GstClockTime)left * GST_USECOND, THUMBNAIL_TIMEOUT) : 0;
+}
+
+static void set_uri(struct ThumbnailPipeline *tp, const char *uri)
+{
+    gchar *str = g_strdup_printf("file://%s", uri);
+
+    g_object_set(tp->decodebin, "uri", str, NULL);
+    g_free(str);
+}
 
-    /* get sink */
-    sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+static gboolean open_file(struct ThumbnailPipeline *tp, const char *uri, gint32 width,
+                        gint32 flags)
+{
+    GstStateChangeReturn ret;
+
+    tp->flags = flags;
+    tp->width = width;
+    set_uri(tp, uri);
 
     /* set to PAUSED to make the first frame arrive in the sink */
-    ret = gst_element_set_state(pipeline, GST_STATE_PAUSED);
+    ret = gst_element_set_state(tp->pipeline, GST_STATE_PAUSED);
     switch (ret)
     {
         case GST_STATE_CHANGE_FAILURE:
             NXGLOGE("failed to play the file");
-            return NX_GST_RET_ERROR;
+            return FALSE;
         case GST_STATE_CHANGE_NO_PREROLL:
             /* for live sources, we need to set the pipeline to PLAYING before we can
             * receive a buffer. We don't do that yet */
             NXGLOGE("live sources not supported yet");
-            return NX_GST_RET_ERROR;
+            return FALSE;
         default:
             break;
     }
 
-    /* This can block for up to 5 seconds. If your machine is really overloaded,
-    * it might time out before the pipeline prerolled and we generate an error. A
-    * better way is to run a mainloop and catch errors there. */
-    ret = gst_element_get_state(pipeline, NULL, NULL, 5 * GST_SECOND);
-    if (ret == GST_STATE_CHANGE_FAILURE)
+    /* This can block for up to THUMBNAIL_TIMEOUT, less if the job has a
+    * deadline, the worker gives up on the file if it is not prerolled by then. */
+    ret = gst_element_get_state(tp->pipeline, NULL, NULL, time_left(tp, tp->deadline));
+    if (ret != GST_STATE_CHANGE_SUCCESS)
     {
-        NXGLOGE("failed to play the file");
-        return NX_GST_RET_ERROR;
+        NXGLOGE("failed to preroll the file(%s)", gst_element_state_change_return_get_name(ret));
+        return FALSE;
     }
 
-    /* get the duration */
-    gst_element_query_duration(pipeline, GST_FORMAT_TIME, &duration);
-    position = pos_msec * 1000 * 1000;
+    return TRUE;
+}
+
+/* Frame of the keyframe at or before 'pos_msec', or the first one from
+ * 'pos_msec' on with 'snap_after'. Waits 'timeout' at most. */
+static GstSample *pull_frame(struct ThumbnailPipeline *tp, gint64 pos_msec, gboolean snap_after,
+                            GstClockTime timeout)
+{
+    GstSeekFlags flags = (GstSeekFlags)(GST_SEEK_FLAG_KEY_UNIT | GST_SEEK_FLAG_FLUSH);
+    GstSample *sample = NULL;
 
     /* seek to the a position in the file. Most files have a black first frame so
     * by seeking to somewhere else we have a bigger chance of getting something
-    * more interesting. An optimisation would be to detect black images and then
-    * seek a little more */
-    GstSeekFlags flags = (GstSeekFlags) (GST_SEEK_FLAG_KEY_UNIT | GST_SEEK_FLAG_FLUSH);
-    gst_element_seek_simple(pipeline, GST_FORMAT_TIME,
-                flags, position);
+    * more interesting. THUMBNAIL_FLAG_SKIP_FLAT goes on to the next keyframes
+    * if it is still black, see skip_flat_frames() */
+    if (snap_after) {
+        flags = (GstSeekFlags)(flags | GST_SEEK_FLAG_SNAP_AFTER);
+    }
+    gst_element_seek_simple(tp->pipeline, GST_FORMAT_TIME, flags, pos_msec * GST_MSECOND);
 
     /* get the preroll buffer from appsink, this block untils appsink really
-    * prerolls */
-    g_signal_emit_by_name (sink, "pull-preroll", &sample, NULL);
-    gst_object_unref (sink);
+    * prerolls. It's possible that we don't have a buffer because we went EOS
+    * right away or had an error. */
+    g_signal_emit_by_name(tp->sink, "try-pull-preroll", timeout, &sample);
+    if (NULL == sample) {
+        NXGLOGE("could not make snapshot at %" G_GINT64_FORMAT " ms", pos_msec);
+    }
 
-    NX_GST_RET result = NX_GST_RET_ERROR;
-    /* if we have a buffer now, convert it to a pixbuf. It's possible that we
-    * don't have a buffer because we went EOS right away or had an error. */
-    if (sample)
+    return sample;
+}
+
+// Stream time of the frame of 'sample', -1 if unknown
+static gint64 sample_position(GstSample *sample)
+{
+    GstBuffer *buffer = gst_sample_get_buffer(sample);
+    const GstSegment *segment = gst_sample_get_segment(sample);
+    guint64 position;
+
+    if (!buffer || !segment || !GST_BUFFER_PTS_IS_VALID(buffer))
+        return -1;
+
+    position = gst_segment_to_stream_time(segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buffer));
+    return GST_CLOCK_TIME_IS_VALID(position) ? (gint64)(position / GST_MSECOND) : -1;
+}
+
+/* Fades, black intros and title cards make poor thumbnails. While the frame
+ * is flat, tries the next keyframes within FLAT_MAX_RETRIES and
+ * FLAT_TIME_BUDGET. Returns the first frame that is not flat, else the least
+ * flat one, and the number of keyframes tried after 'sample'. */
+static GstSample *skip_flat_frames(struct ThumbnailPipeline *tp, GstSample *sample,
+                                gint32 *retries)
+{
+    gint64 deadline = g_get_monotonic_time() + FLAT_TIME_BUDGET;
+    gint64 position = sample_position(sample);
+    GstSample *best = gst_sample_ref(sample);
+    GstSample *next;
+    guint mean, variance, best_variance;
+
+    *retries = 0;
+    if (!NX_SampleLumaStats(sample, &mean, &best_variance))
+        return best;
+
+    variance = best_variance;
+    while (variance < FLAT_VARIANCE && position >= 0 &&
+        *retries < FLAT_MAX_RETRIES && time_left(tp, deadline) > 0)
     {
-        GstBuffer *buffer;
-        GstCaps *caps;
-        GstStructure *s;
+        NXGLOGI("flat frame at %" G_GINT64_FORMAT " ms, mean(%u), variance(%u)",
+                position, mean, variance);
 
-        /* get the snapshot buffer format now. We set the caps on the appsink so
-        * that it can only be an rgb buffer. The only thing we have not specified
-        * on the caps is the height, which is dependent on the pixel-aspect-ratio
-        * of the source material */
-        caps = gst_sample_get_caps(sample);
-        if (!caps)
+        // Ends at the end of the file or on a seek that did not move
+        next = pull_frame(tp, position + 1, TRUE, time_left(tp, deadline));
+        (*retries)++;
+        if (NULL == next)
+            break;
+        if (sample_position(next) <= position || !NX_SampleLumaStats(next, &mean, &variance))
         {
-            NXGLOGE("could not get snapshot format");
-            return NX_GST_RET_ERROR;
+            gst_sample_unref(next);
+            break;
         }
-        s = gst_caps_get_structure(caps, 0);
+        position = sample_position(next);
 
-        /* we need to get the final caps on the buffer to get the size */
-        res = gst_structure_get_int (s, "width", &video_width);
-        res |= gst_structure_get_int (s, "height", &video_height);
-        if (!res)
+        if (variance > best_variance)
+        {
+            gst_sample_unref(best);
+            best = next;
+            best_variance = variance;
+        }
+        else
+        {
+            gst_sample_unref(next);
+        }
+    }
+
+    return best;
+}
+
+/* Detailed (edges) and well exposed (spread) frames of a steady shot (close
+ * to the keyframe before) score best, transitions and fades are blurred
+ * and change a lot. A flat frame only wins over other flat frames. */
+static gint64 frame_score(const NX_LUMA_FEATURES *features)
+{
+    gint64 score = (gint64)features->edges * 2 + (gint64)features->spread * 4;
+
+    if (features->difference > 0) {
+        score -= features->difference / 2;
+    }
+    if (features->variance < FLAT_VARIANCE) {
+        score -= G_MAXINT32;
+    }
+    return score;
+}
+
+/* Scores the keyframes from BEST_WINDOW / 2 before 'pos_msec' to as much
+ * after it, BEST_FRAME_COUNT of them at most within BEST_TIME_BUDGET (and
+ * the deadline of the job), and
+ * returns the best one, and the number of keyframes scored after the first. */
+static GstSample *pick_best_frame(struct ThumbnailPipeline *tp, gint64 pos_msec, gint32 *retries)
+{
+    gint64 deadline = g_get_monotonic_time() + BEST_TIME_BUDGET;
+    gint64 end = pos_msec + BEST_WINDOW / 2;
+    gint64 best_score = G_MININT64, score, position;
+    GstSample *sample, *prev = NULL, *best = NULL;
+    NX_LUMA_FEATURES features;
+    gint32 tried = 0;
+
+    sample = pull_frame(tp, MAX(pos_msec - BEST_WINDOW / 2, 0), FALSE,
+                        time_left(tp, tp->deadline));
+    while (sample)
+    {
+        position = sample_position(sample);
+        tried++;
+
+        if (!NX_SampleLumaFeatures(sample, prev, &features))
+        {
+            // Not YUV, nothing to score
+            if (NULL == best) {
+                best = gst_sample_ref(sample);
+            }
+            gst_sample_unref(sample);
+            break;
+        }
+        score = frame_score(&features);
+        NXGLOGI("%" G_GINT64_FORMAT " ms: edges(%u), spread(%u), difference(%d), score(%"
+                G_GINT64_FORMAT ")", position, features.edges, features.spread,
+                features.difference, score);
+        if (score > best_score)
+        {
+            if (best) {
+                gst_sample_unref(best);
+            }
+            best = gst_sample_ref(sample);
+            best_score = score;
+        }
+        if (prev) {
+            gst_sample_unref(prev);
+        }
+        prev = sample;
+
+        if (tried >= BEST_FRAME_COUNT || position < 0 || position >= end ||
+            0 == time_left(tp, deadline))
+        {
+            break;
+        }
+        sample = pull_frame(tp, position + 1, TRUE, time_left(tp, deadline));
+        // The end of the file, or a seek that did not move
+        if (sample && sample_position(sample) <= position)
+        {
+            gst_sample_unref(sample);
+            sample = NULL;
+        }
+    }
+    if (prev) {
+        gst_sample_unref(prev);
+    }
+    *retries = MAX(tried - 1, 0);
+
+    return best;
+}
+
+static void close_file(struct ThumbnailPipeline *tp, gboolean ok)
+{
+    // A failed pipeline is fully reset, READY is enough to swap the uri
+    gst_element_set_state(tp->pipeline, ok ? GST_STATE_READY : GST_STATE_NULL);
+    flush_bus(tp);
+}
+
+/* THUMBNAIL_FLAG_EMBEDDED_IMAGE: a tag pass over the headers of the file,
+ * the video is not decoded. Ends on the first video buffer, as the demuxers
+ * send the cover art (mp4 'covr'), the preview images and the attachments
+ * (mkv) before, or after EMBEDDED_TIMEOUT. */
+static GstSample *find_embedded_image(struct ThumbnailPipeline *tp, const char *uri)
+{
+    gint64 deadline = g_get_monotonic_time() + EMBEDDED_TIMEOUT;
+    const GstStructure *structure;
+    GstSample *image = NULL;
+    GstClockTime timeout;
+    GstMessage *msg;
+    gboolean done = FALSE;
+
+    tp->flags = 0;
+    tp->width = 0;
+    tp->tag_pass = TRUE;
+    g_atomic_int_set(&tp->tag_pass_end, 0);
+    set_uri(tp, uri);
+
+    if (GST_STATE_CHANGE_FAILURE == gst_element_set_state(tp->pipeline, GST_STATE_PAUSED)) {
+        done = TRUE;
+    }
+    while (!done && 0 != (timeout = time_left(tp, deadline)) &&
+        NULL != (msg = gst_bus_timed_pop_filtered(tp->bus, timeout,
+                        (GstMessageType)(GST_MESSAGE_APPLICATION | GST_MESSAGE_ERROR))))
+    {
+        structure = gst_message_get_structure(msg);
+        if (GST_MESSAGE_ERROR == GST_MESSAGE_TYPE(msg) ||
+            gst_structure_has_name(structure, "nx-embedded-end"))
+        {
+            done = TRUE;
+        }
+        else if (gst_structure_has_name(structure, "nx-embedded-image"))
+        {
+            done = gst_structure_get(structure, "image", GST_TYPE_SAMPLE, &image, NULL);
+        }
+        gst_message_unref(msg);
+    }
+
+    gst_element_set_state(tp->pipeline, GST_STATE_READY);
+    flush_bus(tp);
+    tp->tag_pass = FALSE;
+
+    NXGLOGI("uri(%s), embedded image(%s)", uri, image ? "yes" : "no");
+
+    return image;
+}
+
+/* Room for 'size' bytes in 'buffer', allocated if the caller gave none. If
+ * the buffer of the caller is too small, 'size' tells the size needed. */
+static gboolean reserve_buffer(struct THUMBNAIL_BUFFER *buffer, gsize size)
+{
+    if (NULL == buffer->data)
+    {
+        buffer->data = (uint8_t *)g_try_malloc(size);
+        if (NULL == buffer->data)
+        {
+            NXGLOGE("Failed to alloc %" G_GSIZE_FORMAT " bytes", size);
+            return FALSE;
+        }
+    }
+    else if ((gsize)buffer->size < size)
+    {
+        NXGLOGE("buffer too small, %d < %" G_GSIZE_FORMAT, buffer->size, size);
+        buffer->size = (int32_t)size;
+        return FALSE;
+    }
+    buffer->size = (int32_t)size;
+
+    return TRUE;
+}
+
+static gboolean is_encoded(const struct THUMBNAIL_BUFFER *buffer)
+{
+    return (THUMBNAIL_FORMAT_JPEG == buffer->format || THUMBNAIL_FORMAT_PNG == buffer->format);
+}
+
+static NX_RGB_FORMAT raw_format(const struct THUMBNAIL_BUFFER *buffer)
+{
+    return (THUMBNAIL_FORMAT_RGB565 == buffer->format) ?
+            NX_RGB_FORMAT_RGB565 : NX_RGB_FORMAT_ARGB8888;
+}
+
+// Fills 'buffer' with an RGB frame
+static gboolean write_frame_buffer(const struct CAPTURE_FRAME *frame,
+                                struct THUMBNAIL_BUFFER *buffer)
+{
+    gchar *data = NULL;
+    gsize size;
+
+    buffer->width = frame->width;
+    buffer->height = frame->height;
+
+    if (is_encoded(buffer))
+    {
+        if (!NX_EncodeCapturedFrame(frame, (THUMBNAIL_FORMAT_PNG == buffer->format) ?
+                                    "png" : "jpeg", &data, &size))
+        {
+            return FALSE;
+        }
+        buffer->stride = 0;
+
+        // The encoder output is handed over as is if the library allocates
+        if (NULL == buffer->data)
+        {
+            buffer->data = (uint8_t *)data;
+            buffer->size = (int32_t)size;
+            return TRUE;
+        }
+        if (!reserve_buffer(buffer, size))
+        {
+            g_free(data);
+            return FALSE;
+        }
+        memcpy(buffer->data, data, size);
+        g_free(data);
+        return TRUE;
+    }
+
+    buffer->stride = frame->width * NX_RGBBytesPerPixel(raw_format(buffer));
+    if (!reserve_buffer(buffer, (gsize)buffer->stride * frame->height))
+        return FALSE;
+
+    NX_PackRGB888(frame->data, frame->stride, buffer->data, buffer->stride,
+                frame->width, frame->height, raw_format(buffer));
+    return TRUE;
+}
+
+/* Fills 'buffer' with the frame of 'sample'. The raw formats are converted
+ * straight into it. */
+static gboolean write_buffer(GstSample *sample, gint32 width, struct THUMBNAIL_BUFFER *buffer)
+{
+    gboolean allocated = (NULL == buffer->data);
+    struct CAPTURE_FRAME *frame;
+    gboolean res;
+    gint height;
+
+    if (is_encoded(buffer))
+    {
+        frame = NX_ConvertSample(sample, width);
+        res = frame && write_frame_buffer(frame, buffer);
+        NX_FreeCapturedFrame(frame);
+        return res;
+    }
+
+    if (!NX_SampleOutputSize(sample, width, &width, &height))
+        return FALSE;
+
+    buffer->width = width;
+    buffer->height = height;
+    buffer->stride = width * NX_RGBBytesPerPixel(raw_format(buffer));
+    if (!reserve_buffer(buffer, (gsize)buffer->stride * height))
+        return FALSE;
+
+    if (!NX_ConvertSampleInto(sample, raw_format(buffer), buffer->data, buffer->stride,
+                            width, height))
+    {
+        if (allocated) {
+            g_free(buffer->data);
+            buffer->data = NULL;
+        }
+        return FALSE;
+    }
+    return TRUE;
+}
+
+// Writes 'frame' to the output of 'job'
+static gboolean write_frame(const struct ThumbnailJob *job, const struct CAPTURE_FRAME *frame)
+{
+    if (job->buffer)
+        return write_frame_buffer(frame, job->buffer);
+
+    return NX_SaveCapturedFrame(frame, job->outPath);
+}
+
+// Sets 'ret', 'pos_msec' and 'retries' of 'result'
+static void run_job(struct ThumbnailPipeline *tp, const struct ThumbnailJob *job,
+                    struct THUMBNAIL_RESULT *result)
+{
+    struct CAPTURE_FRAME *frame;
+    GstSample *sample = NULL, *first, *image;
+    gint32 flags = job->flags;
+
+    NXGLOGI("uri(%s), pos_msec(%" G_GINT64_FORMAT "), width(%d), flags(0x%x)",
+            job->uri, job->pos_msec, job->width, job->flags);
+
+    result->ret = NX_GST_RET_ERROR;
+    result->pos_msec = -1;
+    result->retries = 0;
+
+    // Falls back to the video if the image cannot be decoded
+    if ((flags & THUMBNAIL_FLAG_EMBEDDED_IMAGE) &&
+        NULL != (image = find_embedded_image(tp, job->uri)))
+    {
+        frame = NX_ConvertImageSample(image, job->width);
+        gst_sample_unref(image);
+        if (frame && write_frame(job, frame)) {
+            result->ret = NX_GST_RET_OK;
+        }
+        NX_FreeCapturedFrame(frame);
+
+        if (NX_GST_RET_OK == result->ret)
+        {
+            NXGLOGI("embedded image outPath: %s", job->outPath ? job->outPath : "(buffer)");
+            return;
+        }
+    }
+
+    // The candidates of the best frame are decoded at the lowest resolution that fits
+    if (flags & THUMBNAIL_FLAG_BEST_FRAME) {
+        flags |= THUMBNAIL_FLAG_FAST_DECODE;
+    }
+
+    if (open_file(tp, job->uri, job->width, flags))
+    {
+        if (flags & THUMBNAIL_FLAG_BEST_FRAME)
+        {
+            sample = pick_best_frame(tp, job->pos_msec, &result->retries);
+        }
+        else if (NULL != (first = pull_frame(tp, job->pos_msec, FALSE, time_left(tp, tp->deadline))) &&
+                (flags & THUMBNAIL_FLAG_SKIP_FLAT))
+        {
+            sample = skip_flat_frames(tp, first, &result->retries);
+            gst_sample_unref(first);
+        }
+        else
+        {
+            sample = first;
+        }
+    }
+
+    if (sample && job->buffer)
+    {
+        result->pos_msec = sample_position(sample);
+        if (write_buffer(sample, job->width, job->buffer)) {
+            result->ret = NX_GST_RET_OK;
+        }
+        gst_sample_unref(sample);
+    }
+    else if (sample)
+    {
+        frame = NX_ConvertSample(sample, job->width);
+        if (frame)
         {
-            NXGLOGE("could not get snapshot dimension");
+            result->pos_msec = (frame->pts >= 0) ? frame->pts / GST_MSECOND : job->pos_msec;
+            if (write_frame(job, frame)) {
+                result->ret = NX_GST_RET_OK;
+            }
+            NX_FreeCapturedFrame(frame);
+        }
+        gst_sample_unref(sample);
+    }
+    close_file(tp, NX_GST_RET_OK == result->ret);
+
+    NXGLOGI("snapshot outPath: %s, ret(%d), retries(%d)",
+            job->outPath ? job->outPath : "(buffer)", result->ret, result->retries);
+}
+
+static void emit_frame(const struct ThumbnailJob *job, gint32 index,
+                    gint64 pos_msec, const struct CAPTURE_FRAME *frame)
+{
+    struct THUMBNAIL_RESULT result;
+
+    result.job_id = job->id;
+    result.ret = NX_GST_RET_OK;
+    result.outPath = NULL;
+    result.pos_msec = pos_msec;
+    result.retries = 0;
+    result.index = index;
+    result.frame = frame;
+
+    if (job->callback) {
+        job->callback(job->owner, &result);
+    }
+}
+
+static void format_vtt_time(GString *str, gint64 msec)
+{
+    g_string_append_printf(str, "%02d:%02d:%02d.%03d",
+            (gint)(msec / 3600000), (gint)(msec / 60000 % 60),
+            (gint)(msec / 1000 % 60), (gint)(msec % 1000));
+}
+
+/* '<sprite>.vtt', the WebVTT thumbnail track of the sheet: each cue lasts
+ * until the next tile and points to its area as "sprite.jpg#xywh=x,y,w,h". */
+static gboolean write_sprite_manifest(const char *spritePath, const gint64 *tile_pos,
+                                    gint32 count, gint32 columns, gint32 tile_w,
+                                    gint32 tile_h, gint64 end_msec)
+{
+    GString *str = g_string_new("WEBVTT\n");
+    gchar *name = g_path_get_basename(spritePath);
+    gchar *path = g_strdup_printf("%s.vtt", spritePath);
+    GError *error = NULL;
+    gboolean res;
+
+    for (gint32 i = 0; i < count; i++)
+    {
+        if (tile_pos[i] < 0)
+            continue;
+
+        g_string_append_c(str, '\n');
+        format_vtt_time(str, tile_pos[i]);
+        g_string_append(str, " --> ");
+        format_vtt_time(str, (i + 1 < count) ? MAX(tile_pos[i + 1], tile_pos[i]) : end_msec);
+        g_string_append_printf(str, "\n%s#xywh=%d,%d,%d,%d\n", name,
+                (i % columns) * tile_w, (i / columns) * tile_h, tile_w, tile_h);
+    }
+
+    res = g_file_set_contents(path, str->str, str->len, &error);
+    if (!res)
+    {
+        NXGLOGE("Failed to write %s: %s", path, error->message);
+        g_clear_error(&error);
+    }
+
+    g_string_free(str, TRUE);
+    g_free(name);
+    g_free(path);
+
+    return res;
+}
+
+/* All the positions of the job from one prerolled pipeline, seeking forward
+ * from keyframe to keyframe. Each frame is handed to the callback as it
+ * comes, and copied into its tile of the sprite sheet if one is asked. */
+static NX_GST_RET run_strip_job(struct ThumbnailPipeline *tp, const struct ThumbnailJob *job)
+{
+    struct CAPTURE_FRAME *sheet = NULL;
+    gint32 columns = MIN(job->count, SPRITE_COLUMNS);
+    gint64 *tile_pos = g_new(gint64, job->count);
+    gint64 duration = -1;
+    gint32 done = 0;
+    gboolean opened;
+
+    NXGLOGI("uri(%s), count(%d), width(%d), flags(0x%x)",
+            job->uri, job->count, job->width, job->flags);
+
+    opened = open_file(tp, job->uri, job->width, job->flags);
+    if (opened) {
+        gst_element_query_duration(tp->pipeline, GST_FORMAT_TIME, &duration);
+    }
+
+    for (gint32 i = 0; i < job->count; i++)
+    {
+        struct CAPTURE_FRAME *frame;
+        GstSample *sample;
+
+        // Past the deadline of the job or cancelled, the rest is left out
+        tile_pos[i] = -1;
+        if (!opened || 0 == time_left(tp, tp->deadline) ||
+            NULL == (sample = pull_frame(tp, job->positions[i], FALSE,
+                                        time_left(tp, tp->deadline))))
+        {
+            continue;
+        }
+
+        frame = NX_ConvertSample(sample, job->width);
+        if (frame)
+        {
+            tile_pos[i] = (frame->pts >= 0) ? frame->pts / GST_MSECOND : job->positions[i];
+            emit_frame(job, job->indexes[i], tile_pos[i], frame);
+
+            if (job->outPath && NULL == sheet)
+            {
+                gint32 rows = (job->count + columns - 1) / columns;
+
+                sheet = g_new0(struct CAPTURE_FRAME, 1);
+                sheet->width = frame->width * columns;
+                sheet->height = frame->height * rows;
+                sheet->stride = GST_ROUND_UP_4(sheet->width * 3);
+                sheet->data = (uint8_t *)g_malloc0((gsize)sheet->stride * sheet->height);
+            }
+            if (sheet)
+            {
+                // The tiles are the size of the first frame
+                gint32 tile_w = sheet->width / columns;
+                gint32 tile_h = sheet->height / ((job->count + columns - 1) / columns);
+                uint8_t *dst = sheet->data + (i / columns) * tile_h * sheet->stride +
+                                (i % columns) * tile_w * 3;
+
+                for (gint32 y = 0; y < MIN(frame->height, tile_h); y++)
+                {
+                    memcpy(dst + y * sheet->stride, frame->data + y * frame->stride,
+                            MIN(frame->width, tile_w) * 3);
+                }
+            }
+            done++;
+            NX_FreeCapturedFrame(frame);
+        }
+        gst_sample_unref(sample);
+    }
+    close_file(tp, done > 0);
+
+    if (sheet)
+    {
+        gint32 tile_w = sheet->width / columns;
+        gint32 tile_h = sheet->height / ((job->count + columns - 1) / columns);
+        gint64 end_msec = (duration > 0) ? duration / GST_MSECOND :
+                            tile_pos[job->count - 1] + 1000;
+
+        if (!NX_SaveCapturedFrame(sheet, job->outPath) ||
+            !write_sprite_manifest(job->outPath, tile_pos, job->count, columns,
+                                tile_w, tile_h, end_msec)) {
+            done = 0;
+        }
+        NX_FreeCapturedFrame(sheet);
+    }
+    g_free(tile_pos);
+
+    NXGLOGI("%d/%d frames, sprite(%s)", done, job->count, job->outPath);
+
+    return (done > 0) ? NX_GST_RET_OK : NX_GST_RET_ERROR;
+}
+
+/* One keyframe every interval of the job, from the start to the end of the
+ * file, encoded into the preview track. An interval falling on the keyframe
+ * of the previous one is left to the track, which points it to that image. */
+static NX_GST_RET run_preview_job(struct ThumbnailPipeline *tp, const struct ThumbnailJob *job)
+{
+    struct PreviewTrackWriter *writer = NULL;
+    gint64 duration = -1;
+    gint64 last_pts = -1;
+    gint32 count = 0;
+    gint32 done = 0;
+    gboolean ok;
+
+    NXGLOGI("uri(%s), interval(%d), width(%d), track(%s)",
+            job->uri, job->interval_msec, job->width, job->outPath);
+
+    if (NX_IsPreviewTrackCurrent(job->outPath, job->uri, job->interval_msec))
+    {
+        NXGLOGI("%s is up to date", job->outPath);
+        return NX_GST_RET_OK;
+    }
+
+    // Keyframes only, at a reduced resolution if the decoder supports it
+    ok = open_file(tp, job->uri, job->width, job->flags | THUMBNAIL_FLAG_FAST_DECODE) &&
+        gst_element_query_duration(tp->pipeline, GST_FORMAT_TIME, &duration) && duration > 0;
+    if (ok)
+    {
+        count = (gint32)MIN(duration / GST_MSECOND / job->interval_msec + 1, PREVIEW_MAX_IMAGES);
+        writer = NX_CreatePreviewTrack(job->outPath, job->interval_msec, count);
+        ok = (NULL != writer);
+    }
+
+    for (gint32 i = 0; ok && i < count; i++)
+    {
+        struct CAPTURE_FRAME *frame;
+        GstSample *sample;
+        gchar *data;
+        gsize size;
+
+        // Past the deadline of the job or cancelled, the track is dropped
+        if (0 == time_left(tp, tp->deadline))
+        {
+            ok = FALSE;
+            break;
+        }
+        sample = pull_frame(tp, (gint64)i * job->interval_msec, FALSE,
+                            time_left(tp, tp->deadline));
+        if (NULL == sample)
+            continue;
+
+        frame = NX_ConvertSample(sample, job->width);
+        if (frame && (frame->pts < 0 || frame->pts != last_pts) &&
+            NX_EncodeCapturedFrame(frame, "jpeg", &data, &size))
+        {
+            last_pts = frame->pts;
+            ok = NX_AddPreviewImage(writer, i, (frame->pts >= 0) ? frame->pts / GST_MSECOND :
+                                    (gint64)i * job->interval_msec,
+                                    data, size, frame->width, frame->height);
+            done++;
+            g_free(data);
+        }
+        if (frame) {
+            NX_FreeCapturedFrame(frame);
+        }
+        gst_sample_unref(sample);
+    }
+    close_file(tp, done > 0);
+
+    if (writer) {
+        ok = NX_FinishPreviewTrack(writer, ok);
+    }
+
+    NXGLOGI("%d images for %d intervals, track(%s)", done, count, job->outPath);
+
+    return ok ? NX_GST_RET_OK : NX_GST_RET_ERROR;
+}
+
+/* A cached thumbnail is copied to outPath, GStreamer is not involved.
+ * Otherwise 'key' is set, if the cache is enabled, for store_cache(). */
+static gboolean lookup_cache(const struct ThumbnailJob *job, gchar **key,
+                            struct THUMBNAIL_RESULT *result)
+{
+    *key = NX_ThumbnailCacheKey(job->uri, job->pos_msec, job->width, job->flags,
+                                job->outPath);
+    if (*key && NX_LookupThumbnailCache(*key, job->outPath, result))
+    {
+        NXGLOGI("cached: uri(%s), pos_msec(%" G_GINT64_FORMAT "), outPath(%s)",
+                job->uri, job->pos_msec, job->outPath);
+        result->ret = NX_GST_RET_OK;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static void store_cache(const gchar *key, const struct ThumbnailJob *job,
+                        const struct THUMBNAIL_RESULT *result)
+{
+    if (key && NX_GST_RET_OK == result->ret) {
+        NX_StoreThumbnailCache(key, job->outPath, result);
+    }
+}
+
+static void init_gst(void)
+{
+    gboolean isGstInitialized = gst_is_initialized();
+    NXGLOGI("isGstInitialized(%s)", isGstInitialized?"initialized":"uninitialized");
+    if (!isGstInitialized)
+    {
+        gst_init(NULL, NULL);
+    }
+}
+
+static NX_GST_RET make_thumbnail(struct ThumbnailJob *job, struct THUMBNAIL_RESULT *pResult)
+{
+    struct ThumbnailPipeline *tp;
+    struct THUMBNAIL_RESULT result = { 0, };
+    gchar *key = NULL;
+
+    // A thumbnail in memory stays off the filesystem, the cache included
+    if (job->buffer || !lookup_cache(job, &key, &result))
+    {
+        init_gst();
+
+        tp = create_pipeline();
+        if (NULL == tp)
+        {
+            NXGLOGE("could not construct pipeline");
+            g_free(key);
             return NX_GST_RET_ERROR;
         }
 
-        /* create pixmap from buffer and save, gstreamer video buffers have a stride
-        * that is rounded up to the nearest multiple of 4 */
-        buffer = gst_sample_get_buffer(sample);
-        gst_buffer_map(buffer, &map, GST_MAP_READ);
-        pixbuf = gdk_pixbuf_new_from_data(map.data,
-                    GDK_COLORSPACE_RGB, FALSE, 8, video_width, video_height,
-        GST_ROUND_UP_4 (video_width * 3), NULL, NULL);
+        run_job(tp, job, &result);
 
-        /* save the pixbuf */
-        gdk_pixbuf_save(pixbuf, outPath, type, &error, NULL);
-        gst_buffer_unmap(buffer, &map);
+        /* cleanup and exit */
+        destroy_pipeline(tp);
 
-        result = NX_GST_RET_OK;
+        store_cache(key, job, &result);
     }
-    else
+    g_free(key);
+
+    if (pResult)
     {
-        NXGLOGE("could not make snapshot");
-        result = NX_GST_RET_ERROR;
+        result.outPath = job->outPath;
+        result.index = -1;
+        *pResult = result;
     }
 
-    /* cleanup and exit */
-    gst_element_set_state(pipeline, GST_STATE_NULL);
-    gst_object_unref(pipeline);
+    return result.ret;
+}
+
+NX_GST_RET
+makeThumbnail(const char *uri, int64_t pos_msec, int32_t width, const char *outPath,
+            int32_t flags, struct THUMBNAIL_RESULT *pResult)
+{
+    struct ThumbnailJob job = { 0, };
+    NX_GST_RET result;
+
+    FUNC_IN();
+
+    job.uri = (gchar *)uri;
+    job.pos_msec = pos_msec;
+    job.width = width;
+    job.outPath = (gchar *)outPath;
+    job.flags = flags;
+    result = make_thumbnail(&job, pResult);
 
     FUNC_OUT();
 
-    NXGLOGI("%s() snapshot outPath: %s", outPath);
+    return result;
+}
+
+NX_GST_RET
+makeThumbnailToBuffer(const char *uri, int64_t pos_msec, int32_t width, int32_t flags,
+                    struct THUMBNAIL_BUFFER *pBuffer, struct THUMBNAIL_RESULT *pResult)
+{
+    struct ThumbnailJob job = { 0, };
+    NX_GST_RET result;
+
+    FUNC_IN();
+
+    job.uri = (gchar *)uri;
+    job.pos_msec = pos_msec;
+    job.width = width;
+    job.flags = flags;
+    job.buffer = pBuffer;
+    result = make_thumbnail(&job, pResult);
+
+    FUNC_OUT();
 
     return result;
-}
\ No newline at end of file
+}
+
+static void free_job(struct ThumbnailJob *job)
+{
+    g_free(job->uri);
+    g_free(job->outPath);
+    g_free(job->positions);
+    g_free(job->indexes);
+    g_free(job);
+}
+
+// 'result' holds the outcome of the job, the rest is filled here
+static void complete_job(struct ThumbnailJob *job, struct THUMBNAIL_RESULT *result)
+{
+    result->job_id = job->id;
+    result->outPath = job->outPath;
+    result->index = -1;
+    result->frame = NULL;
+
+    if (job->callback) {
+        job->callback(job->owner, result);
+    }
+    free_job(job);
+}
+
+static void run_service_job(struct ThumbnailPipeline *tp, struct ThumbnailJob *job,
+                            struct THUMBNAIL_RESULT *result)
+{
+    gchar *key = NULL;
+
+    result->ret = NX_GST_RET_ERROR;
+    result->pos_msec = -1;
+
+    // Strip and preview track jobs are not cached
+    if (job->count == 0 && job->interval_msec == 0 && lookup_cache(job, &key, result))
+        return;
+
+    if (tp)
+    {
+        tp->deadline = (job->timeout_msec > 0) ?
+                g_get_monotonic_time() + (gint64)job->timeout_msec * 1000 : G_MAXINT64;
+        if (job->interval_msec > 0)
+        {
+            result->ret = run_preview_job(tp, job);
+        }
+        else if (job->count > 0)
+        {
+            result->ret = run_strip_job(tp, job);
+        }
+        else
+        {
+            run_job(tp, job, result);
+            store_cache(key, job, result);
+        }
+        if (NX_GST_RET_OK != result->ret && g_atomic_int_get(&tp->cancelled)) {
+            NXGLOGI("job(%d) cancelled", job->id);
+        }
+    }
+    g_free(key);
+}
+
+static gpointer thumbnail_worker_main(gpointer data)
+{
+    struct ThumbnailWorker *worker = (struct ThumbnailWorker *)data;
+    struct THUMBNAIL_SERVICE *service = worker->service;
+    struct ThumbnailJob *job;
+
+    NXGLOGI("START");
+
+    worker->tp = create_pipeline();
+
+    g_mutex_lock(&service->lock);
+    while (TRUE)
+    {
+        struct THUMBNAIL_RESULT result = { 0, };
+        gboolean hw;
+
+        while (!service->quit && g_queue_is_empty(&service->jobs)) {
+            g_cond_wait(&service->cond, &service->lock);
+        }
+        if (service->quit)
+            break;
+
+        job = (struct ThumbnailJob *)g_queue_pop_head(&service->jobs);
+        worker->job = job;
+        hw = (service->hw_in_use < service->hw_decoders);
+        if (hw) {
+            service->hw_in_use++;
+        }
+        if (worker->tp)
+        {
+            worker->tp->allow_hw = hw;
+            g_atomic_int_set(&worker->tp->cancelled, 0);
+        }
+        g_mutex_unlock(&service->lock);
+
+        run_service_job(worker->tp, job, &result);
+
+        g_mutex_lock(&service->lock);
+        worker->job = NULL;
+        if (hw) {
+            service->hw_in_use--;
+        }
+        g_mutex_unlock(&service->lock);
+
+        complete_job(job, &result);
+
+        g_mutex_lock(&service->lock);
+    }
+    g_mutex_unlock(&service->lock);
+
+    destroy_pipeline(worker->tp);
+
+    NXGLOGI("END");
+
+    return NULL;
+}
+
+// Under the lock of the service, behind the jobs of the same priority
+static void queue_job(struct THUMBNAIL_SERVICE *service, struct ThumbnailJob *job)
+{
+    GList *l;
+
+    for (l = service->jobs.head; l; l = l->next)
+    {
+        if (((struct ThumbnailJob *)l->data)->priority < job->priority)
+            break;
+    }
+    if (l) {
+        g_queue_insert_before(&service->jobs, l, job);
+    } else {
+        g_queue_push_tail(&service->jobs, job);
+    }
+}
+
+static void push_job(struct THUMBNAIL_SERVICE *service, struct ThumbnailJob *job)
+{
+    g_mutex_lock(&service->lock);
+    queue_job(service, job);
+    g_cond_signal(&service->cond);
+    g_mutex_unlock(&service->lock);
+}
+
+TH_HANDLE NX_CreateThumbnailService(gint32 workers, gint32 hw_decoders)
+{
+    struct THUMBNAIL_SERVICE *service = g_new0(struct THUMBNAIL_SERVICE, 1);
+
+    init_gst();
+
+    g_mutex_init(&service->lock);
+    g_cond_init(&service->cond);
+    g_queue_init(&service->jobs);
+    service->n_workers = CLAMP(workers, 1, THUMBNAIL_MAX_WORKERS);
+    service->hw_decoders = CLAMP(hw_decoders, 0, service->n_workers);
+    service->workers = g_new0(struct ThumbnailWorker, service->n_workers);
+
+    NXGLOGI("workers(%d), hw_decoders(%d)", service->n_workers, service->hw_decoders);
+
+    for (gint32 i = 0; i < service->n_workers; i++)
+    {
+        service->workers[i].service = service;
+        service->workers[i].thread = g_thread_new("NxGstThumbnail", thumbnail_worker_main,
+                                                &service->workers[i]);
+    }
+
+    return service;
+}
+
+gint32 NX_RequestThumbnailEx(TH_HANDLE service, const char *uri, gint64 pos_msec,
+                        gint32 width, const char *outPath, gint32 priority,
+                        gint32 timeout_msec, NX_THUMBNAIL_CB callback, void *owner)
+{
+    struct ThumbnailJob *job = g_new0(struct ThumbnailJob, 1);
+    gint32 id = g_atomic_int_add(&service->next_id, 1) + 1;
+
+    job->id = id;
+    job->uri = g_strdup(uri);
+    job->pos_msec = pos_msec;
+    job->width = width;
+    job->outPath = g_strdup(outPath);
+    job->callback = callback;
+    job->owner = owner;
+    job->flags = g_atomic_int_get(&service->flags);
+    job->priority = priority;
+    job->timeout_msec = timeout_msec;
+
+    // The worker may be done with it before this returns
+    push_job(service, job);
+
+    return id;
+}
+
+gint32 NX_RequestThumbnail(TH_HANDLE service, const char *uri, gint64 pos_msec,
+                        gint32 width, const char *outPath,
+                        NX_THUMBNAIL_CB callback, void *owner)
+{
+    return NX_RequestThumbnailEx(service, uri, pos_msec, width, outPath, 0, 0,
+                                callback, owner);
+}
+
+static gint compare_position(gconstpointer a, gconstpointer b, gpointer data)
+{
+    const gint64 *positions = (const gint64 *)data;
+    gint64 pa = positions[*(const gint32 *)a];
+    gint64 pb = positions[*(const gint32 *)b];
+
+    return (pa > pb) - (pa < pb);
+}
+
+gint32 NX_RequestThumbnailStrip(TH_HANDLE service, const char *uri,
+                        const gint64 *pos_msec, gint32 count, gint32 width,
+                        const char *spritePath, NX_THUMBNAIL_CB callback, void *owner)
+{
+    struct ThumbnailJob *job = g_new0(struct ThumbnailJob, 1);
+    gint32 id = g_atomic_int_add(&service->next_id, 1) + 1;
+
+    job->id = id;
+    job->uri = g_strdup(uri);
+    job->width = width;
+    job->outPath = g_strdup(spritePath);
+    job->callback = callback;
+    job->owner = owner;
+    job->flags = g_atomic_int_get(&service->flags);
+    job->count = count;
+
+    // Backward seeks would make the demuxer read the file again
+    job->indexes = g_new(gint32, count);
+    for (gint32 i = 0; i < count; i++) {
+        job->indexes[i] = i;
+    }
+    g_qsort_with_data(job->indexes, count, sizeof(gint32), compare_position, (gpointer)pos_msec);
+    job->positions = g_new(gint64, count);
+    for (gint32 i = 0; i < count; i++) {
+        job->positions[i] = pos_msec[job->indexes[i]];
+    }
+
+    push_job(service, job);
+
+    return id;
+}
+
+gint32 NX_RequestPreviewTrack(TH_HANDLE service, const char *uri, gint32 interval_msec,
+                        gint32 width, const char *trackPath, NX_THUMBNAIL_CB callback,
+                        void *owner)
+{
+    struct ThumbnailJob *job = g_new0(struct ThumbnailJob, 1);
+    gint32 id = g_atomic_int_add(&service->next_id, 1) + 1;
+
+    job->id = id;
+    job->uri = g_strdup(uri);
+    job->width = width;
+    job->outPath = g_strdup(trackPath);
+    job->callback = callback;
+    job->owner = owner;
+    job->flags = g_atomic_int_get(&service->flags);
+    job->interval_msec = interval_msec;
+    job->priority = PREVIEW_PRIORITY;
+
+    push_job(service, job);
+
+    return id;
+}
+
+void NX_SetThumbnailFlags(TH_HANDLE service, gint32 flags)
+{
+    g_atomic_int_set(&service->flags, flags);
+}
+
+gboolean NX_SetThumbnailPriority(TH_HANDLE service, gint32 job_id, gint32 priority)
+{
+    struct ThumbnailJob *job = NULL;
+
+    g_mutex_lock(&service->lock);
+    for (GList *l = service->jobs.head; l; l = l->next)
+    {
+        if (((struct ThumbnailJob *)l->data)->id == job_id)
+        {
+            job = (struct ThumbnailJob *)l->data;
+            g_queue_delete_link(&service->jobs, l);
+            job->priority = priority;
+            queue_job(service, job);
+            break;
+        }
+    }
+    g_mutex_unlock(&service->lock);
+
+    return (NULL != job);
+}
+
+gboolean NX_CancelThumbnail(TH_HANDLE service, gint32 job_id)
+{
+    struct ThumbnailJob *job = NULL;
+    gboolean running = FALSE;
+
+    g_mutex_lock(&service->lock);
+    for (GList *l = service->jobs.head; l; l = l->next)
+    {
+        if (((struct ThumbnailJob *)l->data)->id == job_id)
+        {
+            job = (struct ThumbnailJob *)l->data;
+            g_queue_delete_link(&service->jobs, l);
+            break;
+        }
+    }
+    for (gint32 i = 0; NULL == job && i < service->n_workers; i++)
+    {
+        struct ThumbnailWorker *worker = &service->workers[i];
+
+        // Stops at its next wait, which then times out at once
+        if (worker->job && worker->job->id == job_id && worker->tp)
+        {
+            g_atomic_int_set(&worker->tp->cancelled, 1);
+            running = TRUE;
+        }
+    }
+    g_mutex_unlock(&service->lock);
+
+    if (job)
+    {
+        struct THUMBNAIL_RESULT result = { 0, };
+
+        result.ret = NX_GST_RET_ERROR;
+        result.pos_msec = -1;
+        complete_job(job, &result);
+    }
+
+    return (job || running);
+}
+
+/* The jobs in progress are finished, the ones still queued are completed with
+ * NX_GST_RET_ERROR so that their owners get the callback in any case. */
+void NX_DestroyThumbnailService(TH_HANDLE service)
+{
+    struct ThumbnailJob *job;
+
+    if (NULL == service)
+        return;
+
+    g_mutex_lock(&service->lock);
+    service->quit = TRUE;
+    g_cond_broadcast(&service->cond);
+    g_mutex_unlock(&service->lock);
+
+    for (gint32 i = 0; i < service->n_workers; i++) {
+        g_thread_join(service->workers[i].thread);
+    }
+
+    while (NULL != (job = (struct ThumbnailJob *)g_queue_pop_head(&service->jobs)))
+    {
+        struct THUMBNAIL_RESULT result = { 0, };
+
+        result.ret = NX_GST_RET_ERROR;
+        result.pos_msec = -1;
+        complete_job(job, &result);
+    }
+    g_free(service->workers);
+    NX_FlushThumbnailCache();
+    g_cond_clear(&service->cond);
+    g_mutex_clear(&service->lock);
+    g_free(service);
+}
@@ -26,7 +26,46 @@
 extern "C" {
 #endif	//	__cplusplus
 
-NX_GST_RET makeThumbnail(const char *uri, int64_t pos_msec, int32_t width, const char *outPath);
+// 'flags' is a combination of THUMBNAIL_FLAG, 'pResult' can be NULL
+NX_GST_RET makeThumbnail(const char *uri, int64_t pos_msec, int32_t width, const char *outPath,
+                        int32_t flags, struct THUMBNAIL_RESULT *pResult);
+// Same as makeThumbnail() into 'pBuffer', without any file
+NX_GST_RET makeThumbnailToBuffer(const char *uri, int64_t pos_msec, int32_t width,
+                        int32_t flags, struct THUMBNAIL_BUFFER *pBuffer,
+                        struct THUMBNAIL_RESULT *pResult);
+
+/* Thumbnail jobs processed by 'workers' threads (1 to 8), by priority then in
+ * request order. Each worker keeps its pipeline between the jobs. At most
+ * 'hw_decoders' jobs run at once on the hardware decoder, the others decode
+ * in software. The callback of a job is called from its worker thread. */
+TH_HANDLE NX_CreateThumbnailService(gint32 workers, gint32 hw_decoders);
+/* Returns the job id, passed back in THUMBNAIL_RESULT. Higher 'priority'
+ * runs first. The job fails once it has run 'timeout_msec', 0 for no limit. */
+gint32 NX_RequestThumbnailEx(TH_HANDLE service, const char *uri, gint64 pos_msec,
+                        gint32 width, const char *outPath, gint32 priority,
+                        gint32 timeout_msec, NX_THUMBNAIL_CB callback, void *owner);
+// NX_RequestThumbnailEx() of priority 0 without timeout
+gint32 NX_RequestThumbnail(TH_HANDLE service, const char *uri, gint64 pos_msec,
+                        gint32 width, const char *outPath,
+                        NX_THUMBNAIL_CB callback, void *owner);
+/* One frame per position, sent to the callback one by one (with their
+ * index in 'pos_msec') before the completion of the job. */
+gint32 NX_RequestThumbnailStrip(TH_HANDLE service, const char *uri,
+                        const gint64 *pos_msec, gint32 count, gint32 width,
+                        const char *spritePath, NX_THUMBNAIL_CB callback, void *owner);
+/* Preview track of the file, one image every 'interval_msec', see
+ * NX_GstPreviewTrack.h. Queued behind the thumbnails of priority 0. */
+gint32 NX_RequestPreviewTrack(TH_HANDLE service, const char *uri, gint32 interval_msec,
+                        gint32 width, const char *trackPath, NX_THUMBNAIL_CB callback,
+                        void *owner);
+// THUMBNAIL_FLAG of the jobs requested afterwards
+void NX_SetThumbnailFlags(TH_HANDLE service, gint32 flags);
+// FALSE if the job is not queued anymore
+gboolean NX_SetThumbnailPriority(TH_HANDLE service, gint32 job_id, gint32 priority);
+/* A queued job is completed with NX_GST_RET_ERROR at once, a running one
+ * stops at its next wait. FALSE if the job is already completed. */
+gboolean NX_CancelThumbnail(TH_HANDLE service, gint32 job_id);
+void NX_DestroyThumbnailService(TH_HANDLE service);
 
 #ifdef __cplusplus
 }
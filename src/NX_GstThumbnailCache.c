@@ -0,0 +1,467 @@
+//------------------------------------------------------------------------------
+//
+//	Copyright (C) 2015 Nexell Co. All Rights Reserved
+//	Nexell Co. Proprietary & Confidential
+//
+//	NEXELL INFORMS THAT THIS CODE AND INFORMATION IS PROVIDED "AS IS" BASE
+//  AND	WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING
+//  BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS
+//  FOR A PARTICULAR PURPOSE.
+//
+//	Module		: libnxgstvplayer.so
+//	File		: NX_GstThumbnailCache.c
+//	Description	: Cache of the encoded thumbnails, in memory and on disk
+//	Author		:
+//	Export		:
+//	History		:
+//
+//------------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "NX_GstThumbnailCache.h"
+#include "NX_GstLog.h"
+#define LOG_TAG "[NX_GstThumbnailCache]"
+
+// In the cache directory, next to the files named after their key
+#define CACHE_INDEX_NAME    "index"
+#define CACHE_INDEX_MAGIC   "nxthumbcache 1"
+// A changed index is written at most this often, and at exit
+#define INDEX_SAVE_DELAY    (10 * G_USEC_PER_SEC)
+
+struct CacheEntry {
+    gchar   *key;
+    gsize   size;
+    gint64  pos_msec;
+    gint32  retries;
+    // Memory tier only, the encoded thumbnail
+    GBytes  *data;
+    // In the lru queue of the tier
+    GList   *link;
+};
+
+struct CacheTier {
+    // key -> struct CacheEntry, NULL if the tier is disabled
+    GHashTable  *entries;
+    // Most recently used first
+    GQueue      lru;
+    guint64     size;
+    guint64     max_size;
+};
+
+static GMutex cache_lock;
+static gchar *cache_dir;
+static struct CacheTier memory_tier;
+static struct CacheTier disk_tier;
+// The lru order of the disk tier changed since the index was written, at
+// index_dirty_since in monotonic time
+static gboolean index_dirty;
+static gint64 index_dirty_since;
+
+static void free_entry(gpointer data)
+{
+    struct CacheEntry *entry = (struct CacheEntry *)data;
+
+    g_free(entry->key);
+    if (entry->data) {
+        g_bytes_unref(entry->data);
+    }
+    g_free(entry);
+}
+
+static void tier_init(struct CacheTier *tier, guint64 max_size)
+{
+    tier->entries = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, free_entry);
+    g_queue_init(&tier->lru);
+    tier->size = 0;
+    tier->max_size = max_size;
+}
+
+static void tier_clear(struct CacheTier *tier)
+{
+    if (NULL == tier->entries)
+        return;
+
+    g_queue_clear(&tier->lru);
+    g_hash_table_destroy(tier->entries);
+    tier->entries = NULL;
+    tier->size = 0;
+}
+
+static struct CacheEntry *tier_find(struct CacheTier *tier, const gchar *key)
+{
+    struct CacheEntry *entry;
+
+    if (NULL == tier->entries)
+        return NULL;
+
+    entry = (struct CacheEntry *)g_hash_table_lookup(tier->entries, key);
+    if (entry)
+    {
+        g_queue_unlink(&tier->lru, entry->link);
+        g_queue_push_head_link(&tier->lru, entry->link);
+    }
+    return entry;
+}
+
+static void tier_remove(struct CacheTier *tier, struct CacheEntry *entry)
+{
+    g_queue_delete_link(&tier->lru, entry->link);
+    tier->size -= entry->size;
+    // Frees the entry
+    g_hash_table_remove(tier->entries, entry->key);
+}
+
+// The most recently used, or the least with 'tail'
+static void tier_insert(struct CacheTier *tier, struct CacheEntry *entry, gboolean tail)
+{
+    struct CacheEntry *old;
+
+    old = (struct CacheEntry *)g_hash_table_lookup(tier->entries, entry->key);
+    if (old) {
+        tier_remove(tier, old);
+    }
+
+    g_hash_table_insert(tier->entries, entry->key, entry);
+    if (tail) {
+        g_queue_push_tail(&tier->lru, entry);
+        entry->link = g_queue_peek_tail_link(&tier->lru);
+    } else {
+        g_queue_push_head(&tier->lru, entry);
+        entry->link = g_queue_peek_head_link(&tier->lru);
+    }
+    tier->size += entry->size;
+}
+
+static void mark_index_dirty(void)
+{
+    if (!index_dirty)
+    {
+        index_dirty = TRUE;
+        index_dirty_since = g_get_monotonic_time();
+    }
+}
+
+static gchar *entry_path(const gchar *key)
+{
+    return g_build_filename(cache_dir, key, NULL);
+}
+
+static void evict(struct CacheTier *tier)
+{
+    struct CacheEntry *entry;
+    gchar *path;
+
+    while (tier->size > tier->max_size &&
+        NULL != (entry = (struct CacheEntry *)g_queue_peek_tail(&tier->lru)))
+    {
+        if (tier == &disk_tier)
+        {
+            path = entry_path(entry->key);
+            g_unlink(path);
+            g_free(path);
+            mark_index_dirty();
+        }
+        tier_remove(tier, entry);
+    }
+}
+
+/* One line per entry, most recently used first:
+ *   <key> <size> <pos_msec> <retries> */
+static void load_index(void)
+{
+    gchar *path = g_build_filename(cache_dir, CACHE_INDEX_NAME, NULL);
+    gchar *contents = NULL;
+    gchar **lines;
+    struct CacheEntry *entry;
+    gchar key[65];
+    guint64 size;
+    gint64 pos_msec;
+    gint32 retries;
+
+    if (!g_file_get_contents(path, &contents, NULL, NULL))
+    {
+        g_free(path);
+        return;
+    }
+    g_free(path);
+
+    lines = g_strsplit(contents, "\n", -1);
+    g_free(contents);
+    if (NULL == lines[0] || strcmp(lines[0], CACHE_INDEX_MAGIC))
+    {
+        NXGLOGW("Unknown index, the cache starts empty");
+        g_strfreev(lines);
+        return;
+    }
+
+    for (gint i = 1; lines[i]; i++)
+    {
+        if (4 != sscanf(lines[i], "%64s %" G_GUINT64_FORMAT " %" G_GINT64_FORMAT " %d",
+                        key, &size, &pos_msec, &retries))
+        {
+            continue;
+        }
+        entry = g_new0(struct CacheEntry, 1);
+        entry->key = g_strdup(key);
+        entry->size = (gsize)size;
+        entry->pos_msec = pos_msec;
+        entry->retries = retries;
+        tier_insert(&disk_tier, entry, TRUE);
+    }
+    g_strfreev(lines);
+
+    NXGLOGI("%u thumbnails, %" G_GUINT64_FORMAT " bytes in %s",
+            g_hash_table_size(disk_tier.entries), disk_tier.size, cache_dir);
+}
+
+static void save_index(void)
+{
+    gchar *path = g_build_filename(cache_dir, CACHE_INDEX_NAME, NULL);
+    GString *str = g_string_new(CACHE_INDEX_MAGIC "\n");
+    GError *error = NULL;
+
+    for (GList *l = disk_tier.lru.head; l; l = l->next)
+    {
+        struct CacheEntry *entry = (struct CacheEntry *)l->data;
+
+        g_string_append_printf(str, "%s %" G_GSIZE_FORMAT " %" G_GINT64_FORMAT " %d\n",
+                            entry->key, entry->size, entry->pos_msec, entry->retries);
+    }
+
+    // Written to a temporary file then renamed, a crash leaves the old index
+    if (!g_file_set_contents(path, str->str, str->len, &error))
+    {
+        NXGLOGE("Failed to write %s: %s", path, error->message);
+        g_clear_error(&error);
+    }
+    else
+    {
+        index_dirty = FALSE;
+    }
+    g_string_free(str, TRUE);
+    g_free(path);
+}
+
+// Under cache_lock, once the index has been changed for INDEX_SAVE_DELAY
+static void save_index_later(void)
+{
+    if (index_dirty && g_get_monotonic_time() - index_dirty_since >= INDEX_SAVE_DELAY) {
+        save_index();
+    }
+}
+
+void NX_FlushThumbnailCache(void)
+{
+    g_mutex_lock(&cache_lock);
+    if (disk_tier.entries && index_dirty) {
+        save_index();
+    }
+    g_mutex_unlock(&cache_lock);
+}
+
+/* At exit and when the library is unloaded, so that a session of cache hits
+ * only saves its lru order too. An atexit() handler would be called after
+ * a dlclose(), with the library unmapped. */
+static void __attribute__((destructor)) flush_at_unload(void)
+{
+    NX_FlushThumbnailCache();
+}
+
+void NX_ConfigureThumbnailCache(const gchar *dir, gint64 max_disk_bytes,
+                                gint64 max_memory_bytes)
+{
+    g_mutex_lock(&cache_lock);
+
+    if (disk_tier.entries && index_dirty) {
+        save_index();
+    }
+    tier_clear(&disk_tier);
+    tier_clear(&memory_tier);
+    g_free(cache_dir);
+    cache_dir = NULL;
+
+    if (max_memory_bytes > 0) {
+        tier_init(&memory_tier, (guint64)max_memory_bytes);
+    }
+    if (dir && max_disk_bytes > 0)
+    {
+        if (0 != g_mkdir_with_parents(dir, 0755))
+        {
+            NXGLOGE("Failed to create %s", dir);
+        }
+        else
+        {
+            cache_dir = g_strdup(dir);
+            tier_init(&disk_tier, (guint64)max_disk_bytes);
+            load_index();
+            evict(&disk_tier);
+            if (index_dirty) {
+                save_index();
+            }
+        }
+    }
+
+    NXGLOGI("dir(%s), max_disk_bytes(%" G_GINT64_FORMAT "), max_memory_bytes(%"
+            G_GINT64_FORMAT ")", cache_dir ? cache_dir : "none", max_disk_bytes,
+            max_memory_bytes);
+
+    g_mutex_unlock(&cache_lock);
+}
+
+gchar *NX_ThumbnailCacheKey(const gchar *path, gint64 pos_msec, gint32 width,
+                            gint32 flags, const gchar *outPath)
+{
+    gboolean enabled;
+    struct stat st;
+    gchar *identity, *key;
+
+    g_mutex_lock(&cache_lock);
+    enabled = (memory_tier.entries || disk_tier.entries);
+    g_mutex_unlock(&cache_lock);
+
+    if (!enabled || !path || !outPath || 0 != stat(path, &st))
+        return NULL;
+
+    // Same rule as NX_SaveCapturedFrame() for the format
+    identity = g_strdup_printf("%" G_GUINT64_FORMAT ":%" G_GUINT64_FORMAT ":%" G_GINT64_FORMAT
+                    ":%" G_GINT64_FORMAT ".%09ld|%" G_GINT64_FORMAT "|%d|0x%x|%s",
+                    (guint64)st.st_dev, (guint64)st.st_ino, (gint64)st.st_size,
+                    (gint64)st.st_mtim.tv_sec, (long)st.st_mtim.tv_nsec,
+                    pos_msec, width, flags,
+                    g_str_has_suffix(outPath, ".png") ? "png" : "jpeg");
+    key = g_compute_checksum_for_string(G_CHECKSUM_SHA256, identity, -1);
+    g_free(identity);
+
+    return key;
+}
+
+gboolean NX_LookupThumbnailCache(const gchar *key, const gchar *outPath,
+                                struct THUMBNAIL_RESULT *result)
+{
+    struct CacheEntry *entry, *copy;
+    GBytes *data = NULL;
+    gchar *path, *contents;
+    gsize size;
+    GError *error = NULL;
+    gboolean res;
+
+    g_mutex_lock(&cache_lock);
+
+    if (NULL != (entry = tier_find(&memory_tier, key)))
+    {
+        data = g_bytes_ref(entry->data);
+    }
+    else if (NULL != (entry = tier_find(&disk_tier, key)))
+    {
+        mark_index_dirty();
+        path = entry_path(key);
+        if (!g_file_get_contents(path, &contents, &size, NULL))
+        {
+            NXGLOGW("%s is gone", path);
+            tier_remove(&disk_tier, entry);
+            entry = NULL;
+        }
+        else
+        {
+            data = g_bytes_new_take(contents, size);
+            // Promoted to the memory tier
+            save_index_later();
+            if (memory_tier.entries)
+            {
+                copy = g_new0(struct CacheEntry, 1);
+                copy->key = g_strdup(key);
+                copy->size = size;
+                copy->pos_msec = entry->pos_msec;
+                copy->retries = entry->retries;
+                copy->data = g_bytes_ref(data);
+                tier_insert(&memory_tier, copy, FALSE);
+                evict(&memory_tier);
+            }
+        }
+        g_free(path);
+    }
+    if (entry)
+    {
+        result->pos_msec = entry->pos_msec;
+        result->retries = entry->retries;
+    }
+
+    g_mutex_unlock(&cache_lock);
+
+    if (NULL == data)
+        return FALSE;
+
+    res = g_file_set_contents(outPath, (const gchar *)g_bytes_get_data(data, NULL),
+                            g_bytes_get_size(data), &error);
+    if (!res)
+    {
+        NXGLOGE("Failed to write %s: %s", outPath, error->message);
+        g_clear_error(&error);
+    }
+    g_bytes_unref(data);
+
+    return res;
+}
+
+void NX_StoreThumbnailCache(const gchar *key, const gchar *outPath,
+                            const struct THUMBNAIL_RESULT *result)
+{
+    struct CacheEntry *entry;
+    gchar *contents, *path;
+    gsize size;
+    GBytes *data;
+
+    // Read back, it is small and still in the page cache
+    if (!g_file_get_contents(outPath, &contents, &size, NULL))
+        return;
+    data = g_bytes_new_take(contents, size);
+
+    g_mutex_lock(&cache_lock);
+
+    if (memory_tier.entries && size <= memory_tier.max_size)
+    {
+        entry = g_new0(struct CacheEntry, 1);
+        entry->key = g_strdup(key);
+        entry->size = size;
+        entry->pos_msec = result->pos_msec;
+        entry->retries = result->retries;
+        entry->data = g_bytes_ref(data);
+        tier_insert(&memory_tier, entry, FALSE);
+        evict(&memory_tier);
+    }
+
+    if (disk_tier.entries && size <= disk_tier.max_size)
+    {
+        path = entry_path(key);
+        if (g_file_set_contents(path, contents, size, NULL))
+        {
+            entry = g_new0(struct CacheEntry, 1);
+            entry->key = g_strdup(key);
+            entry->size = size;
+            entry->pos_msec = result->pos_msec;
+            entry->retries = result->retries;
+            tier_insert(&disk_tier, entry, FALSE);
+            evict(&disk_tier);
+            mark_index_dirty();
+            save_index_later();
+        }
+        else
+        {
+            NXGLOGE("Failed to write %s", path);
+        }
+        g_free(path);
+    }
+
+    g_mutex_unlock(&cache_lock);
+
+    g_bytes_unref(data);
+}
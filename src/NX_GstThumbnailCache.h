@@ -0,0 +1,65 @@
+//------------------------------------------------------------------------------
+//
+//	Copyright (C) 2015 Nexell Co. All Rights Reserved
+//	Nexell Co. Proprietary & Confidential
+//
+//	NEXELL INFORMS THAT THIS CODE AND INFORMATION IS PROVIDED "AS IS" BASE
+//  AND	WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING
+//  BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS
+//  FOR A PARTICULAR PURPOSE.
+//
+//	Module		: libnxgstvplayer.so
+//	File		: NX_GstThumbnailCache.h
+//	Description	: Cache of the encoded thumbnails, in memory and on disk
+//	Author		:
+//	Export		:
+//	History		:
+//
+//------------------------------------------------------------------------------
+
+#ifndef __NX_GSTTHUMBNAILCACHE_H
+#define __NX_GSTTHUMBNAILCACHE_H
+
+#include <glib.h>
+#include "NX_GstTypes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif	//	__cplusplus
+
+/*
+ * Thumbnails are kept as their encoded file, keyed by a hash of the identity
+ * of the source file (device, inode, size, mtime) and of the request
+ * (position, width, flags, image format). A renamed file still hits, a
+ * modified one misses.
+ * The memory tier is an LRU of at most 'max_memory_bytes'. The disk tier
+ * holds at most 'max_disk_bytes' in 'dir', listed from the most recently
+ * used in the index file of 'dir', so that eviction never scans the
+ * directory. A NULL 'dir' or a 0 size disables a tier, the cache is
+ * disabled until configured.
+ */
+void NX_ConfigureThumbnailCache(const gchar *dir, gint64 max_disk_bytes,
+                                gint64 max_memory_bytes);
+
+// Returns NULL if the cache is disabled or 'path' cannot be read
+gchar *NX_ThumbnailCacheKey(const gchar *path, gint64 pos_msec, gint32 width,
+                            gint32 flags, const gchar *outPath);
+
+/* On a hit, writes the thumbnail to 'outPath' and sets 'pos_msec' and
+ * 'retries' of 'result' as they were when it was made */
+gboolean NX_LookupThumbnailCache(const gchar *key, const gchar *outPath,
+                                struct THUMBNAIL_RESULT *result);
+
+// Adds the thumbnail just written to 'outPath'
+void NX_StoreThumbnailCache(const gchar *key, const gchar *outPath,
+                            const struct THUMBNAIL_RESULT *result);
+
+/* Writes the index if it changed. It is otherwise written at most every few
+ * seconds, on reconfiguration and at exit. */
+void NX_FlushThumbnailCache(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __NX_GSTTHUMBNAILCACHE_H
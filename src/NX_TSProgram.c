@@ -32,6 +32,7 @@
 #include <gst/gst.h>
 #include <gst/mpegts/mpegts.h>
 #include "NX_TypeFind.h"
+#include "NX_GstLoopPool.h"
 #include "NX_GstLog.h"
 #define LOG_TAG "[NX_TSProgram]"
 
@@ -1887,6 +1888,7 @@ gint
 get_program_info(const char* filePath, struct GST_MEDIA_INFO *media_info)
 {
 	GMainContext *worker_context;
+	guint bus_watch_id;
 	GError *error = NULL;
 	gboolean ret = FALSE;
 	MpegTsSt handle;
@@ -1910,8 +1912,7 @@ get_program_info(const char* filePath, struct GST_MEDIA_INFO *media_info)
 	// init mpegts library
 	gst_mpegts_initialize();
 
-	worker_context = g_main_context_new();
-	g_main_context_push_thread_default(worker_context);
+	worker_context = NX_AcquireProbeContext();
 	handle.loop = g_main_loop_new (worker_context, FALSE);
 
 	//  gst-launch-1.0 -v filesrc location=/tmp/media/sda1/VIDEO_MPEG2/bbc010906.ts ! tsdemux name=demux demux. ! queue !  decodebin ! typefind ! fakesink
@@ -1920,7 +1921,7 @@ get_program_info(const char* filePath, struct GST_MEDIA_INFO *media_info)
 
 	/* Put a bus handler */
 	handle.bus = gst_pipeline_get_bus (GST_PIPELINE (handle.pipeline));
-	gst_bus_add_watch (handle.bus, (GCallback) on_bus_message_program, &handle);
+	bus_watch_id = gst_bus_add_watch (handle.bus, (GstBusFunc) on_bus_message_program, &handle);
 	gst_object_unref (GST_OBJECT (handle.bus));
 
 	handle.filesrc = gst_element_factory_make ("filesrc", "source");
@@ -1987,9 +1988,8 @@ get_program_info(const char* filePath, struct GST_MEDIA_INFO *media_info)
     gst_element_set_state (GST_ELEMENT (handle.pipeline), GST_STATE_NULL);
     gst_object_unref (GST_OBJECT (handle.pipeline));
 
+	NX_ReleaseProbeContext(worker_context, bus_watch_id);
 	g_main_loop_unref(handle.loop);
-	g_main_context_pop_thread_default(worker_context);
-	g_main_context_unref(worker_context);
 
 	FUNC_OUT();
 	return 0;
@@ -2037,8 +2037,7 @@ get_stream_simple_info(const char* filePath, gint program_number, struct GST_MED
 
 	handle.program_index = get_program_index(media_info, program_number);
 
-	worker_context = g_main_context_new();
-	g_main_context_push_thread_default(worker_context);
+	worker_context = NX_AcquireProbeContext();
 	handle.loop = g_main_loop_new (worker_context, FALSE);
 
 	// Create elements & set program-number to tsdemux
@@ -2112,11 +2111,11 @@ get_stream_simple_info(const char* filePath, gint program_number, struct GST_MED
 
 	// unset
     gst_element_set_state (GST_ELEMENT (handle.pipeline), GST_STATE_NULL);
+    gst_bus_remove_signal_watch (handle.bus);
     gst_object_unref (GST_OBJECT (handle.pipeline));
 
+	NX_ReleaseProbeContext(worker_context, 0);
 	g_main_loop_unref(handle.loop);
-	g_main_context_pop_thread_default(worker_context);
-	g_main_context_unref(worker_context);
 
 	FUNC_OUT();
 	return 0;
@@ -2164,8 +2163,7 @@ get_video_stream_details_info(const char* filePath,
 	// init mpegts library
 	gst_mpegts_initialize();
 
-	worker_context = g_main_context_new();
-	g_main_context_push_thread_default(worker_context);
+	worker_context = NX_AcquireProbeContext();
 	handle.loop = g_main_loop_new (worker_context, FALSE);
 
 	// Create elements & set program-number to tsdemux
@@ -2239,11 +2237,11 @@ get_video_stream_details_info(const char* filePath,
 
 	// unset
     gst_element_set_state (GST_ELEMENT (handle.pipeline), GST_STATE_NULL);
+    gst_bus_remove_signal_watch (handle.bus);
     gst_object_unref (GST_OBJECT (handle.pipeline));
 
+	NX_ReleaseProbeContext(worker_context, 0);
 	g_main_loop_unref(handle.loop);
-	g_main_context_pop_thread_default(worker_context);
-	g_main_context_unref(worker_context);
 
 	FUNC_OUT();
 
@@ -2276,8 +2274,7 @@ get_audio_stream_detail_info(const char* filePath, gint program_number, gint aud
 	// init mpegts library
 	gst_mpegts_initialize();
 
-	worker_context = g_main_context_new();
-	g_main_context_push_thread_default(worker_context);
+	worker_context = NX_AcquireProbeContext();
 	handle.loop = g_main_loop_new (worker_context, FALSE);
 
 	// Create elements & set program-number to tsdemux
@@ -2351,11 +2348,11 @@ get_audio_stream_detail_info(const char* filePath, gint program_number, gint aud
 
 	// unset
     gst_element_set_state (GST_ELEMENT (handle.pipeline), GST_STATE_NULL);
+    gst_bus_remove_signal_watch (handle.bus);
     gst_object_unref (GST_OBJECT (handle.pipeline));
 
+	NX_ReleaseProbeContext(worker_context, 0);
 	g_main_loop_unref(handle.loop);
-	g_main_context_pop_thread_default(worker_context);
-	g_main_context_unref(worker_context);
 
 	FUNC_OUT();
 
@@ -3,6 +3,7 @@
 
 #include "NX_OMXSemaphore.h"
 #include "NX_TypeFind.h"
+#include "NX_GstLoopPool.h"
 #include "NX_GstLog.h"
 #define LOG_TAG "[NX_TypeFind]"
 
@@ -510,11 +511,11 @@ int typefind_codec_info(struct GST_MEDIA_INFO *media_handle, const char *uri,
 	gint demux_type = 0;
 	TypeFindSt handle;
 	GMainContext *worker_context;
+	guint bus_watch_id;
 
     NXGLOGI("START");
 
-	worker_context = g_main_context_new();
-	g_main_context_push_thread_default(worker_context);
+	worker_context = NX_AcquireProbeContext();
 	handle.loop = g_main_loop_new (worker_context, FALSE);
 
 	handle.media_info = media_handle;
@@ -535,7 +536,7 @@ int typefind_codec_info(struct GST_MEDIA_INFO *media_handle, const char *uri,
 	handle.pipeline = gst_pipeline_new ("pipe");
 
 	handle.bus = gst_pipeline_get_bus ( (handle.pipeline));
-	gst_bus_add_watch (handle.bus, bus_callback, &handle);
+	bus_watch_id = gst_bus_add_watch (handle.bus, bus_callback, &handle);
 	gst_object_unref (GST_OBJECT (handle.bus));
 
 	// create filesrc
@@ -601,6 +602,9 @@ int typefind_codec_info(struct GST_MEDIA_INFO *media_handle, const char *uri,
 	else if (STREAM_TYPE_SUBTITLE == stream_type)
 	{
 		NXGLOGI("TODO: subtitle");
+		gst_object_unref (GST_OBJECT (handle.pipeline));
+		NX_ReleaseProbeContext(worker_context, bus_watch_id);
+		g_main_loop_unref(handle.loop);
 		return 0;
 	}
 
@@ -722,7 +726,10 @@ int typefind_codec_info(struct GST_MEDIA_INFO *media_handle, const char *uri,
 		{
 			// TODO:
 			NXGLOGI("TODO: subtitle");
-			return;
+			gst_object_unref (GST_OBJECT (handle.pipeline));
+			NX_ReleaseProbeContext(worker_context, bus_watch_id);
+			g_main_loop_unref(handle.loop);
+			return 0;
 		}
 	}
 
@@ -733,9 +740,8 @@ int typefind_codec_info(struct GST_MEDIA_INFO *media_handle, const char *uri,
     gst_element_set_state (GST_ELEMENT (handle.pipeline), GST_STATE_NULL);
     gst_object_unref (GST_OBJECT (handle.pipeline));
 
+	NX_ReleaseProbeContext(worker_context, bus_watch_id);
 	g_main_loop_unref(handle.loop);
-	g_main_context_pop_thread_default(worker_context);
-	g_main_context_unref(worker_context);
 
 	NXGLOGI("END");
 
@@ -1012,6 +1018,7 @@ gint
 typefind_demux(struct GST_MEDIA_INFO *media_handle, const char* filePath)
 {
     TypeFindSt handle;
+    guint bus_watch_id;
 
 	NXGLOGI("START");
 
@@ -1027,15 +1034,14 @@ typefind_demux(struct GST_MEDIA_INFO *media_handle, const char* filePath)
 #ifdef USE_SEMAPHORE
 	handle.sem = NX_CreateSem( 0, 1 );
 #else
-	handle.typefind_context = g_main_context_new();
-	g_main_context_push_thread_default(handle.typefind_context);
+	handle.typefind_context = NX_AcquireProbeContext();
 	handle.loop = g_main_loop_new (handle.typefind_context, FALSE);
 #endif
     // Create a new pipeline to hold the elements
     handle.pipeline = gst_pipeline_new("pipe");
 
     handle.bus = gst_pipeline_get_bus (GST_PIPELINE (handle.pipeline));
-    gst_bus_add_watch (handle.bus, bus_callback, &handle);
+    bus_watch_id = gst_bus_add_watch (handle.bus, bus_callback, &handle);
     gst_object_unref (GST_OBJECT (handle.bus));
 
     // Create file source and typefind element
@@ -1069,9 +1075,8 @@ typefind_demux(struct GST_MEDIA_INFO *media_handle, const char* filePath)
 #ifdef USE_SEMAPHORE
 	NX_DestroySem( handle.sem );
 #else
+	NX_ReleaseProbeContext(handle.typefind_context, bus_watch_id);
 	g_main_loop_unref(handle.loop);
-	g_main_context_pop_thread_default(handle.typefind_context);
-	g_main_context_unref(handle.typefind_context);
 #endif
     NXGLOGI("END");
 
@@ -1161,12 +1166,12 @@ int get_stream_num_type(struct GST_MEDIA_INFO *media_handle, const char *filePat
 	gint ret = 0;
 	gint demux_type = 0;
 	GMainContext *worker_context;
+	guint bus_watch_id;
     TypeFindSt handle;
 
 	NXGLOGI("START");
 
-	worker_context = g_main_context_new();
-	g_main_context_push_thread_default(worker_context);
+	worker_context = NX_AcquireProbeContext();
 	handle.loop = g_main_loop_new (worker_context, FALSE);
 
 	handle.media_info = media_handle;
@@ -1176,7 +1181,7 @@ int get_stream_num_type(struct GST_MEDIA_INFO *media_handle, const char *filePat
 	handle.pipeline = gst_pipeline_new ("pipe");
 
 	handle.bus = gst_pipeline_get_bus (GST_PIPELINE (handle.pipeline));
-	gst_bus_add_watch (handle.bus, bus_callback, &handle);
+	bus_watch_id = gst_bus_add_watch (handle.bus, bus_callback, &handle);
 	gst_object_unref (GST_OBJECT (handle.bus));
 
 	// create file source and typefind element
@@ -1197,6 +1202,9 @@ int get_stream_num_type(struct GST_MEDIA_INFO *media_handle, const char *filePat
 		handle.demux = gst_element_factory_make ("tsdemux", "demux");
 	} else {
 		NXGLOGE("Not supported demux_type(%d)", demux_type);
+		gst_object_unref (GST_OBJECT (handle.pipeline));
+		NX_ReleaseProbeContext(worker_context, bus_watch_id);
+		g_main_loop_unref(handle.loop);
 		return -1;
 	}	
 
@@ -1251,9 +1259,8 @@ int get_stream_num_type(struct GST_MEDIA_INFO *media_handle, const char *filePat
     gst_element_set_state (GST_ELEMENT (handle.pipeline), GST_STATE_NULL);
     gst_object_unref (GST_OBJECT (handle.pipeline));
 
+	NX_ReleaseProbeContext(worker_context, bus_watch_id);
 	g_main_loop_unref(handle.loop);
-	g_main_context_pop_thread_default(worker_context);
-	g_main_context_unref(worker_context);
 
     NXGLOGI("END");
 
@@ -1401,20 +1408,20 @@ int find_avcodec_num_ps(struct GST_MEDIA_INFO *media_handle, const char *filePat
 	gint ret = 0;
 	TypeFindSt handle;
 	GMainContext *worker_context;
+	guint bus_watch_id;
 
 	FUNC_IN();
 
 	handle.media_info = media_handle;
 
-	worker_context = g_main_context_new();
-	g_main_context_push_thread_default(worker_context);
+	worker_context = NX_AcquireProbeContext();
 	handle.loop = g_main_loop_new (worker_context, FALSE);
 
 	// Create a new pipeline to hold the elements
 	handle.pipeline = gst_pipeline_new ("pipe");
 
 	handle.bus = gst_pipeline_get_bus (GST_PIPELINE (handle.pipeline));
-	gst_bus_add_watch (handle.bus, bus_callback, NULL);
+	bus_watch_id = gst_bus_add_watch (handle.bus, bus_callback, NULL);
 	gst_object_unref (GST_OBJECT (handle.bus));
 
 	// Create elements
@@ -1464,9 +1471,8 @@ int find_avcodec_num_ps(struct GST_MEDIA_INFO *media_handle, const char *filePat
     gst_element_set_state (GST_ELEMENT (handle.pipeline), GST_STATE_NULL);
     gst_object_unref (GST_OBJECT (handle.pipeline));
 
+	NX_ReleaseProbeContext(worker_context, bus_watch_id);
 	g_main_loop_unref(handle.loop);
-	g_main_context_pop_thread_default(worker_context);
-	g_main_context_unref(worker_context);
 
 	FUNC_OUT();
 
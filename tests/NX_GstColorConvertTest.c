@@ -0,0 +1,311 @@
+//------------------------------------------------------------------------------
+//
+//	Copyright (C) 2015 Nexell Co. All Rights Reserved
+//	Nexell Co. Proprietary & Confidential
+//
+//	NEXELL INFORMS THAT THIS CODE AND INFORMATION IS PROVIDED "AS IS" BASE
+//  AND	WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING
+//  BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS
+//  FOR A PARTICULAR PURPOSE.
+//
+//	Module		: libnxgstvplayer.so
+//	File		: NX_GstColorConvertTest.c
+//	Description	: Compares the SIMD color kernels with the plain C ones
+//	Author		:
+//	Export		:
+//	History		:
+//
+//------------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <glib.h>
+
+#include "NX_GstColorConvert.h"
+
+// automake treats this exit status as a skipped test
+#define EXIT_SKIP           77
+
+#define DEFAULT_PICTURES    200
+#define MAX_WIDTH           1100
+#define MAX_HEIGHT          300
+#define MAX_PAD             37
+// Written around the outputs to catch the kernels writing past a row
+#define GUARD_BYTE          0xA5
+
+typedef enum {
+    YUV_I420,
+    YUV_YV12,
+    YUV_NV12,
+    YUV_NV21,
+    YUV_FORMAT_NUM
+} YUV_FORMAT;
+
+static const char *yuv_format_name[YUV_FORMAT_NUM] = {
+    "I420", "YV12", "NV12", "NV21"
+};
+
+static const char *rgb_format_name[] = {
+    "RGB888", "RGB565", "ARGB8888"
+};
+
+struct Picture {
+    NX_YUV_PLANES   planes;
+    guint8          *data;
+};
+
+static gint random_size(GRand *rand, gint max)
+{
+    // Small sizes are where the tails of the SIMD loops are
+    switch (g_rand_int_range(rand, 0, 4))
+    {
+        case 0:     return g_rand_int_range(rand, 1, 17);
+        case 1:     return g_rand_int_range(rand, 1, 17) * 16 + g_rand_int_range(rand, -1, 2);
+        default:    return g_rand_int_range(rand, 1, max + 1);
+    }
+}
+
+static void fill_random(GRand *rand, guint8 *data, gsize size)
+{
+    for (gsize i = 0; i < size; i++) {
+        data[i] = (guint8)g_rand_int(rand);
+    }
+}
+
+/* One buffer holding the planes in the order of 'format', every row is
+ * padded with random bytes which must never show in the output. */
+static void make_picture(GRand *rand, struct Picture *pic, YUV_FORMAT format,
+                        gint width, gint height)
+{
+    NX_YUV_PLANES *p = &pic->planes;
+    gint cw = (width + 1) / 2;
+    gint ch = (height + 1) / 2;
+    gint y_stride = width + g_rand_int_range(rand, 0, MAX_PAD + 1);
+    gint c_stride = (format >= YUV_NV12 ? cw * 2 : cw) + g_rand_int_range(rand, 0, MAX_PAD + 1);
+    gsize y_size = (gsize)y_stride * height;
+    gsize c_size = (gsize)c_stride * ch;
+    gsize size = y_size + ((format >= YUV_NV12) ? c_size : c_size * 2);
+
+    memset(p, 0, sizeof(*p));
+    pic->data = (guint8 *)g_malloc(size);
+    fill_random(rand, pic->data, size);
+
+    p->width = width;
+    p->height = height;
+    p->y = pic->data;
+    p->y_stride = y_stride;
+    p->u_stride = c_stride;
+    switch (format)
+    {
+        case YUV_I420:
+            p->u = pic->data + y_size;
+            p->v = p->u + c_size;
+            p->v_stride = c_stride;
+            break;
+        case YUV_YV12:
+            p->v = pic->data + y_size;
+            p->u = p->v + c_size;
+            p->v_stride = c_stride;
+            break;
+        case YUV_NV12:
+        case YUV_NV21:
+            p->u = pic->data + y_size;
+            p->swap_uv = (YUV_NV21 == format);
+            break;
+        default:
+            break;
+    }
+}
+
+static gboolean check_scale(GRand *rand, const struct Picture *pic, YUV_FORMAT format)
+{
+    const NX_YUV_PLANES *p = &pic->planes;
+    gint dst_width, dst_height;
+    gboolean ok = TRUE;
+
+    // Downscaled mostly, the same size and upscaled now and then
+    switch (g_rand_int_range(rand, 0, 8))
+    {
+        case 0:
+            dst_width = p->width;
+            dst_height = p->height;
+            break;
+        case 1:
+            dst_width = p->width + g_rand_int_range(rand, 1, 9);
+            dst_height = p->height + g_rand_int_range(rand, 1, 9);
+            break;
+        default:
+            dst_width = g_rand_int_range(rand, 1, p->width + 1);
+            dst_height = g_rand_int_range(rand, 1, p->height + 1);
+            break;
+    }
+
+    for (gint f = NX_RGB_FORMAT_RGB888; f <= NX_RGB_FORMAT_ARGB8888; f++)
+    {
+        gint bpp = NX_RGBBytesPerPixel((NX_RGB_FORMAT)f);
+        gint stride = dst_width * bpp + g_rand_int_range(rand, 0, MAX_PAD + 1);
+        gsize size = (gsize)stride * dst_height;
+        guint8 *ref = (guint8 *)g_malloc(size);
+        guint8 *out = (guint8 *)g_malloc(size);
+
+        memset(ref, GUARD_BYTE, size);
+        memset(out, GUARD_BYTE, size);
+        NX_ScaleYUVToRGB_C(p, ref, stride, dst_width, dst_height, (NX_RGB_FORMAT)f);
+        NX_ScaleYUVToRGB(p, out, stride, dst_width, dst_height, (NX_RGB_FORMAT)f);
+
+        for (gsize i = 0; i < size; i++)
+        {
+            if (ref[i] != out[i])
+            {
+                fprintf(stderr, "NX_ScaleYUVToRGB %s %dx%d (%d,%d,%d) -> %s %dx%d (%d): "
+                        "byte %" G_GSIZE_FORMAT " of row %" G_GSIZE_FORMAT " is %u, expected %u\n",
+                        yuv_format_name[format], p->width, p->height,
+                        p->y_stride, p->u_stride, p->v_stride,
+                        rgb_format_name[f], dst_width, dst_height, stride,
+                        i % stride, i / stride, out[i], ref[i]);
+                ok = FALSE;
+                break;
+            }
+        }
+
+        g_free(ref);
+        g_free(out);
+    }
+
+    return ok;
+}
+
+static gboolean check_luma(GRand *rand, const struct Picture *pic, const struct Picture *prev)
+{
+    const NX_YUV_PLANES *p = &pic->planes;
+    gint row_step = g_rand_int_range(rand, 1, 5);
+    guint ref_mean, ref_variance, mean, variance;
+    NX_LUMA_FEATURES ref, out;
+    gboolean ok = TRUE;
+
+    NX_LumaStats_C(p->y, p->y_stride, p->width, p->height, row_step, &ref_mean, &ref_variance);
+    NX_LumaStats(p->y, p->y_stride, p->width, p->height, row_step, &mean, &variance);
+    if (ref_mean != mean || ref_variance != variance)
+    {
+        fprintf(stderr, "NX_LumaStats %dx%d (%d) step %d: mean/variance %u/%u, expected %u/%u\n",
+                p->width, p->height, p->y_stride, row_step, mean, variance,
+                ref_mean, ref_variance);
+        ok = FALSE;
+    }
+
+    // Without a previous frame and with one of another stride
+    for (gint i = 0; i < 2; i++)
+    {
+        const guint8 *prev_y = i ? prev->planes.y : NULL;
+        gint prev_stride = i ? prev->planes.y_stride : 0;
+
+        NX_LumaFeatures_C(p->y, p->y_stride, prev_y, prev_stride,
+                        p->width, p->height, row_step, &ref);
+        NX_LumaFeatures(p->y, p->y_stride, prev_y, prev_stride,
+                        p->width, p->height, row_step, &out);
+        if (memcmp(&ref, &out, sizeof(ref)))
+        {
+            fprintf(stderr, "NX_LumaFeatures %dx%d (%d) step %d prev %s: "
+                    "%u/%u/%u/%u/%d, expected %u/%u/%u/%u/%d\n",
+                    p->width, p->height, p->y_stride, row_step, i ? "yes" : "no",
+                    out.mean, out.variance, out.edges, out.spread, out.difference,
+                    ref.mean, ref.variance, ref.edges, ref.spread, ref.difference);
+            ok = FALSE;
+        }
+    }
+
+    return ok;
+}
+
+static gint run_kernels(const char *name, guint32 seed, gint pictures)
+{
+    GRand *rand;
+    gint failures = 0;
+
+    g_setenv("NX_GST_SIMD", name, TRUE);
+    if (strcmp(NX_GetColorKernels(), name))
+    {
+        printf("%s: not available, skipped\n", name);
+        return EXIT_SKIP;
+    }
+
+    rand = g_rand_new_with_seed(seed);
+    for (gint n = 0; n < pictures; n++)
+    {
+        YUV_FORMAT format = (YUV_FORMAT)(n % YUV_FORMAT_NUM);
+        gint width = random_size(rand, MAX_WIDTH);
+        gint height = random_size(rand, MAX_HEIGHT);
+        struct Picture pic, prev;
+
+        make_picture(rand, &pic, format, width, height);
+        // Same size, but its own strides
+        make_picture(rand, &prev, YUV_NV12, width, height);
+
+        if (!check_scale(rand, &pic, format))
+            failures++;
+        if (!check_luma(rand, &pic, &prev))
+            failures++;
+
+        g_free(pic.data);
+        g_free(prev.data);
+    }
+    g_rand_free(rand);
+
+    printf("%s: %d pictures, %d failures\n", name, pictures, failures);
+
+    return (failures > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int main(int argc, char *argv[])
+{
+    // The kernels are picked once per process, so each set runs in a child
+    static const char *kernels[] = { "NEON", "SSE2", "AVX2" };
+    guint32 seed = (argc > 1) ? (guint32)strtoul(argv[1], NULL, 0) : g_random_int();
+    gint pictures = (argc > 2) ? atoi(argv[2]) : DEFAULT_PICTURES;
+    gint tested = 0, failed = 0;
+
+    printf("seed %u\n", seed);
+    fflush(stdout);
+
+    for (guint i = 0; i < G_N_ELEMENTS(kernels); i++)
+    {
+        gint status;
+        pid_t pid = fork();
+
+        if (pid < 0)
+        {
+            perror("fork");
+            return EXIT_FAILURE;
+        }
+        if (0 == pid)
+        {
+            gint ret = run_kernels(kernels[i], seed, pictures);
+            fflush(stdout);
+            _exit(ret);
+        }
+
+        if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status))
+        {
+            fprintf(stderr, "%s: crashed\n", kernels[i]);
+            failed++;
+            continue;
+        }
+        if (EXIT_SKIP == WEXITSTATUS(status))
+            continue;
+        tested++;
+        if (EXIT_SUCCESS != WEXITSTATUS(status))
+            failed++;
+    }
+
+    if (failed > 0)
+        return EXIT_FAILURE;
+
+    return (tested > 0) ? EXIT_SUCCESS : EXIT_SKIP;
+}
@@ -0,0 +1,192 @@
+//------------------------------------------------------------------------------
+//
+//	Copyright (C) 2015 Nexell Co. All Rights Reserved
+//	Nexell Co. Proprietary & Confidential
+//
+//	NEXELL INFORMS THAT THIS CODE AND INFORMATION IS PROVIDED "AS IS" BASE
+//  AND	WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING
+//  BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS
+//  FOR A PARTICULAR PURPOSE.
+//
+//	Module		: libnxgstvplayer.so
+//	File		: NX_GstStressTest.cpp
+//	Description	: Runs several MP_HANDLEs on one file concurrently
+//	Author		:
+//	Export		:
+//	History		:
+//
+//------------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "NX_GstIface.h"
+
+// automake treats this exit status as a skipped test
+#define EXIT_SKIP               77
+
+#define DEFAULT_HANDLES         4
+#define DEFAULT_CYCLES          8
+// Number of display mode/seek/mute steps in each open-close cycle
+#define STEPS_PER_CYCLE         6
+#define STEP_USEC               (200 * 1000)
+
+struct StressContext {
+    const char  *uri;
+    gint        index;
+    gint        cycles;
+    guint       seed;
+    gint        failures;
+};
+
+/* The library calls back with a NULL owner (cbOwner is not forwarded), so
+ * the events of all the handles are counted together. */
+static volatile gint total_events;
+static volatile gint total_errors;
+static volatile gint total_eos;
+
+static void stress_callback(void *owner, unsigned int msg,
+                        unsigned int data, void *param)
+{
+    (void)owner;
+    (void)data;
+
+    g_atomic_int_inc(&total_events);
+    switch (msg)
+    {
+        case MP_EVENT_EOS:
+            g_atomic_int_inc(&total_eos);
+            break;
+        case MP_EVENT_DEMUX_LINK_FAILED:
+        case MP_EVENT_NOT_SUPPORTED:
+        case MP_EVENT_GST_ERROR:
+        case MP_EVENT_ERR_OPEN_AUDIO_DEVICE:
+            g_atomic_int_inc(&total_errors);
+            break;
+        case MP_EVENT_FRAME_CAPTURED:
+            NX_GSTMP_ReleaseCapturedFrame((struct CAPTURE_FRAME *)param);
+            break;
+        default:
+            break;
+    }
+}
+
+static gboolean run_cycle(struct StressContext *ctx)
+{
+    static const enum DISPLAY_MODE modes[] = {
+        DISPLAY_MODE_LCD_ONLY, DISPLAY_MODE_LCD_HDMI,
+        DISPLAY_MODE_HDMI_ONLY, DISPLAY_MODE_NONE
+    };
+    MP_HANDLE handle = NULL;
+    gboolean ok = FALSE;
+    int64_t duration_msec;
+
+    if (NX_GST_RET_OK != NX_GSTMP_Open(&handle, stress_callback, ctx))
+    {
+        fprintf(stderr, "[%d] Failed to open the handle\n", ctx->index);
+        return FALSE;
+    }
+
+    if (NX_GST_RET_OK != NX_GSTMP_SetUri(handle, ctx->uri) ||
+        NX_GST_RET_OK != NX_GSTMP_Prepare(handle) ||
+        NX_GST_RET_OK != NX_GSTMP_Play(handle))
+    {
+        fprintf(stderr, "[%d] Failed to start playback\n", ctx->index);
+        goto done;
+    }
+
+    duration_msec = NX_GSTMP_GetDuration(handle) / (1000 * 1000);
+    for (gint step = 0; step < STEPS_PER_CYCLE; step++)
+    {
+        enum DISPLAY_MODE mode = modes[rand_r(&ctx->seed) % G_N_ELEMENTS(modes)];
+
+        if (NX_GST_RET_OK != NX_GSTMP_SetDisplayMode(handle, mode))
+        {
+            fprintf(stderr, "[%d] Failed to set the display mode(%d)\n", ctx->index, mode);
+            goto done;
+        }
+        if (duration_msec > 0 &&
+            NX_GST_RET_OK != NX_GSTMP_Seek(handle, rand_r(&ctx->seed) % duration_msec))
+        {
+            fprintf(stderr, "[%d] Failed to seek\n", ctx->index);
+            goto done;
+        }
+        // Not checked, muting may be refused while no display is set
+        NX_GSTMP_VideoMute(handle, step & 1);
+        usleep(STEP_USEC);
+    }
+    ok = TRUE;
+
+done:
+    NX_GSTMP_Close(handle);
+    return ok;
+}
+
+static void *stress_thread(void *arg)
+{
+    struct StressContext *ctx = (struct StressContext *)arg;
+
+    for (gint i = 0; i < ctx->cycles; i++)
+    {
+        if (!run_cycle(ctx))
+            ctx->failures++;
+    }
+
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *uri = (argc > 1) ? argv[1] : getenv("NX_GST_TEST_SAMPLE");
+    gint handles = (argc > 2) ? atoi(argv[2]) : DEFAULT_HANDLES;
+    gint cycles = (argc > 3) ? atoi(argv[3]) : DEFAULT_CYCLES;
+    struct StressContext *ctx;
+    pthread_t *threads;
+    gint failures = 0;
+
+    if (NULL == uri)
+    {
+        fprintf(stderr, "Usage: %s <file> [handles] [cycles]\n"
+                "  or set NX_GST_TEST_SAMPLE to the file to play\n", argv[0]);
+        return EXIT_SKIP;
+    }
+    if (handles <= 0 || cycles <= 0)
+    {
+        fprintf(stderr, "Invalid handles(%d) or cycles(%d)\n", handles, cycles);
+        return EXIT_FAILURE;
+    }
+
+    ctx = g_new0(struct StressContext, handles);
+    threads = g_new0(pthread_t, handles);
+
+    for (gint i = 0; i < handles; i++)
+    {
+        ctx[i].uri = uri;
+        ctx[i].index = i;
+        ctx[i].cycles = cycles;
+        ctx[i].seed = (guint)i + 1;
+        pthread_create(&threads[i], NULL, stress_thread, &ctx[i]);
+    }
+
+    for (gint i = 0; i < handles; i++)
+    {
+        pthread_join(threads[i], NULL);
+        printf("[%d] cycles(%d) failures(%d)\n", i, cycles, ctx[i].failures);
+        failures += ctx[i].failures;
+    }
+    printf("events(%d) eos(%d) errors(%d)\n",
+            g_atomic_int_get(&total_events), g_atomic_int_get(&total_eos),
+            g_atomic_int_get(&total_errors));
+    failures += g_atomic_int_get(&total_errors);
+
+    g_free(threads);
+    g_free(ctx);
+
+    return (failures > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}